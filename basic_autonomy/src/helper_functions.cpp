@@ -64,9 +64,11 @@ namespace waypoint_generation
 
     int get_nearest_index_by_downtrack(const std::vector<lanelet::BasicPoint2d>& points, const carma_wm::WorldModelConstPtr& wm, double target_downtrack)
     {
+        // The points are ordered along the route so the batch query is cheaper than one query per point
+        std::vector<carma_wm::TrackPos> track_positions = wm->routeTrackPos(points);
         int best_index = points.size() - 1;
         for(int i = 0;i < points.size(); i++){
-            double downtrack = wm->routeTrackPos(points[i]).downtrack;
+            double downtrack = track_positions[i].downtrack;
             if(downtrack > target_downtrack){
                 //If value is negative, best index should be index 0
                 best_index = std::max(0, i - 1);
@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+/**
+ * Benchmark of the carma_wm world model hot paths on synthetic multi-lane maps.
+ *
+ * Usage: carma_wm_bench [lanes] [length_km] [iterations]
+ *
+ * The generated road has the requested number of parallel lanes following a gently curving centerline.
+ * The route starts in the leftmost lane and ends in the rightmost lane so it contains lane changes.
+ * For each query the latency percentiles and the mean number of heap allocations per call are reported.
+ */
+
+#include <carma_wm/CARMAWorldModel.h>
+#include <carma_wm/IndexedDistanceMap.h>
+#include <carma_wm/Geometry.h>
+#include <carma_wm/LineStringIndex.h>
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_routing/Route.h>
+#include <lanelet2_routing/RoutingGraph.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+std::atomic<size_t> allocation_count(0);
+}
+
+// Count all heap allocations made through operator new. Eigen aligned allocations bypass this and are not counted
+void* operator new(std::size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (!ptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace carma_wm
+{
+namespace bench
+{
+struct SyntheticMapConfig
+{
+  size_t lanes = 3;
+  double length = 10000.0;         // Road length in meters
+  double lane_width = 3.7;         // Lane width in meters
+  double lanelet_length = 50.0;    // Length of each lanelet in meters
+  double point_spacing = 5.0;      // Distance between bound points in meters
+  double curve_amplitude = 0.3;    // Peak heading change of the road in radians
+  double curve_period = 2000.0;    // Distance over which the road heading completes one oscillation in meters
+};
+
+struct BenchResult
+{
+  std::string name;
+  std::vector<double> latencies_us;
+  size_t allocations = 0;
+};
+
+lanelet::Lanelet makeLanelet(lanelet::LineString3d& left_ls, lanelet::LineString3d& right_ls,
+                             const lanelet::Attribute& left_sub_type, const lanelet::Attribute& right_sub_type)
+{
+  left_ls.attributes()[lanelet::AttributeName::Type] = lanelet::AttributeValueString::LineThin;
+  left_ls.attributes()[lanelet::AttributeName::Subtype] = left_sub_type;
+
+  right_ls.attributes()[lanelet::AttributeName::Type] = lanelet::AttributeValueString::LineThin;
+  right_ls.attributes()[lanelet::AttributeName::Subtype] = right_sub_type;
+
+  lanelet::Lanelet ll(lanelet::utils::getId(), left_ls, right_ls);
+
+  ll.attributes()[lanelet::AttributeName::Type] = lanelet::AttributeValueString::Lanelet;
+  ll.attributes()[lanelet::AttributeName::Subtype] = lanelet::AttributeValueString::Road;
+  ll.attributes()[lanelet::AttributeName::Location] = lanelet::AttributeValueString::Urban;
+  ll.attributes()[lanelet::AttributeName::OneWay] = "yes";
+  ll.attributes()[lanelet::AttributeName::Dynamic] = "no";
+
+  return ll;
+}
+
+/**
+ * Builds a map of config.lanes parallel lanes. Lanes are ordered from left to right in the direction of travel.
+ * lanes_out[lane][i] is the i'th lanelet of a lane.
+ */
+lanelet::LaneletMapPtr buildSyntheticMap(const SyntheticMapConfig& config,
+                                         std::vector<std::vector<lanelet::Lanelet>>& lanes_out)
+{
+  // Sample the road centerline by integrating a sinusoidal heading
+  size_t samples = static_cast<size_t>(std::ceil(config.length / config.point_spacing)) + 1;
+  std::vector<lanelet::BasicPoint2d> centers, normals;
+  centers.reserve(samples);
+  normals.reserve(samples);
+  double x = 0, y = 0;
+  for (size_t i = 0; i < samples; i++)
+  {
+    double heading = config.curve_amplitude * std::sin(2.0 * M_PI * i * config.point_spacing / config.curve_period);
+    centers.emplace_back(x, y);
+    normals.emplace_back(-std::sin(heading), std::cos(heading));
+    x += config.point_spacing * std::cos(heading);
+    y += config.point_spacing * std::sin(heading);
+  }
+
+  // Points of each lane boundary. Boundary 0 is the leftmost
+  std::vector<std::vector<lanelet::Point3d>> boundary_points(config.lanes + 1);
+  for (size_t b = 0; b <= config.lanes; b++)
+  {
+    double offset = (config.lanes / 2.0 - b) * config.lane_width;
+    boundary_points[b].reserve(samples);
+    for (size_t i = 0; i < samples; i++)
+    {
+      lanelet::BasicPoint2d p = centers[i] + offset * normals[i];
+      boundary_points[b].emplace_back(lanelet::utils::getId(), p.x(), p.y(), 0.0);
+    }
+  }
+
+  size_t points_per_lanelet = std::max<size_t>(1, std::lround(config.lanelet_length / config.point_spacing));
+  lanes_out.assign(config.lanes, {});
+  lanelet::Lanelets all_lanelets;
+
+  for (size_t start = 0; start + 1 < samples; start += points_per_lanelet)
+  {
+    size_t end = std::min(start + points_per_lanelet, samples - 1);
+
+    std::vector<lanelet::LineString3d> bounds;
+    for (size_t b = 0; b <= config.lanes; b++)
+    {
+      bounds.emplace_back(lanelet::utils::getId(),
+                          lanelet::Points3d(boundary_points[b].begin() + start, boundary_points[b].begin() + end + 1));
+    }
+
+    for (size_t lane = 0; lane < config.lanes; lane++)
+    {
+      const lanelet::Attribute& left_sub_type =
+          lane == 0 ? lanelet::AttributeValueString::SolidSolid : lanelet::AttributeValueString::Dashed;
+      const lanelet::Attribute& right_sub_type =
+          lane + 1 == config.lanes ? lanelet::AttributeValueString::Solid : lanelet::AttributeValueString::Dashed;
+
+      auto ll = makeLanelet(bounds[lane], bounds[lane + 1], left_sub_type, right_sub_type);
+      lanes_out[lane].push_back(ll);
+      all_lanelets.push_back(ll);
+    }
+  }
+
+  return lanelet::utils::createMap(all_lanelets, {});
+}
+
+double percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.empty())
+  {
+    return 0;
+  }
+  return sorted[static_cast<size_t>(std::round(p * (sorted.size() - 1)))];
+}
+
+BenchResult measure(const std::string& name, size_t iterations, const std::function<void(size_t)>& func)
+{
+  BenchResult result;
+  result.name = name;
+  result.latencies_us.reserve(iterations);
+
+  for (size_t i = 0; i < iterations; i++)
+  {
+    size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    func(i);
+    auto end = std::chrono::steady_clock::now();
+    result.allocations += allocation_count.load(std::memory_order_relaxed) - allocations_before;
+    result.latencies_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  return result;
+}
+
+void report(const BenchResult& result)
+{
+  std::vector<double> sorted = result.latencies_us;
+  std::sort(sorted.begin(), sorted.end());
+  double calls = std::max<size_t>(1, sorted.size());
+
+  std::printf("%-36s %8zu %12.2f %12.2f %12.2f %12.2f %12.1f\n", result.name.c_str(), sorted.size(),
+              percentile(sorted, 0.5), percentile(sorted, 0.9), percentile(sorted, 0.99),
+              sorted.empty() ? 0.0 : sorted.back(), result.allocations / calls);
+}
+
+cav_msgs::ExternalObject makeObject(uint32_t id, const lanelet::BasicPoint2d& position)
+{
+  cav_msgs::ExternalObject obj;
+  obj.id = id;
+  obj.pose.pose.position.x = position.x();
+  obj.pose.pose.position.y = position.y();
+  obj.pose.pose.orientation.w = 1.0;
+  obj.size.x = 2.5;
+  obj.size.y = 1.0;
+  obj.size.z = 1.0;
+  return obj;
+}
+
+}  // namespace bench
+}  // namespace carma_wm
+
+int main(int argc, char** argv)
+{
+  using namespace carma_wm;
+  using namespace carma_wm::bench;
+
+  SyntheticMapConfig config;
+  size_t iterations = 1000;
+  if (argc > 1)
+    config.lanes = std::max(1, std::atoi(argv[1]));
+  if (argc > 2)
+    config.length = std::max(0.1, std::atof(argv[2])) * 1000.0;
+  if (argc > 3)
+    iterations = std::max(1, std::atoi(argv[3]));
+
+  size_t heavy_iterations = std::max<size_t>(1, std::min<size_t>(iterations, 5));
+
+  std::printf("carma_wm_bench: %zu lanes x %.1f km, %zu iterations\n\n", config.lanes, config.length / 1000.0,
+              iterations);
+
+  std::vector<std::vector<lanelet::Lanelet>> lanes;
+  lanelet::LaneletMapPtr map = buildSyntheticMap(config, lanes);
+
+  std::mt19937 rng(0);  // Fixed seed so runs are comparable
+  std::vector<BenchResult> results;
+
+  CARMAWorldModel cmw;
+  cmw.setConfigSpeedLimit(35.0);
+
+  results.push_back(measure("setMap", heavy_iterations, [&](size_t) { cmw.setMap(map); }));
+
+  // Route from the leftmost lane start to the rightmost lane end which requires lane changes
+  auto route_opt = cmw.getMapRoutingGraph()->getRoute(lanes.front().front(), lanes.back().back());
+  if (!route_opt)
+  {
+    std::fprintf(stderr, "Failed to generate route on synthetic map\n");
+    return 1;
+  }
+  LaneletRoutePtr route = std::make_shared<lanelet::routing::Route>(std::move(route_opt.get()));
+
+  results.push_back(measure("setRoute", heavy_iterations, [&](size_t) { cmw.setRoute(route); }));
+
+  double route_length = cmw.getRouteEndTrackPos().downtrack;
+  std::uniform_real_distribution<double> downtrack_dist(0.0, std::max(0.0, route_length - 200.0));
+  std::uniform_real_distribution<double> lateral_dist(-1.5, 1.5);
+
+  // Query points near the route reference line
+  std::vector<lanelet::BasicPoint2d> query_points;
+  query_points.reserve(iterations);
+  for (size_t i = 0; i < iterations; i++)
+  {
+    auto point = cmw.pointFromRouteTrackPos(TrackPos(downtrack_dist(rng), lateral_dist(rng)));
+    query_points.push_back(point ? point.get() : lanelet::BasicPoint2d(0, 0));
+  }
+
+  std::vector<double> query_downtracks;
+  query_downtracks.reserve(iterations);
+  for (size_t i = 0; i < iterations; i++)
+  {
+    query_downtracks.push_back(downtrack_dist(rng));
+  }
+
+  results.push_back(measure("routeTrackPos(point)", iterations,
+                            [&](size_t i) { cmw.routeTrackPos(query_points[i]); }));
+
+  // Trajectory like batches of 100 points spaced 1 m apart
+  std::vector<std::vector<lanelet::BasicPoint2d>> trajectories;
+  for (size_t i = 0; i < std::min<size_t>(iterations, 100); i++)
+  {
+    trajectories.push_back(cmw.sampleRoutePoints(query_downtracks[i], query_downtracks[i] + 99.0, 1.0));
+  }
+  results.push_back(measure("routeTrackPos(100 points)", trajectories.size(),
+                            [&](size_t i) { cmw.routeTrackPos(trajectories[i]); }));
+
+  results.push_back(measure("getLaneletsBetween(100 m)", iterations, [&](size_t i) {
+    cmw.getLaneletsBetween(query_downtracks[i], query_downtracks[i] + 100.0);
+  }));
+
+  results.push_back(measure("sampleRoutePoints(100 m, 1 m)", iterations, [&](size_t i) {
+    cmw.sampleRoutePoints(query_downtracks[i], query_downtracks[i] + 100.0, 1.0);
+  }));
+
+  std::vector<lanelet::BasicPoint2d> sample_buffer;
+  results.push_back(measure("sampleRoutePoints(buffer)", iterations, [&](size_t i) {
+    cmw.sampleRoutePoints(query_downtracks[i], query_downtracks[i] + 100.0, 1.0, sample_buffer);
+  }));
+
+  results.push_back(measure("getRouteSpeedLimit", iterations,
+                            [&](size_t i) { cmw.getRouteSpeedLimit(query_downtracks[i]); }));
+
+  // Roadway objects spread over the first 2 km of the route in all lanes
+  std::vector<cav_msgs::ExternalObject> objects;
+  std::uniform_real_distribution<double> object_downtrack_dist(0.0, std::min(route_length, 2000.0));
+  for (uint32_t id = 0; id < 60; id++)
+  {
+    auto point = cmw.pointFromRouteTrackPos(
+        TrackPos(object_downtrack_dist(rng), (static_cast<double>(id % config.lanes) - config.lanes / 2.0) * config.lane_width));
+    if (point)
+    {
+      objects.push_back(makeObject(id, point.get()));
+    }
+  }
+
+  if (objects.empty())
+  {
+    std::fprintf(stderr, "Failed to place roadway objects on synthetic map\n");
+    return 1;
+  }
+
+  results.push_back(measure("toRoadwayObstacle", iterations,
+                            [&](size_t i) { cmw.toRoadwayObstacle(objects[i % objects.size()]); }));
+  results.push_back(measure("toRoadwayObstacles(60)", heavy_iterations,
+                            [&](size_t) { cmw.toRoadwayObstacles(objects); }));
+  results.push_back(measure("toRoadwayObstacles(60, 4 threads)", heavy_iterations,
+                            [&](size_t) { cmw.toRoadwayObstacles(objects, 4); }));
+
+  std::vector<cav_msgs::RoadwayObstacle> roadway_objects;
+  for (const auto& obj : objects)
+  {
+    auto roadway_obj = cmw.toRoadwayObstacle(obj);
+    if (roadway_obj)
+    {
+      roadway_objects.push_back(roadway_obj.get());
+    }
+  }
+
+  results.push_back(measure("setRoadwayObjects(60)", heavy_iterations,
+                            [&](size_t) { cmw.setRoadwayObjects(roadway_objects); }));
+
+  std::uniform_int_distribution<size_t> lane_dist(0, config.lanes - 1);
+  std::uniform_int_distribution<size_t> lanelet_dist(0, std::min<size_t>(lanes.front().size(), 40) - 1);
+  std::vector<lanelet::ConstLanelet> query_lanelets;
+  for (size_t i = 0; i < iterations; i++)
+  {
+    query_lanelets.push_back(lanes[lane_dist(rng)][lanelet_dist(rng)]);
+  }
+  results.push_back(measure("getInLaneObjects(LANE_AHEAD)", iterations,
+                            [&](size_t i) { cmw.getInLaneObjects(query_lanelets[i]); }));
+
+  // IndexedDistanceMap over a 50 km line with 1 m point spacing split into 50 m elements
+  IndexedDistanceMap distance_map;
+  for (size_t element = 0; element < 1000; element++)
+  {
+    lanelet::Points3d points;
+    for (size_t i = 0; i <= 50; i++)
+    {
+      points.emplace_back(lanelet::utils::getId(), element * 50.0 + i, 0.0, 0.0);
+    }
+    distance_map.pushBack(lanelet::utils::to2D(lanelet::LineString3d(lanelet::utils::getId(), points)));
+  }
+  std::uniform_real_distribution<double> distance_dist(0.0, distance_map.totalLength());
+  std::vector<double> query_distances;
+  for (size_t i = 0; i < iterations; i++)
+  {
+    query_distances.push_back(distance_dist(rng));
+  }
+  results.push_back(measure("IndexedDistanceMap lookup (50 km)", iterations, [&](size_t i) {
+    size_t element = distance_map.getElementIndexByDistance(query_distances[i]);
+    distance_map.getPointIndexByDistance(element, query_distances[i] - distance_map.distanceToElement(element));
+  }));
+
+  // Centerline geometry of the 100 point trajectories, as computed by the tactical plugins each planning cycle
+  results.push_back(measure("geometry vectors (100 points)", trajectories.size(), [&](size_t i) {
+    geometry::compute_arc_lengths(trajectories[i]);
+    geometry::compute_tangent_orientations(trajectories[i]);
+    geometry::local_curvatures(trajectories[i]);
+  }));
+
+  std::vector<double> arc_lengths(100), orientations(100), curvatures(100);
+  results.push_back(measure("geometry fused (100 points)", trajectories.size(), [&](size_t i) {
+    auto view = geometry::makePointArrayView(trajectories[i]);
+    arc_lengths.resize(view.size);
+    orientations.resize(view.size);
+    curvatures.resize(view.size);
+    geometry::compute_centerline_geometry(view, arc_lengths.data(), orientations.data(), curvatures.data());
+  }));
+
+  // Frenet transform of the 100 point trajectories against the centerline of the leftmost lane
+  lanelet::BasicLineString2d reference_line =
+      geometry::concatenate_lanelets(std::vector<lanelet::ConstLanelet>(lanes.front().begin(), lanes.front().end()));
+  results.push_back(measure("matchSegment (100 points)", trajectories.size(), [&](size_t i) {
+    for (const auto& point : trajectories[i])
+    {
+      geometry::matchSegment(point, reference_line);
+    }
+  }));
+  std::vector<TrackPos> track_positions;
+  track_positions.reserve(100);
+  results.push_back(measure("batch trackPos (100 points)", trajectories.size(), [&](size_t i) {
+    geometry::trackPos(reference_line, trajectories[i], track_positions);
+  }));
+  geometry::LineStringIndex reference_index(reference_line);
+  results.push_back(measure("LineStringIndex (100 points)", trajectories.size(), [&](size_t i) {
+    for (const auto& point : trajectories[i])
+    {
+      reference_index.matchSegment(point);
+    }
+  }));
+  results.push_back(measure("LineStringIndex batch (100 points)", trajectories.size(), [&](size_t i) {
+    reference_index.trackPos(trajectories[i], track_positions);
+  }));
+
+  std::printf("%-36s %8s %12s %12s %12s %12s %12s\n", "query", "calls", "p50 (us)", "p90 (us)", "p99 (us)",
+              "max (us)", "allocs/call");
+  for (const auto& result : results)
+  {
+    report(result);
+  }
+
+  return 0;
+}
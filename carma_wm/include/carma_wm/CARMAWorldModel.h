@@ -21,11 +21,14 @@
 #include <lanelet2_extension/traffic_rules/CarmaUSTrafficRules.h>
 #include <lanelet2_core/primitives/LineString.h>
 #include "IndexedDistanceMap.h"
+#include "LaneletSpatialIndex.h"
+#include "LineStringIndex.h"
 #include <cav_msgs/ExternalObject.h>
 #include <cav_msgs/ExternalObjectList.h>
 #include <cav_msgs/RoadwayObstacle.h>
 #include <cav_msgs/RoadwayObstacleList.h>
 #include "TrackPos.h"
+#include <unordered_map>
 
 namespace carma_wm
 {
@@ -58,8 +61,10 @@ public:
    *
    *  \param map A shared pointer to the map which will share ownership to this object
    *  \param map_version Optional field to set the map version. While this is technically optional its uses is highly advised to manage synchronization.
+   *  \param recompute_routing_graph Optional flag. If false the existing routing graph is kept. This must only be used when
+   *         map is the current map and the passability, lane change relations and speed limits of its lanelets have not changed since the graph was built.
    */
-  void setMap(lanelet::LaneletMapPtr map, size_t map_version = 0);
+  void setMap(lanelet::LaneletMapPtr map, size_t map_version = 0, bool recompute_routing_graph = true);
 
   /*! \brief Set the current route. This route must match the current map for this class to function properly
    *
@@ -70,6 +75,7 @@ public:
   /*! \brief Get a mutable version of the current map
    * 
    *  NOTE: the user must make sure to setMap() after any edit to the map and to set a valid route
+   *  The cached lanelet geometry is not used again until setMap() rebuilds it or updateLaneletIndex() is called
    */
   lanelet::LaneletMapPtr getMutableMap() const;
 
@@ -101,6 +107,26 @@ public:
 *
 */
   void setConfigSpeedLimit(double config_lim);
+
+  /*! \brief Recompute the cached speed limits of lanelets whose regulations were edited in place on the current map.
+   *         This only needs to be called when setMap() was called with recompute_routing_graph set to false, 
+   *         otherwise setMap() recomputes all speed limits.
+   *
+   *  \param lanelet_ids The ids of the edited lanelets. Ids which are not in the map are ignored
+   */
+  void updateSpeedLimits(const std::vector<lanelet::Id>& lanelet_ids);
+
+  /*! \brief Reindex the bounding boxes and cached geometry of lanelets which were added, removed or edited in place on
+   *         the current map.
+   *         This only needs to be called when setMap() was called with recompute_routing_graph set to false,
+   *         otherwise setMap() rebuilds the index of every lanelet.
+   *
+   *         The caller must provide every lanelet which changed since the map was last set or reindexed, as the cached
+   *         geometry of every lanelet is used again afterwards.
+   *
+   *  \param lanelet_ids The ids of the edited lanelets. Ids which are no longer in the map are removed from the index
+   */
+  void updateLaneletIndex(const std::vector<lanelet::Id>& lanelet_ids);
   
   /*! \brief Set endpoint of the route
    */
@@ -113,12 +139,22 @@ public:
 
   TrackPos routeTrackPos(const lanelet::ConstLanelet& lanelet) const override;
 
+  lanelet::Optional<std::pair<TrackPos, TrackPos>> getRouteLaneletTrackPos(lanelet::Id lanelet_id) const override;
+
   TrackPos routeTrackPos(const lanelet::BasicPoint2d& point) const override;
 
+  std::vector<TrackPos> routeTrackPos(const std::vector<lanelet::BasicPoint2d>& points) const override;
+
   std::vector<lanelet::ConstLanelet> getLaneletsBetween(double start, double end, bool shortest_path_only = false,  bool bounds_inclusive = true) const override;
 
   std::vector<lanelet::BasicPoint2d> sampleRoutePoints(double start_downtrack, double end_downtrack, double step_size) const override;
 
+  void sampleRoutePoints(double start_downtrack, double end_downtrack, double step_size,
+                         std::vector<lanelet::BasicPoint2d>& output) const override;
+
+  void sampleRouteProfile(double start_downtrack, double end_downtrack, double step_size,
+                          std::vector<RouteProfileSample>& output) const override;
+
   boost::optional<lanelet::BasicPoint2d> pointFromRouteTrackPos(const TrackPos& route_pos) const override;
 
   lanelet::LaneletMapConstPtr getMap() const override;
@@ -132,6 +168,10 @@ public:
   lanelet::Optional<TrafficRulesConstPtr>
   getTrafficRules(const std::string& participant = lanelet::Participants::Vehicle) const override;
 
+  double getSpeedLimit(const lanelet::ConstLanelet& lanelet) const override;
+
+  double getRouteSpeedLimit(double downtrack) const override;
+
   std::vector<cav_msgs::RoadwayObstacle> getRoadwayObjects() const override;
 
   std::vector<cav_msgs::RoadwayObstacle> getInLaneObjects(const lanelet::ConstLanelet& lanelet, const LaneSection& section = LANE_AHEAD) const override;
@@ -140,6 +180,13 @@ public:
 
   lanelet::Optional<cav_msgs::RoadwayObstacle> toRoadwayObstacle(const cav_msgs::ExternalObject& object) const override;
 
+  std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+  toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects, unsigned int thread_count = 1) const override;
+
+  std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+  toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects, const std::vector<lanelet::Id>& lanelet_hints,
+                     unsigned int thread_count = 1) const override;
+
   lanelet::Optional<double> distToNearestObjInLane(const lanelet::BasicPoint2d& object_center) const override;
 
   lanelet::Optional<std::tuple<TrackPos,cav_msgs::RoadwayObstacle>> nearestObjectAheadInLane(const lanelet::BasicPoint2d& object_center) const override;
@@ -161,11 +208,73 @@ private:
    *         This function should generally only be called from inside the setRoute function as it uses member variables
    * set in that function
    *
-   *  Sets the shortest_path_centerlines_, shortest_path_centerlines_lengths_, and
-   * shortest_path_filtered_centerline_view_ member variables
+   *  Sets the shortest_path_centerlines_, shortest_path_centerlines_lengths_,
+   * shortest_path_filtered_centerline_view_ and route_profile_points_ member variables
    */
   void computeDowntrackReferenceLine();
 
+  /*! \brief Helper function to compute the headings and curvatures of route_profile_points_ from
+   *         shortest_path_centerline_points_. This function should only be called from computeDowntrackReferenceLine
+   */
+  void computeRouteProfileGeometry();
+
+  /*! \brief Helper function to build the downtrack interval index of all lanelets in the route.
+   *         This function should generally only be called from inside the setRoute function after the reference line
+   *         has been computed
+   *
+   *  Sets the route_lanelet_intervals_, max_route_lanelet_interval_length_ and route_lanelet_track_pos_ member variables
+   */
+  void computeRouteLaneletIntervals();
+
+  /*! \brief Helper function to compute the data used to walk a cursor along the route reference line in the batch
+   *         routeTrackPos method. This function should only be called from computeDowntrackReferenceLine
+   *
+   *  Sets the shortest_path_centerline_points_ and shortest_path_point_clearances_ member variables
+   */
+  void computeRouteCursorClearances();
+
+  /*! \brief Helper function which moves a route cursor from its current reference line point to the reference line
+   *         point nearest the provided point.
+   *
+   *  \param point The point to move the cursor towards
+   *  \param ls_i The index of the continuous reference line the cursor is on. Updated in place
+   *  \param p_i The index of the point on the reference line the cursor is on. Updated in place
+   *
+   *  \return True if the final cursor location is guaranteed to be the reference line point nearest the provided
+   *  point. False if a full nearest point search is required
+   */
+  bool advanceRouteCursor(const lanelet::BasicPoint2d& point, size_t& ls_i, size_t& p_i) const;
+
+  /*! \brief Helper function to compute the route TrackPos of a point once the nearest reference line point is known
+   *
+   *  \param point The point to compute the TrackPos of
+   *  \param ls_i The index of the continuous reference line containing the nearest point
+   *  \param p_i The index of the nearest point on that reference line
+   *
+   *  \return The TrackPos of the point
+   */
+  TrackPos routeTrackPosFromNearestPoint(const lanelet::BasicPoint2d& point, size_t ls_i, size_t p_i) const;
+
+  /*! \brief Helper function to linearly interpolate a point on a continuous section of the route reference line
+   *
+   *  \param ls_i The index of the continuous reference line
+   *  \param prior_idx The index of the reference line point at or immediately before the target downtrack
+   *  \param relative_downtrack The target downtrack measured from the start of the continuous reference line
+   *
+   *  \return The interpolated x,y point
+   */
+  lanelet::BasicPoint2d interpolateReferenceLine(size_t ls_i, size_t prior_idx, double relative_downtrack) const;
+
+  /*! \brief Helper function to advance a position on the route reference line forward to the given downtrack
+   *
+   *  \param downtrack The target route downtrack. Must not be less than the downtrack of the current position
+   *  \param ls_i The index of the continuous reference line. Updated to the last one starting at or before the downtrack
+   *  \param p_i The index of the reference line point. Updated to the last point at or before the downtrack
+   *
+   *  \return The target downtrack measured from the start of the continuous reference line ls_i
+   */
+  double advanceReferenceLine(double downtrack, size_t& ls_i, size_t& p_i) const;
+
   /*! \brief Helper function to perform a deep copy of a LineString and assign new ids to all the elements. Used during
    * route centerline construction
    *
@@ -175,6 +284,101 @@ private:
    */
   lanelet::LineString3d copyConstructLineString(const lanelet::ConstLineString3d& line) const;
 
+  /*! \brief Helper function to build a new traffic rules object for the provided participant
+   *
+   *  \return Optional traffic rules object. Empty if no rule set is available for the participant
+   */
+  lanelet::Optional<TrafficRulesConstPtr> buildTrafficRules(const std::string& participant) const;
+
+  /*! \brief Helper function to rebuild traffic_rules_cache_. Must be called after the configured speed limit or map change
+   */
+  void computeTrafficRulesCache();
+
+  /*! \brief Helper function to compute the speed limit of every lanelet in the map and the route speed limits
+   */
+  void computeSpeedLimits();
+
+  /*! \brief Helper function to compute the route speed limit step function from route_lanelet_intervals_ and lanelet_speed_limits_
+   */
+  void computeRouteSpeedLimits();
+
+  /*! \brief Helper function to compute the map polygons of the roadway objects and index them by the lanelets
+   *         getInLaneObjects() associates them with. Must be called after the roadway objects or the routing graph change.
+   */
+  void computeRoadwayObjectIndex();
+
+  /*! \brief Helper function to find the roadway objects associated with a lane using roadway_object_index_.
+   *         Each object is only associated with the first lanelet of the lane that it is indexed under.
+   *
+   *  \param lane The lanelets of the lane in order
+   *
+   *  \return Pairs of (index into lane, index into roadway_objects_) in lane order and then object order
+   */
+  std::vector<std::pair<size_t, size_t>> getInLaneObjectIndexes(const std::vector<lanelet::ConstLanelet>& lane) const;
+
+  /*! \brief Helper function to get the 2d polygon of a lanelet from lanelet_index_ without rebuilding it.
+   *         Lanelets which are not indexed have their polygon computed into storage.
+   *
+   *  \param lanelet The lanelet to get the polygon of
+   *  \param storage Storage for the polygon of lanelets which are not indexed
+   *
+   *  \return Reference to the cached polygon or to storage
+   */
+  const lanelet::BasicPolygon2d& laneletPolygon(const lanelet::ConstLanelet& lanelet,
+                                                lanelet::BasicPolygon2d& storage) const;
+
+  /*! \brief Helper function to find the lanelets containing a point using lanelet_index_. Only valid while
+   *         lanelet_index_valid_ is set.
+   *
+   *  \param point The point to find the containing lanelets of
+   *
+   *  \return The ids of the lanelets containing the point, nearest centerline first and then by id
+   */
+  std::vector<lanelet::Id> containingLaneletIds(const lanelet::BasicPoint2d& point) const;
+
+  /*! \brief Helper function equivalent to geometry::trackPos(lanelet, point) which matches the point against the
+   *         centerline segment hierarchy cached in centerline_indexes_
+   *
+   *  \param lanelet The lanelet whose centerline will serve as the TrackPos reference line
+   *  \param point The point to find the TrackPos of
+   *
+   *  \throws std::invalid_argument If the lanelet centerline contains fewer than two points
+   *
+   *  \return The TrackPos of the point relative to the lanelet centerline
+   */
+  TrackPos laneletTrackPos(const lanelet::ConstLanelet& lanelet, const lanelet::BasicPoint2d& point) const;
+
+  /*! \brief Helper function to build the RoadwayObstacle of an object once the lanelet it is on is known
+   *
+   *  \param object The external object to convert
+   *  \param nearestLanelet The lanelet the object is on
+   *
+   *  \return The RoadwayObstacle of the object
+   */
+  cav_msgs::RoadwayObstacle obstacleOnLanelet(const cav_msgs::ExternalObject& object,
+                                              const lanelet::ConstLanelet& nearestLanelet) const;
+
+  /*! \brief Helper function to check if a point is still on a previously associated lanelet. The hinted lanelet is
+   *         checked first, followed by its successors and its left and right neighbors.
+   *
+   *  \param point The point to check
+   *  \param hint The id of the previously associated lanelet
+   *
+   *  \return The first of the checked lanelets which contains the point. Empty if none of them contain it
+   */
+  lanelet::Optional<lanelet::ConstLanelet> hintedLanelet(const lanelet::BasicPoint2d& point, lanelet::Id hint) const;
+
+  /*! \brief Helper function to find the lanelet of a predicted object position. The previous lanelet of the object and
+   *         its successors are checked for containment first, then every lanelet whose bounding box contains the point.
+   *         If no lanelet contains the point the lanelet with the nearest bounding box is used.
+   *
+   *  \param point The predicted position
+   *  \param previous The lanelet of the previous position of the object
+   *
+   *  \return The lanelet of the predicted position
+   */
+  lanelet::ConstLanelet predictionLanelet(const lanelet::BasicPoint2d& point, const lanelet::ConstLanelet& previous) const;
+
   std::shared_ptr<lanelet::LaneletMap> semantic_map_;
   LaneletRoutePtr route_;
   LaneletRoutingGraphPtr map_routing_graph_;
@@ -187,7 +391,53 @@ private:
   IndexedDistanceMap shortest_path_distance_map_;
   lanelet::LaneletMapUPtr shortest_path_filtered_centerline_view_;  // Lanelet map view of shortest path center lines
                                                                     // only
+  std::vector<lanelet::BasicLineString2d> shortest_path_centerline_points_; // 2d copies of shortest_path_centerlines_ used by the route cursor
+  std::vector<std::vector<double>> shortest_path_point_clearances_; // Distance from each reference line point to the nearest point outside its cursor window
+
+  /*! \brief Precomputed route reference line geometry at a single reference line point
+   */
+  struct RouteProfilePoint
+  {
+    double heading = 0;
+    double curvature = 0;
+    double left_bound = 0;
+    double right_bound = 0;
+  };
+
+  std::vector<std::vector<RouteProfilePoint>> route_profile_points_; // Profile of each point in shortest_path_centerline_points_ in the same layout
+
+  static constexpr size_t ROUTE_CURSOR_WINDOW = 4; // Number of points on either side of a cursor which are checked exhaustively
   std::vector<cav_msgs::RoadwayObstacle> roadway_objects_; // 
+  std::vector<lanelet::BasicPolygon2d> roadway_object_polygons_; // Map polygons of roadway_objects_ in the same order
+  // Ascending indexes of roadway_objects_ keyed by lanelet id. An object is indexed under its own lanelet and under any 
+  // lanelet it intersects which has the object's lanelet as its left or right neighbor (ie. the object is lane changing)
+  std::unordered_map<lanelet::Id, std::vector<size_t>> roadway_object_index_;
+
+  /*! \brief Downtrack interval occupied by a single route lanelet. 
+   *         The start and end values are the route downtracks of the first and last centerline points of the lanelet
+   */
+  struct LaneletDowntrackInterval
+  {
+    lanelet::ConstLanelet lanelet;
+    double start = 0;
+    double end = 0;
+    long shortest_path_index = -1; // Index of the lanelet in the route shortest path. -1 if not on the shortest path
+  };
+
+  std::vector<LaneletDowntrackInterval> route_lanelet_intervals_; // Route lanelet intervals sorted by start downtrack
+  double max_route_lanelet_interval_length_ = 0; // Length of the longest interval in route_lanelet_intervals_. Used to bound searches
+  // TrackPos of the first and last centerline points of each route lanelet and each lanelet directly left or right of one
+  std::unordered_map<lanelet::Id, std::pair<TrackPos, TrackPos>> route_lanelet_track_pos_;
+
+  std::unordered_map<std::string, TrafficRulesConstPtr> traffic_rules_cache_; // Traffic rules by participant. Rebuilt when the map or config speed limit changes
+  std::unordered_map<lanelet::Id, double> lanelet_speed_limits_; // Vehicle speed limit in m/s of every lanelet in the map
+  std::vector<double> route_speed_limit_downtracks_; // Start downtracks of the shortest path lanelets in ascending order
+  std::vector<double> route_speed_limits_; // Speed limits in m/s matching route_speed_limit_downtracks_
+  LaneletSpatialIndex lanelet_index_; // Bounding boxes and flattened geometry of every lanelet in the map. Rebuilt when the map changes
+  // True while lanelet_index_ matches the map. Cleared when the map is handed out by getMutableMap() or set without a rebuild
+  // and set again when the index is rebuilt or updated
+  mutable bool lanelet_index_valid_ = false;
+  mutable geometry::LineStringIndexCache centerline_indexes_; // Segment hierarchies of the lanelet centerlines matched by laneletTrackPos. Cleared when the map changes
 
   size_t map_version_ = 0; // The current map version. This is cached from calls to setMap();
 
@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <lanelet2_core/LaneletMap.h>
+#include <autoware_lanelet2_msgs/MapBin.h>
+
+namespace carma_wm
+{
+/*! \brief Version of the flat binary map format written by toFlatBinary(). Readers reject any other version
+ */
+constexpr uint32_t FLAT_BINARY_MAP_VERSION = 1;
+
+/**
+ * \brief Writes a lanelet map into the flat binary map format.
+ *
+ * The format is a single contiguous, versioned buffer holding the points, line strings, polygons, lanelets, areas and
+ * regulatory elements of the map by id, in an order which allows it to be read back in one forward pass without the
+ * object tracking overhead of boost serialization. Primitive ids, attributes, line string inversion, custom lanelet
+ * centerlines and regulatory element parameters are preserved. Values are stored in host byte order.
+ *
+ * NOTE: Lanelet2 offers no way to construct a routing graph from precomputed relations so the routing graph is not
+ * part of the format and must still be built after loading.
+ *
+ * \param map The map to write
+ * \param output The buffer to write to. Any previous contents are replaced
+ */
+void toFlatBinary(const lanelet::LaneletMap& map, std::vector<uint8_t>& output);
+
+/**
+ * \brief Reads a lanelet map from a buffer written by toFlatBinary(). The buffer is only read so it may be a memory
+ *        mapped file.
+ *
+ * Regulatory elements are constructed with lanelet::RegulatoryElementFactory using their subtype attribute. Unknown
+ * rule types are loaded as lanelet::GenericRegulatoryElement.
+ *
+ * \param data Pointer to the start of the buffer
+ * \param size Size of the buffer in bytes
+ *
+ * \throws std::invalid_argument if the buffer is not a flat binary map of FLAT_BINARY_MAP_VERSION or is truncated or
+ *         inconsistent
+ *
+ * \return The loaded map
+ */
+lanelet::LaneletMapPtr fromFlatBinary(const uint8_t* data, size_t size);
+
+/**
+ * \brief Writes a lanelet map to a file in the flat binary map format
+ *
+ * \param map The map to write
+ * \param path The file to write
+ *
+ * \throws std::runtime_error if the file could not be written
+ */
+void saveFlatBinaryMap(const lanelet::LaneletMap& map, const std::string& path);
+
+/**
+ * \brief Loads a lanelet map from a flat binary map file by memory mapping it and reading it in a single pass
+ *
+ * \param path The file to load
+ *
+ * \throws std::runtime_error if the file could not be opened or mapped
+ * \throws std::invalid_argument if the file contents are not a valid flat binary map
+ *
+ * \return The loaded map
+ */
+lanelet::LaneletMapPtr loadFlatBinaryMap(const std::string& path);
+
+/**
+ * \brief Writes a lanelet map into a map binary message using the flat binary map format. Only the "data" field is
+ *        filled. The message can be read by mapFromBinMsg()
+ *
+ * \param map The map to write
+ * \param msg The message to fill
+ */
+void toFlatBinMsg(const lanelet::LaneletMap& map, autoware_lanelet2_msgs::MapBin* msg);
+
+/**
+ * \brief Returns true if the data of the provided map binary message is in the flat binary map format
+ */
+bool isFlatBinMsg(const autoware_lanelet2_msgs::MapBin& msg);
+
+/**
+ * \brief Reads the lanelet map held by a map binary message written by either toFlatBinMsg() or
+ *        lanelet::utils::conversion::toBinMsg. The format is detected from the message data.
+ *
+ * \param msg The message to read
+ *
+ * \throws std::invalid_argument if the message holds a flat binary map which is not valid
+ *
+ * \return The loaded map
+ */
+lanelet::LaneletMapPtr mapFromBinMsg(const autoware_lanelet2_msgs::MapBin& msg);
+
+}  // namespace carma_wm
@@ -88,6 +88,66 @@ TrackPos trackPos(const lanelet::BasicPoint2d& p, const lanelet::BasicPoint2d& s
 std::tuple<TrackPos, lanelet::BasicSegment2d> matchSegment(const lanelet::BasicPoint2d& p,
                                                            const lanelet::BasicLineString2d& line_string);
 
+/**
+ * \brief Computes the TrackPos of an external point relative to a line string once the nearest vertex of the line
+ * string is known. Shared by matchSegment, the batch trackPos function and LineStringIndex so that they all apply the
+ * same segment selection rules. Logic is as follows
+ * If the nearest point is the first point then use the first segment
+ * If the nearest point is the last point then use the last segment
+ * Otherwise the segment is selected using selectFirstSegment
+ *
+ * \param p The external point
+ * \param line_string The line string containing at least two points
+ * \param best_point_index The index of the nearest vertex
+ * \param best_accumulated_length The length of the line string up to the nearest vertex
+ * \param best_last_accumulated_length The length of the line string up to the vertex before the nearest vertex
+ * \param best_seg_length The length of the segment starting at the nearest vertex. 0 for the last vertex
+ * \param best_last_seg_length The length of the segment ending at the nearest vertex. 0 for the first vertex
+ * \param segment_start_index Output for the index of the first point of the selected segment
+ *
+ * \return The TrackPos of the point relative to the line string
+ */
+TrackPos trackPosFromNearestPoint(const lanelet::BasicPoint2d& p, const lanelet::BasicLineString2d& line_string,
+                                  size_t best_point_index, double best_accumulated_length,
+                                  double best_last_accumulated_length, double best_seg_length,
+                                  double best_last_seg_length, size_t& segment_start_index);
+
+/**
+ * \brief Batch version of matchSegment which computes the TrackPos of each provided point relative to the line string.
+ *
+ * Each result is identical to std::get<0>(matchSegment(points[i], line_string)) within floating point rounding of the
+ * accumulated segment lengths. The nearest vertex search starts from the nearest vertex of the previous point. The
+ * vertices it did not check are grouped into at most 64 bounding boxes and only checked where a box could contain a
+ * closer vertex. As the box holding the nearest vertex always has to be checked, each point costs O(64 + n / 64) for a
+ * line string of n vertices. Use LineStringIndex::trackPos when the same line string is queried repeatedly, which costs
+ * O(log n) per point. No heap allocations are made if output already has capacity for points.size() elements.
+ *
+ * \param line_string The line_string to match against
+ * \param points The 2d points to compute the TrackPos of
+ * \param output The buffer the TrackPos of each point will be written to in the same order. Cleared before use
+ *
+ * \throw std::invalid_argument if line string contains fewer than two points
+ */
+void trackPos(const lanelet::BasicLineString2d& line_string, const std::vector<lanelet::BasicPoint2d>& points,
+              std::vector<TrackPos>& output);
+
+/**
+ * \brief Inverse of the batch trackPos function. Converts each TrackPos relative to the line string into a 2d point.
+ *
+ * The point is placed on the segment which contains its downtrack, offset by the crosstrack with positive crosstrack to
+ * the right. Downtracks before the start or after the end of the line string are extrapolated along the first or last
+ * segment. Positions are walked from the segment of the previous position so ordered inputs cost constant time each.
+ * No heap allocations are made if output already has capacity for track_positions.size() elements.
+ *
+ * \param line_string The line_string the positions are relative to
+ * \param track_positions The positions to convert
+ * \param output The buffer the points will be written to in the same order. Cleared before use
+ *
+ * \throw std::invalid_argument if line string contains fewer than two points
+ */
+void pointsFromTrackPos(const lanelet::BasicLineString2d& line_string, const std::vector<TrackPos>& track_positions,
+                        std::vector<lanelet::BasicPoint2d>& output);
+
 /*! \brief Returns a list of local (computed by discrete derivative)
  * curvatures for the input centerlines. The list of returned curvatures matches
  * 1-to-1 with with list of points in the input centerlines.
@@ -365,6 +425,91 @@ double circular_arc_curvature(const lanelet::BasicPoint2d& cur_point, const lane
  */
 std::vector<double> local_circular_arc_curvatures(const std::vector<lanelet::BasicPoint2d>& points, int lookahead);
 
+/**
+ * \brief Non owning view of the coordinates of a sequence of 2d points stored in contiguous memory.
+ *        Coordinates may be stored as separate x and y arrays (stride 1) or interleaved as x,y pairs (stride 2) which is
+ *        the layout of lanelet::BasicLineString2d and std::vector<lanelet::BasicPoint2d>.
+ *        The viewed memory must outlive the view.
+ */
+struct PointArrayView
+{
+  const double* x = nullptr;  // Pointer to the first x coordinate
+  const double* y = nullptr;  // Pointer to the first y coordinate
+  size_t size = 0;            // Number of points
+  size_t stride = 1;          // Number of doubles between the coordinates of consecutive points
+
+  double xAt(size_t i) const
+  {
+    return x[i * stride];
+  }
+
+  double yAt(size_t i) const
+  {
+    return y[i * stride];
+  }
+};
+
+/**
+ * \brief Creates a view of separate x and y coordinate arrays of the provided size
+ */
+PointArrayView makePointArrayView(const double* x, const double* y, size_t size);
+
+/**
+ * \brief Creates a view of the coordinates of the provided points
+ */
+PointArrayView makePointArrayView(const lanelet::BasicLineString2d& points);
+
+PointArrayView makePointArrayView(const std::vector<lanelet::BasicPoint2d>& points);
+
+/*!
+ * \brief Allocation free version of compute_finite_differences for points. Writes points.size derivatives.
+ *
+ * \param points The points to differentiate over
+ * \param dx_out Output for the x component of each derivative
+ * \param dy_out Output for the y component of each derivative
+ * \param out_stride Number of doubles between consecutive output values. Use 2 to write into interleaved x,y storage
+ */
+void compute_finite_differences(const PointArrayView& points, double* dx_out, double* dy_out, size_t out_stride = 1);
+
+/*!
+ * \brief Allocation free version of compute_arc_lengths. Writes points.size arc lengths to arc_lengths_out
+ */
+void compute_arc_lengths(const PointArrayView& points, double* arc_lengths_out);
+
+/*!
+ * \brief Allocation free version of compute_tangent_orientations. Writes points.size orientations to orientations_out
+ */
+void compute_tangent_orientations(const PointArrayView& points, double* orientations_out);
+
+/*!
+ * \brief Allocation free version of local_curvatures. Writes points.size curvatures to curvatures_out
+ *
+ * \throw std::invalid_argument If points is empty
+ */
+void local_curvatures(const PointArrayView& points, double* curvatures_out);
+
+/*!
+ * \brief Allocation free version of local_circular_arc_curvatures. Writes points.size curvatures to curvatures_out
+ *
+ * \throw std::invalid_argument If lookahead is not greater than 0
+ */
+void local_circular_arc_curvatures(const PointArrayView& points, int lookahead, double* curvatures_out);
+
+/*!
+ * \brief Computes the arc lengths, tangent orientations and local curvatures of a sequence of points in a single pass.
+ *        The results are identical to compute_arc_lengths, compute_tangent_orientations and local_curvatures but the
+ *        finite differences, tangents and arc lengths are only computed once per point and no memory is allocated.
+ *        Any output may be nullptr in which case that result is not written. Each non null output receives points.size
+ *        values.
+ *
+ * \param points The points to compute the geometry of
+ * \param arc_lengths_out Output for the arc length at each point
+ * \param orientations_out Output for the tangent orientation at each point in radians
+ * \param curvatures_out Output for the local curvature at each point in 1/m
+ */
+void compute_centerline_geometry(const PointArrayView& points, double* arc_lengths_out, double* orientations_out,
+                                 double* curvatures_out);
+
 }  // namespace geometry
 
 }  // namespace carma_wm
\ No newline at end of file
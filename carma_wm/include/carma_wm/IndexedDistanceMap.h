@@ -43,11 +43,13 @@ class IndexedDistanceMap
 {
 private:
   // Distance storage structure
-  // A vector of tuples where the first vector is indexed by line segment and the second vector is index by point index
-  // on that line segment. The double value in the tuple stores the total along-line distance to the start of that line
-  // segment from the first point on the first line segment The double value inside the interior vector store the
-  // along-line distance of the point from the start of its line segment
-  std::vector<std::tuple<std::vector<double>, double>> accum_lengths;
+  // The along-line distance of every point from the start of its line segment is stored contiguously in
+  // point_distances. The points of line segment i occupy the range [element_offsets[i], element_offsets[i + 1]).
+  // element_distances[i] stores the total along-line distance to the start of line segment i from the first point on
+  // the first line segment. Keeping these values in flat arrays allows the distance searches to run over contiguous memory
+  std::vector<double> point_distances;
+  std::vector<size_t> element_offsets = { 0 };
+  std::vector<double> element_distances;
 
   // Id mapping structure
   // Sores the linestring and point index's as values with their lanelet Ids as the key
@@ -146,11 +148,26 @@ public:
 
   /*!
    * \brief Returns index of the linestring which the provided distance is within.
+   *        If the distance lies exactly at the boundary of two linestrings the later linestring is returned.
    *        NOTE: Unlike the rest of this class, this method runs in O(log n) where n is this.size()
    *
    * \throw std::invalid_argument if distance does not fit within bounds [0, totalLength()]
    * \return The linestring index which this distance is inside
    */
   size_t getElementIndexByDistance(double distance) const;
+
+  /*!
+   * \brief Returns index of the last point on the linestring at the provided index whose along-line distance is less
+   *        than or equal to the provided distance. Distances past the end of the linestring return the last point index.
+   *        NOTE: This method runs in O(log m) where m is this.size(index)
+   *
+   * NOTE: No bounds checking is performed on the linestring index
+   *
+   * \param index The linestring index
+   * \param distance The along-line distance from the start of the linestring
+   *
+   * \return The point index at or immediately before the provided distance. 0 if the distance is negative
+   */
+  size_t getPointIndexByDistance(size_t index, double distance) const;
 };
 }  // namespace carma_wm
@@ -0,0 +1,119 @@
+#pragma once
+
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Point.h>
+
+namespace carma_wm
+{
+/*!
+ * \brief Flattened 2d geometry of a lanelet cached by LaneletSpatialIndex so that geometric predicates do not need to
+ *        rebuild the lanelet polygon or centerline on each call
+ */
+struct LaneletGeometry
+{
+  using Box = boost::geometry::model::box<lanelet::BasicPoint2d>;
+
+  const lanelet::LaneletData* data = nullptr;  // Data of the lanelet the geometry was computed from
+  lanelet::BasicPolygon2d polygon;             // Equal to lanelet.polygon2d().basicPolygon()
+  Box bounding_box;                            // Axis aligned bounding box of the polygon
+  lanelet::BasicLineString2d centerline;       // 2d centerline of the non inverted lanelet
+};
+
+/*!
+ * \brief R-tree of the 2d bounding boxes of the lanelets in a map used to find the lanelets containing a point, along
+ *        with the flattened geometry of each lanelet.
+ *        NOTE: This structure is used internally in the world model and is not intended for use by WorldModel users.
+ *
+ * Unlike lanelet::geometry::findNearest, which returns a fixed number of lanelets ordered by distance, a query returns
+ * exactly the lanelets whose bounding box contains the point. Only these few candidates need an exact containment test,
+ * which can be run on the cached polygon. The index is built once per map and individual lanelets can be reinserted or
+ * removed when a map update edits them.
+ */
+class LaneletSpatialIndex
+{
+public:
+  /*!
+   * \brief Replace the contents of this index with every lanelet in the provided layer. O(n log n)
+   *
+   * \param layer The lanelet layer to index
+   */
+  void build(const lanelet::LaneletLayer& layer);
+
+  /*!
+   * \brief Reindex the provided lanelets. Lanelets which are in the layer are inserted or have their geometry
+   *        replaced. Lanelets which are no longer in the layer are removed. O(k log n) for k ids
+   *
+   * \param layer The lanelet layer the ids refer to
+   * \param lanelet_ids The ids of the lanelets to reindex
+   */
+  void update(const lanelet::LaneletLayer& layer, const std::vector<lanelet::Id>& lanelet_ids);
+
+  /*!
+   * \brief Get the ids of the lanelets whose bounding box contains the provided point in ascending order.
+   *        An exact containment test is still required for each returned lanelet
+   *
+   * \param point The point to query
+   *
+   * \return The ids of the candidate lanelets
+   */
+  std::vector<lanelet::Id> candidates(const lanelet::BasicPoint2d& point) const;
+
+  /*!
+   * \brief Get the cached geometry of the lanelet with the provided id
+   *
+   * \param id The id of the lanelet
+   *
+   * \return The cached geometry or nullptr if the lanelet is not indexed
+   */
+  const LaneletGeometry* geometry(lanelet::Id id) const;
+
+  /*!
+   * \brief Get the cached geometry of the provided lanelet. The geometry is only returned if it was computed from this
+   *        lanelet and not another lanelet with the same id, such as one from a different map
+   *
+   * \param lanelet The lanelet to get the geometry of
+   *
+   * \return The cached geometry or nullptr if the lanelet is not indexed
+   */
+  const LaneletGeometry* geometry(const lanelet::ConstLanelet& lanelet) const;
+
+  /*!
+   * \brief Returns the number of indexed lanelets
+   */
+  size_t size() const;
+
+  /*!
+   * \brief Remove all lanelets from this index
+   */
+  void clear();
+
+private:
+  using Value = std::pair<LaneletGeometry::Box, lanelet::Id>;
+
+  static LaneletGeometry computeGeometry(const lanelet::ConstLanelet& lanelet);
+
+  boost::geometry::index::rtree<Value, boost::geometry::index::rstar<16>> tree_;
+  std::unordered_map<lanelet::Id, LaneletGeometry> geometry_;  // Geometry of each indexed lanelet
+};
+}  // namespace carma_wm
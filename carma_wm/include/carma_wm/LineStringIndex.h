@@ -0,0 +1,236 @@
+#pragma once
+
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <lanelet2_core/primitives/Lanelet.h>
+#include <lanelet2_core/primitives/LineString.h>
+#include "TrackPos.h"
+
+namespace carma_wm
+{
+namespace geometry
+{
+/*!
+ * \brief Static bounding volume hierarchy over the vertices of a line string which answers matchSegment queries in
+ *        O(log n) time instead of the O(n) scan performed by geometry::matchSegment.
+ *
+ * The hierarchy is built once over contiguous vertex ranges, so each node bounds a connected piece of the line string,
+ * and the segment lengths and accumulated lengths are precomputed. A query finds the nearest vertex exactly, keeping
+ * the first vertex on ties just like matchSegment, and then applies the same segment selection rules through
+ * geometry::trackPosFromNearestPoint. Results are therefore identical to geometry::matchSegment, including the
+ * handling of points which project beyond the ends of segments.
+ *
+ * Building the index is O(n). It only pays off when several queries are made against the same line string, which is
+ * the reason for LineStringIndexCache.
+ *
+ * The index copies the line string so it remains valid if the source line string is modified or destroyed.
+ */
+class LineStringIndex
+{
+public:
+  /*!
+   * \brief Builds the index for the provided line string
+   *
+   * \param line_string The line string to index
+   *
+   * \throws std::invalid_argument if the line string contains fewer than two points
+   */
+  explicit LineStringIndex(const lanelet::BasicLineString2d& line_string);
+
+  /*!
+   * \brief Equivalent to geometry::matchSegment(p, lineString())
+   *
+   * \param p The point to match
+   *
+   * \return The TrackPos of p relative to the line string and the segment it was matched to
+   */
+  std::tuple<TrackPos, lanelet::BasicSegment2d> matchSegment(const lanelet::BasicPoint2d& p) const;
+
+  /*!
+   * \brief Equivalent to std::get<0>(geometry::matchSegment(p, lineString()))
+   *
+   * \param p The point to match
+   *
+   * \return The TrackPos of p relative to the line string
+   */
+  TrackPos trackPos(const lanelet::BasicPoint2d& p) const;
+
+  /*!
+   * \brief Batch equivalent of geometry::trackPos(lineString(), points, output).
+   *
+   * The nearest vertex search of each point starts from the nearest vertex of the previous point, so the hierarchy
+   * only has to confirm that no other node holds a closer vertex. Points ordered along the line string, such as
+   * trajectories or object predictions, therefore cost O(log n) each. No heap allocations are made if output already
+   * has capacity for points.size() elements.
+   *
+   * \param points The 2d points to compute the TrackPos of
+   * \param output The buffer the TrackPos of each point will be written to in the same order. Cleared before use
+   */
+  void trackPos(const std::vector<lanelet::BasicPoint2d>& points, std::vector<TrackPos>& output) const;
+
+  /*!
+   * \brief Returns the index of the vertex nearest to p. If several vertices are equally near the first is returned
+   */
+  size_t nearestVertex(const lanelet::BasicPoint2d& p) const;
+
+  /*!
+   * \brief Returns the indexed copy of the line string
+   */
+  const lanelet::BasicLineString2d& lineString() const;
+
+  /*!
+   * \brief Returns the length of the line string
+   */
+  double length() const;
+
+private:
+  // Axis aligned bounding box over the vertex range [begin, end). Leaf nodes have left and right set to -1
+  struct Node
+  {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+    uint32_t begin;
+    uint32_t end;
+    int32_t left;
+    int32_t right;
+  };
+
+  int32_t build(uint32_t begin, uint32_t end);
+  TrackPos trackPos(const lanelet::BasicPoint2d& p, size_t& segment_start_index) const;
+  TrackPos trackPosFromNearestVertex(const lanelet::BasicPoint2d& p, size_t best_point_index,
+                                     size_t& segment_start_index) const;
+
+  // Searches for a vertex nearer than the candidate best_point_index at min_distance. The vertices in
+  // [skip_begin, skip_end) are known to be no nearer than the candidate so they are not checked
+  size_t nearestVertex(const lanelet::BasicPoint2d& p, size_t best_point_index, double min_distance, size_t skip_begin,
+                       size_t skip_end) const;
+
+  lanelet::BasicLineString2d points_;
+  std::vector<double> accumulated_lengths_;  // accumulated_lengths_[i] is the line string length up to vertex i
+  std::vector<Node> nodes_;                  // nodes_[0] is the root
+};
+
+using LineStringIndexConstPtr = std::shared_ptr<const LineStringIndex>;
+
+/*!
+ * \brief Thread safe cache of LineStringIndex objects keyed by line string id so that the index of frequently matched
+ *        line strings, such as lanelet centerlines, is only built once.
+ *
+ * Entries are keyed by the kind of primitive (line string or lanelet centerline), its id and its inversion, so line
+ * strings and lanelets which share an id do not replace each other. A cached entry is rebuilt if the size or end
+ * points of the line string no longer match, which covers line strings replaced by map updates. Interior vertices are
+ * not checked so clear() should be called if line string points are moved in place. When the cache is full it is
+ * emptied before the next entry is inserted.
+ */
+class LineStringIndexCache
+{
+public:
+  /*!
+   * \brief Constructor
+   *
+   * \param capacity The maximum number of indexes held by the cache
+   */
+  explicit LineStringIndexCache(size_t capacity = 1024);
+
+  /*!
+   * \brief Returns the index of the provided line string, building it if it is not already cached.
+   *        Line strings without a valid id are indexed but not cached.
+   *
+   * \param line_string The line string to get the index of
+   *
+   * \throws std::invalid_argument if the line string contains fewer than two points
+   */
+  LineStringIndexConstPtr get(const lanelet::ConstLineString2d& line_string);
+
+  /*!
+   * \brief Returns the index of the centerline of the provided lanelet, building it if it is not already cached.
+   *        Centerlines are keyed by lanelet id as computed centerlines do not have an id of their own.
+   *
+   * \param lanelet The lanelet to get the centerline index of
+   *
+   * \throws std::invalid_argument if the lanelet centerline contains fewer than two points
+   */
+  LineStringIndexConstPtr getCenterline(const lanelet::ConstLanelet& lanelet);
+
+  /*!
+   * \brief Cached equivalent of geometry::trackPos(lanelet, point)
+   *
+   * \param lanelet The lanelet whose centerline will serve as the TrackPos reference line
+   * \param point The point to find the TrackPos of
+   *
+   * \throws std::invalid_argument if the lanelet centerline contains fewer than two points
+   *
+   * \return The TrackPos of the point relative to the lanelet centerline
+   */
+  TrackPos trackPos(const lanelet::ConstLanelet& lanelet, const lanelet::BasicPoint2d& point);
+
+  /*!
+   * \brief Removes all cached indexes
+   */
+  void clear();
+
+  /*!
+   * \brief Returns the number of cached indexes
+   */
+  size_t size() const;
+
+private:
+  // Kind of primitive an entry was built from. Lanelets and line strings have separate id spaces
+  enum class Kind : uint8_t
+  {
+    LINE_STRING = 0,
+    CENTERLINE = 1
+  };
+
+  struct Key
+  {
+    Kind kind;
+    lanelet::Id id;
+    bool inverted;
+
+    bool operator==(const Key& other) const
+    {
+      return kind == other.kind && id == other.id && inverted == other.inverted;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      size_t flags = static_cast<size_t>(key.kind) << 1 | (key.inverted ? 1 : 0);
+      return std::hash<lanelet::Id>()(key.id) ^ (flags * static_cast<size_t>(0x9e3779b9));
+    }
+  };
+
+  LineStringIndexConstPtr get(const Key& key, const lanelet::ConstLineString2d& line_string);
+
+  size_t capacity_;
+  mutable std::mutex mutex_;
+  std::unordered_map<Key, LineStringIndexConstPtr, KeyHash> indexes_;
+};
+
+}  // namespace geometry
+}  // namespace carma_wm
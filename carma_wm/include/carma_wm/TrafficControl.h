@@ -46,10 +46,24 @@ public:
                  std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> remove_list):
                  id_(id), update_list_(update_list), remove_list_(remove_list){}  
 
-  boost::uuids::uuid id_;  // Unique id of this geofence
+  /*! \brief Returns true if this is a consolidated update rather than the update of a single geofence.
+   *         carma_wm_ctrl::WMBroadcaster sends a consolidated update with a nil id to each new map update subscriber.
+   *         It holds the net change of every update on the current map version relative to the base map, and reuses
+   *         the sequence number of the most recent update. Subscribers which already applied some of those updates
+   *         must reset the updated lanelets to their base regulatory elements before applying it.
+   */
+  bool isConsolidated() const
+  {
+    return id_.is_nil();
+  }
+
+  boost::uuids::uuid id_;  // Unique id of this geofence. Nil for a consolidated update, see isConsolidated()
   // elements needed for broadcasting to the rest of map users
   std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> update_list_;
   std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> remove_list_;
+  // Lanelets and areas the regulatory elements of an update decoded from a compact message refer to. Regulatory
+  // elements only hold weak references to them so they are kept alive for as long as the update. Not serialized
+  std::vector<lanelet::ConstLaneletOrArea> lanelets_and_areas_;
 };
 
 /**
@@ -72,6 +86,45 @@ void toBinMsg(std::shared_ptr<carma_wm::TrafficControl> gf_ptr, autoware_lanelet
  */
 void fromBinMsg(const autoware_lanelet2_msgs::MapBin& msg, std::shared_ptr<carma_wm::TrafficControl> gf_ptr);
 
+/*! \brief Version of the compact map update format written by toCompactBinMsg(). Readers reject any other version
+ */
+constexpr uint32_t COMPACT_MAP_UPDATE_VERSION = 1;
+
+/**
+ * [Converts carma_wm::TrafficControl object to ROS message using the compact map update format. The message is
+ * read by the same fromBinMsg functions as messages written by toBinMsg]
+ * @param gf_ptr [Ptr to Geofence data]
+ * @param msg [converted ROS message. Only "data" field is filled]
+ * @param reference_map [Primitives every receiver already holds such as those of the base map. May be null]
+ * @param compress [If true the message is LZ4 block compressed when carma_wm is built with LZ4 and compression makes it
+ * smaller. Receivers need a carma_wm built with LZ4 to read compressed messages]
+ * NOTE: Regulatory element parameters which are the same objects as the primitives with their ids in reference_map
+ * are written as id references. Receivers resolve them from their own map, so reference_map must not contain
+ * primitives which were added after the receivers loaded the map, such as those added by geofences.
+ * Only the remaining parameters are written in full, using the flat binary map format.
+ * Each regulatory element is written once no matter how many lanelets it is paired with. Values are not quantized so
+ * the message decodes to the same ids, attributes and coordinates as toBinMsg. As with toBinMsg, lanelets and areas
+ * which are written in full do not carry their own regulatory elements.
+ */
+void toCompactBinMsg(std::shared_ptr<carma_wm::TrafficControl> gf_ptr, autoware_lanelet2_msgs::MapBin* msg,
+                     lanelet::LaneletMapConstPtr reference_map = nullptr, bool compress = false);
+
+/**
+ * [Converts Geofence binary ROS message written by either toBinMsg or toCompactBinMsg to carma_wm::TrafficControl
+ * object]
+ * @param msg [ROS message for geofence]
+ * @param gf_ptr [Ptr to converted Geofence object]
+ * @param reference_map [Map used to resolve the primitives a compact message references by id. May be null]
+ * NOTE: Referenced parameters resolve to the primitives of reference_map so the decoded regulatory elements can be
+ * added to it directly. If reference_map is null referenced parameters are restored as placeholders which only carry
+ * their id. This is sufficient for users which only read the ids and attributes of the update. The lanelets and areas
+ * the decoded regulatory elements refer to are kept alive by gf_ptr->lanelets_and_areas_.
+ * @throw std::invalid_argument if a compact message is corrupt, of another version, references a primitive which is
+ * not in reference_map or is compressed while carma_wm is built without LZ4
+ */
+void fromBinMsg(const autoware_lanelet2_msgs::MapBin& msg, std::shared_ptr<carma_wm::TrafficControl> gf_ptr,
+                lanelet::LaneletMapPtr reference_map);
+
 
 }  // namespace carma_wm
 
@@ -57,6 +57,19 @@ enum LaneSection
   LANE_FULL
 };
 
+/*! \brief Route reference line geometry and speed limit at a single downtrack. Returned by WorldModel::sampleRouteProfile
+ */
+struct RouteProfileSample
+{
+  double downtrack = 0;  // Route downtrack in meters
+  lanelet::BasicPoint2d point;  // Point on the route reference line
+  double heading = 0;  // Orientation of the reference line tangent in radians
+  double curvature = 0;  // Unsigned curvature of the reference line in 1/m
+  double left_bound = 0;  // Distance from the reference line to the left bound of the shortest path lanelet in meters
+  double right_bound = 0;  // Distance from the reference line to the right bound of the shortest path lanelet in meters
+  double speed_limit = 0;  // Route speed limit in m/s
+};
+
 /*! \brief An interface which provides read access to the semantic map and route.
  *         This class is not thread safe. All units of distance are in meters
  *
@@ -102,6 +115,20 @@ public:
    */
   virtual TrackPos routeTrackPos(const lanelet::ConstLanelet& lanelet) const = 0;
 
+  /*! \brief Returns the route TrackPos, computed in 2d, of the first and last centerline points of a lanelet which is
+   *         part of the route or directly left or right of a route lanelet.
+   *
+   * In the default implementation, these positions are computed once when the route is set so this is a hash lookup.
+   *
+   * \param lanelet_id The id of the lanelet to look up
+   *
+   * \throws std::invalid_argument If the route is not yet loaded
+   *
+   * \return A pair where the first element is the TrackPos of the lanelet's first centerline point and the second
+   * element is the TrackPos of its last centerline point. boost::none if the lanelet is not on or adjacent to the route
+   */
+  virtual lanelet::Optional<std::pair<TrackPos, TrackPos>> getRouteLaneletTrackPos(lanelet::Id lanelet_id) const = 0;
+
   /*! \brief Returns the TrackPos, computed in 2d, of the provided point relative to the current route
    *
    * NOTE: The route definition used in this class contains discontinuities in the reference line at lane changes. It is
@@ -115,6 +142,25 @@ public:
    */
   virtual TrackPos routeTrackPos(const lanelet::BasicPoint2d& point) const = 0;
 
+  /*! \brief Returns the TrackPos, computed in 2d, of each of the provided points relative to the current route.
+   *        The results are identical to calling routeTrackPos on each point individually.
+   *
+   *  This method is intended for points which are ordered along the route such as trajectories or sampled centerlines.
+   *  In that case the nearest point on the route reference line is found by walking forward from the previous match
+   *  so the per point cost is amortized O(1). Unordered points or points far from the route fall back to the cost of
+   *  the single point method.
+   *
+   * NOTE: The route definition used in this class contains discontinuities in the reference line at lane changes. It is
+   * important to consider that when using route related functions.
+   *
+   * \param points The lanelet2 points which will have their distances computed
+   *
+   * \throws std::invalid_argument If the route is not yet loaded
+   *
+   * \return The TrackPos of each point in the same order as the input
+   */
+  virtual std::vector<TrackPos> routeTrackPos(const std::vector<lanelet::BasicPoint2d>& points) const = 0;
+
   /*! \brief Returns a list of lanelets which are part of the route and whose downtrack bounds exist within the provided
    * start and end distances. 
    *
@@ -141,9 +187,8 @@ public:
    *  NOTE: If start_downtrack == end_downtrack a single point is returned. 
    *        If the route is not set or the bounds lie outside the route an empty vector is returned.
    *        
-   *        In the default implementation, this method has m * O(log n) complexity where n is the number of lane changes in the route + 1
-   *        and m is the number of sampled points which is nominally 1 + ((start_downtrack - end_downtrack) / step_size). 
-   *        Since the route is fixed for the duration of method execution this can generally be thought of as a linear complexity call dominated by m.
+   *        In the default implementation, this method walks the route reference line once so it has O(m + n) complexity where n is the number
+   *        of reference line points between the bounds and m is the number of sampled points which is nominally 1 + ((start_downtrack - end_downtrack) / step_size). 
    * 
    *  \param start_downtrack The starting route downtrack to sample from in meters
    *  \param end_downtrack The ending downtrack to stop sampling at in meters
@@ -156,6 +201,37 @@ public:
   virtual std::vector<lanelet::BasicPoint2d> sampleRoutePoints(double start_downtrack, double end_downtrack,
                                                                double step_size) const = 0;
 
+  /*! \brief Overload of sampleRoutePoints which writes the sampled points into a caller provided buffer.
+   *         The buffer is cleared before sampling but its capacity is preserved, so reusing the same buffer each planning
+   *         cycle avoids repeated allocation.
+   *
+   *  \param start_downtrack The starting route downtrack to sample from in meters
+   *  \param end_downtrack The ending downtrack to stop sampling at in meters
+   *  \param step_size The sampling step size in meters.
+   *  \param output The buffer the sampled x,y points will be written to. Empty if the route is not set or the bounds are invalid
+   */
+  virtual void sampleRoutePoints(double start_downtrack, double end_downtrack, double step_size,
+                                 std::vector<lanelet::BasicPoint2d>& output) const = 0;
+
+  /*! \brief Samples the route reference line profile between the provided downtracks with the provided step size.
+   *         The points, headings, curvatures and lateral bounds of the reference line are precomputed when the route is
+   *         set so sampling only interpolates between table entries. Sampling behaves the same as sampleRoutePoints.
+   *         The buffer is cleared before sampling but its capacity is preserved.
+   *
+   *  NOTE: Curvature is computed from the change in heading between neighboring reference line points so it is not
+   *        smoothed. Headings and curvatures are not continuous across lane changes in the reference line.
+   *
+   *        In the default implementation, this method has O(m + n) complexity where n is the number of reference line
+   *        points between the bounds and m is the number of sampled points.
+   *
+   *  \param start_downtrack The starting route downtrack to sample from in meters
+   *  \param end_downtrack The ending downtrack to stop sampling at in meters
+   *  \param step_size The sampling step size in meters.
+   *  \param output The buffer the samples will be written to. Empty if the route is not set or the bounds are invalid
+   */
+  virtual void sampleRouteProfile(double start_downtrack, double end_downtrack, double step_size,
+                                  std::vector<RouteProfileSample>& output) const = 0;
+
   /*! \brief Converts a route track position into a map frame cartesian point.
    *
    *  \param route_pos The TrackPos to convert to and x,y point. This position should be relative to the route
@@ -215,6 +291,32 @@ public:
   virtual lanelet::Optional<TrafficRulesConstPtr>
   getTrafficRules(const std::string& participant = lanelet::Participants::Vehicle) const = 0;
 
+  /*! \brief Get the vehicle speed limit of a lanelet as defined by the traffic rules returned from getTrafficRules()
+   *
+   * In the default implementation, the speed limits of all map lanelets are cached when the map is set so this is an O(1) lookup.
+   *
+   * \param lanelet The lanelet to get the speed limit of
+   *
+   * \throws std::invalid_argument if the lanelet is not in the cache and no traffic rules object could be built
+   *
+   * \return The speed limit in m/s
+   */
+  virtual double getSpeedLimit(const lanelet::ConstLanelet& lanelet) const = 0;
+
+  /*! \brief Get the vehicle speed limit at a downtrack along the route shortest path.
+   *         The speed limit is a step function which changes at the start of each shortest path lanelet.
+   *         Downtracks before the route start or after the route end use the first or last lanelet's speed limit
+   *
+   * In the default implementation, this has O(log n) complexity where n is the number of lanelets on the shortest path
+   *
+   * \param downtrack The route downtrack in meters
+   *
+   * \throws std::invalid_argument if the route is not set
+   *
+   * \return The speed limit in m/s
+   */
+  virtual double getRouteSpeedLimit(double downtrack) const = 0;
+
   /**
    * \brief Converts an ExternalObject in a RoadwayObstacle by mapping its position onto the semantic map. Can also be
    * used to determine if the object is on the roadway
@@ -229,6 +331,49 @@ public:
   virtual lanelet::Optional<cav_msgs::RoadwayObstacle>
   toRoadwayObstacle(const cav_msgs::ExternalObject& object) const = 0;
 
+  /**
+   * \brief Batch version of toRoadwayObstacle which converts each provided ExternalObject into a RoadwayObstacle.
+   *
+   * Each result is identical to toRoadwayObstacle(objects[i]). The lanelet of each prediction is searched for starting
+   * from the lanelet of the previous prediction, and then its successors, before the whole map is searched, so the
+   * predictions of an object moving along its lane cost roughly constant time each.
+   *
+   * \param objects The external objects to convert
+   * \param thread_count The number of threads the objects are split across. 1 converts all objects on the calling
+   * thread. The world model must not be modified until the call returns
+   *
+   * \throw std::invalid_argument if the map is not set or contains no lanelets
+   *
+   * \return The optional RoadwayObstacle of each object in the same order as objects. The optional is empty for objects
+   * which are not on the roadway
+   */
+  virtual std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+  toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects, unsigned int thread_count = 1) const = 0;
+
+  /**
+   * \brief Version of toRoadwayObstacles which uses the lanelets objects were previously associated with, such as the
+   * lanelet_id of the RoadwayObstacle of the same object from the previous frame, as a starting point.
+   *
+   * If the center of an object is within its hinted lanelet, or one of the successors or left and right neighbors of
+   * that lanelet, the object is associated with that lanelet without a search of the map. Otherwise the object is
+   * converted by toRoadwayObstacle. Predictions are handled the same as in toRoadwayObstacle.
+   *
+   * \param objects The external objects to convert
+   * \param lanelet_hints The previous lanelet id of each object in the same order as objects, or lanelet::InvalId for
+   * objects without a previous lanelet. May be empty if no object has a previous lanelet
+   * \param thread_count The number of threads the objects are split across. 1 converts all objects on the calling
+   * thread. The world model must not be modified until the call returns
+   *
+   * \throw std::invalid_argument if the map is not set or contains no lanelets, or if lanelet_hints is not empty and
+   * does not match the size of objects
+   *
+   * \return The optional RoadwayObstacle of each object in the same order as objects. The optional is empty for objects
+   * which are not on the roadway
+   */
+  virtual std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+  toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects, const std::vector<lanelet::Id>& lanelet_hints,
+                     unsigned int thread_count = 1) const = 0;
+
   /**
    * \brief Gets the a lanelet the object is currently on determined by its position on the semantic map. If it's
    * across multiple lanelets, get the closest one
@@ -324,8 +469,13 @@ public:
   /**
    * \brief Gets the underlying lanelet, given the cartesian point on the map
    *
+   * The lanelets are found using a spatial index of lanelet bounding boxes followed by an exact containment check so
+   * every containing lanelet is found regardless of how many other lanelets are nearby. Where lanelets overlap, the
+   * lanelets are ordered by the distance from the point to their centerline so the first lanelet is the best match.
+   *
    * \param point Cartesian point to check the corressponding lanelet
-   * \param n     Number of lanelets to return. Default is 10. As there could be many lanelets overlapping.
+   * \param n     Maximum number of lanelets to return. Default is 10. As there could be many lanelets overlapping.
+   *              The n lanelets with the nearest centerlines are returned.
    * \throw std::invalid_argument if the map is not set, contains no lanelets
    *
    * \return vector of underlying lanelet, empty vector if it is not part of any lanelet
@@ -31,10 +31,16 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <carma_wm/Geometry.h>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <limits>
+#include <future>
 #include <boost/math/special_functions/sign.hpp>
 
 namespace carma_wm
 {
+constexpr size_t CARMAWorldModel::ROUTE_CURSOR_WINDOW;
+
 std::pair<TrackPos, TrackPos> CARMAWorldModel::routeTrackPos(const lanelet::ConstArea& area) const
 {
   // Check if the route was loaded yet
@@ -92,10 +98,36 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::ConstLanelet& lanelet) co
   {
     throw std::invalid_argument("Provided lanelet has invalid centerline containing no points");
   }
+
+  if (!lanelet.inverted())
+  {
+    auto cached = route_lanelet_track_pos_.find(lanelet.id());
+    if (cached != route_lanelet_track_pos_.end())
+    {
+      return cached->second.first;
+    }
+  }
+
   auto front = centerline.front();
   return routeTrackPos(front);
 }
 
+lanelet::Optional<std::pair<TrackPos, TrackPos>> CARMAWorldModel::getRouteLaneletTrackPos(lanelet::Id lanelet_id) const
+{
+  // Check if the route was loaded yet
+  if (!route_)
+  {
+    throw std::invalid_argument("Route has not yet been loaded");
+  }
+
+  auto cached = route_lanelet_track_pos_.find(lanelet_id);
+  if (cached == route_lanelet_track_pos_.end())
+  {
+    return boost::none;
+  }
+  return cached->second;
+}
+
 TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) const
 {
   // Check if the route was loaded yet
@@ -108,10 +140,120 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
   lanelet::Points3d near_points =
       shortest_path_filtered_centerline_view_->pointLayer.nearest(point, 1);  // Find the nearest points
 
+  auto indexes = shortest_path_distance_map_.getIndexFromId(near_points[0].id());
+
+  return routeTrackPosFromNearestPoint(point, indexes.first, indexes.second);
+}
+
+std::vector<TrackPos> CARMAWorldModel::routeTrackPos(const std::vector<lanelet::BasicPoint2d>& points) const
+{
+  // Check if the route was loaded yet
+  if (!route_)
+  {
+    throw std::invalid_argument("Route has not yet been loaded");
+  }
+
+  std::vector<TrackPos> output;
+  output.reserve(points.size());
+
+  bool cursor_set = false;
+  size_t ls_i = 0;
+  size_t p_i = 0;
+  for (const auto& point : points)
+  {
+    // Walk the cursor from the previous match. If the walk cannot guarantee it found the nearest route point then
+    // fall back to the full nearest search used by the single point method
+    if (!cursor_set || !advanceRouteCursor(point, ls_i, p_i))
+    {
+      lanelet::Points3d near_points = shortest_path_filtered_centerline_view_->pointLayer.nearest(point, 1);
+      auto indexes = shortest_path_distance_map_.getIndexFromId(near_points[0].id());
+      ls_i = indexes.first;
+      p_i = indexes.second;
+      cursor_set = true;
+    }
+
+    output.push_back(routeTrackPosFromNearestPoint(point, ls_i, p_i));
+  }
+
+  return output;
+}
+
+bool CARMAWorldModel::advanceRouteCursor(const lanelet::BasicPoint2d& point, size_t& ls_i, size_t& p_i) const
+{
+  auto distance_to = [&](size_t ls, size_t p) { return (shortest_path_centerline_points_[ls][p] - point).norm(); };
+
+  double best_distance = distance_to(ls_i, p_i);
+
+  // Hill climb along the route reference line. The walk is allowed to cross lane change discontinuities
+  bool improved = true;
+  while (improved)
+  {
+    improved = false;
+
+    size_t next_ls = ls_i;
+    size_t next_p = p_i + 1;
+    if (next_p >= shortest_path_centerline_points_[ls_i].size())
+    {
+      next_ls++;
+      next_p = 0;
+    }
+    if (next_ls < shortest_path_centerline_points_.size())
+    {
+      double distance = distance_to(next_ls, next_p);
+      if (distance < best_distance)
+      {
+        best_distance = distance;
+        ls_i = next_ls;
+        p_i = next_p;
+        improved = true;
+        continue;
+      }
+    }
+
+    if (p_i > 0 || ls_i > 0)
+    {
+      size_t prev_ls = p_i > 0 ? ls_i : ls_i - 1;
+      size_t prev_p = p_i > 0 ? p_i - 1 : shortest_path_centerline_points_[prev_ls].size() - 1;
+      double distance = distance_to(prev_ls, prev_p);
+      if (distance < best_distance)
+      {
+        best_distance = distance;
+        ls_i = prev_ls;
+        p_i = prev_p;
+        improved = true;
+      }
+    }
+  }
+
+  // The hill climb may stop in a shallow local minimum so check the whole neighborhood of the match
+  bool refined = true;
+  while (refined)
+  {
+    refined = false;
+    size_t window_start = p_i > ROUTE_CURSOR_WINDOW ? p_i - ROUTE_CURSOR_WINDOW : 0;
+    size_t window_end = std::min(p_i + ROUTE_CURSOR_WINDOW, shortest_path_centerline_points_[ls_i].size() - 1);
+    for (size_t j = window_start; j <= window_end; j++)
+    {
+      double distance = distance_to(ls_i, j);
+      if (distance < best_distance)
+      {
+        best_distance = distance;
+        p_i = j;
+        refined = true;
+      }
+    }
+  }
+
+  // Every route point outside the neighborhood is at least (clearance - best_distance) away from the input point
+  // So if best_distance is less than half the clearance this is also the point a global nearest search would return
+  return best_distance < 0.5 * shortest_path_point_clearances_[ls_i][p_i];
+}
+
+TrackPos CARMAWorldModel::routeTrackPosFromNearestPoint(const lanelet::BasicPoint2d& point, size_t ls_i,
+                                                        size_t p_i) const
+{
   // Match point with linestring using fast map lookup
-  auto lineString_1 =
-      lanelet::utils::to2D(shortest_path_filtered_centerline_view_->lineStringLayer.findUsages(near_points[0])
-                               .front());  // Only need the first index due to nature of route centerline
+  auto lineString_1 = lanelet::utils::to2D(shortest_path_centerlines_[ls_i]);
 
   if (lineString_1.size() == 0)
   {
@@ -131,15 +273,11 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
   // 10. Accumulate previos segment distances if needed.
 
   // Find best route segment
-  lanelet::Id bestRouteSegId;
+  size_t best_ls_i = ls_i;
   TrackPos tp(0, 0);
   // Check for end cases
 
-  auto indexes = shortest_path_distance_map_.getIndexFromId(near_points[0].id());
-  size_t ls_i = indexes.first;
-  size_t p_i = indexes.second;
-
-  if (near_points[0].id() == lineString_1.front().id())
+  if (p_i == 0)
   {  // Nearest point is at the start of a line string
     // Get start point of cur segment and add 1
     auto next_point = lineString_1[1];
@@ -147,7 +285,7 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
 
     if (tp_next.downtrack >= 0 || ls_i == 0)
     {
-      bestRouteSegId = lineString_1.id();
+      best_ls_i = ls_i;
       tp = tp_next;
       // If downtrack is positive then we are on the correct segment
     }
@@ -160,10 +298,10 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
       tp = geometry::trackPos(point, prev_centerline[prev_centerline.size() - 2].basicPoint(),
                               prev_centerline[prev_centerline.size() - 1].basicPoint());
       tp.downtrack += shortest_path_distance_map_.distanceToPointAlongElement(prev_ls_i, prev_centerline.size() - 2);
-      bestRouteSegId = prev_centerline.id();
+      best_ls_i = prev_ls_i;
     }
   }
-  else if (near_points[0].id() == lineString_1.back().id())
+  else if (p_i == lineString_1.size() - 1)
   {  // Nearest point is the end of a line string
 
     // Get end point of cur segment and subtract 1
@@ -178,7 +316,7 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
     if (tp_prev.downtrack < last_seg_length || ls_i == shortest_path_centerlines_.size() - 1)
     {
       // If downtrack is less then seg length then we are on the correct segment
-      bestRouteSegId = lineString_1.id();
+      best_ls_i = ls_i;
       tp = tp_prev;
       tp.downtrack += shortest_path_distance_map_.distanceToPointAlongElement(ls_i, lineString_1.size() - 2);
     }
@@ -187,13 +325,13 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
       // If downtrack is greater then seg length then we need to find the succeeding segment
       auto next_centerline = lanelet::utils::to2D(shortest_path_centerlines_[ls_i + 1]);  // Get prev centerline
       tp = geometry::trackPos(point, next_centerline[0].basicPoint(), next_centerline[1].basicPoint());
-      bestRouteSegId = next_centerline.id();
+      best_ls_i = ls_i + 1;
     }
   }
   else
   {  // The nearest point is in the middle of a line string
     // Graph the two bounding points on the line string and call matchSegment using a 3 element segment
-    // There is a guarantee from the earlier if statements that near_points[0] will always be located at an index within
+    // There is a guarantee from the earlier if statements that p_i will always be located at an index within
     // the exclusive range (0,lineString_1.size() - 1) so no need for range checks
 
     lanelet::BasicLineString2d subSegment = lanelet::BasicLineString2d(
@@ -203,35 +341,15 @@ TrackPos CARMAWorldModel::routeTrackPos(const lanelet::BasicPoint2d& point) cons
 
     tp.downtrack += shortest_path_distance_map_.distanceToPointAlongElement(ls_i, p_i - 1);
 
-    bestRouteSegId = lineString_1.id();
+    best_ls_i = ls_i;
   }
 
   // Accumulate distance
-  auto bestRouteSegIndex = shortest_path_distance_map_.getIndexFromId(bestRouteSegId);
-  tp.downtrack += shortest_path_distance_map_.distanceToElement(bestRouteSegIndex.first);
+  tp.downtrack += shortest_path_distance_map_.distanceToElement(best_ls_i);
 
   return tp;
 }
 
-class LaneletDowntrackPair
-{
-public:
-  lanelet::ConstLanelet lanelet_;
-  double downtrack_ = 0;
-
-  LaneletDowntrackPair(lanelet::ConstLanelet lanelet, double downtrack) : lanelet_(lanelet), downtrack_(downtrack)
-  {
-  }
-  bool operator<(const LaneletDowntrackPair& pair) const
-  {
-    return this->downtrack_ < pair.downtrack_;
-  }
-  bool operator>(const LaneletDowntrackPair& pair) const
-  {
-    return this->downtrack_ > pair.downtrack_;
-  }
-};
-
 std::vector<lanelet::ConstLanelet> CARMAWorldModel::getLaneletsBetween(double start, double end, bool shortest_path_only,
                                                                        bool bounds_inclusive) const
 {
@@ -245,79 +363,70 @@ std::vector<lanelet::ConstLanelet> CARMAWorldModel::getLaneletsBetween(double st
     throw std::invalid_argument("Start distance is greater than or equal to end distance");
   }
 
-  std::vector<lanelet::ConstLanelet> output;
-  std::priority_queue<LaneletDowntrackPair, std::vector<LaneletDowntrackPair>, std::greater<LaneletDowntrackPair>>
-      prioritized_lanelets;
-
-  auto lanelet_map = route_->laneletMap();
-  for (lanelet::ConstLanelet lanelet : lanelet_map->laneletLayer)
+  if (!bounds_inclusive) // reduce bounds slightly to avoid including exact bounds
   {
-    if (shortest_path_only && !shortest_path_view_->laneletLayer.exists(lanelet.id()))
-    {
-      continue;  // Continue if we are only evaluating the shortest path and this lanelet is not part of it
-    }
-    lanelet::ConstLineString2d centerline = lanelet::utils::to2D(lanelet.centerline());
+    start += 0.00001;
+    end -= 0.00001;
+  }
 
-    auto front = centerline.front();
-    auto back = centerline.back();
-    TrackPos min = routeTrackPos(front);
-    TrackPos max = routeTrackPos(back);
+  // The intervals are sorted by their start downtrack so only the intervals whose start lies in
+  // [start - max_interval_length, end] can overlap the requested range
+  auto first = std::lower_bound(route_lanelet_intervals_.begin(), route_lanelet_intervals_.end(),
+                                start - max_route_lanelet_interval_length_,
+                                [](const LaneletDowntrackInterval& interval, double downtrack) { return interval.start < downtrack; });
+  auto last = std::upper_bound(first, route_lanelet_intervals_.end(), end,
+                               [](double downtrack, const LaneletDowntrackInterval& interval) { return downtrack < interval.start; });
 
-    if (!bounds_inclusive) // reduce bounds slightly to avoid including exact bounds
+  std::vector<const LaneletDowntrackInterval*> matches;
+  for (auto it = first; it != last; it++)
+  {
+    if (shortest_path_only && it->shortest_path_index < 0)
     {
-      if (std::max(min.downtrack, start + 0.00001) > std::min(max.downtrack, end - 0.00001))
-      {  // Check for 1d intersection
-        // No intersection so continue
-        continue;
-      }
+      continue;  // Continue if we are only evaluating the shortest path and this lanelet is not part of it
     }
-    else
-    {
-      if (std::max(min.downtrack, start) > std::min(max.downtrack, end))
-      {  // Check for 1d intersection
-        // No intersection so continue
-        continue;
-      }
+    if (std::max(it->start, start) > std::min(it->end, end))
+    {  // Check for 1d intersection
+      // No intersection so continue
+      continue;
     }
     // Intersection has occurred so add lanelet to list
-    LaneletDowntrackPair pair(lanelet, min.downtrack);
-    prioritized_lanelets.push(pair);
+    matches.push_back(&(*it));
   }
 
-  output.reserve(prioritized_lanelets.size());
-  while (!prioritized_lanelets.empty())
+  if (shortest_path_only)
   {
-    auto pair = prioritized_lanelets.top();
-    prioritized_lanelets.pop();
-    output.push_back(pair.lanelet_);
+    // Sort lanelets according to shortest path if using shortest path
+    std::sort(matches.begin(), matches.end(), [](const LaneletDowntrackInterval* a, const LaneletDowntrackInterval* b) {
+      return a->shortest_path_index < b->shortest_path_index;
+    });
   }
 
-  if(!shortest_path_only){
-    return output;
-  }
-  
-  //Sort lanelets according to shortest path if using shortest path
-  std::vector<lanelet::ConstLanelet> sorted_output;
-  for(auto llt : route_->shortestPath()){
-    for(int i=0; i < output.size();i++){
-      if(llt.id() == output[i].id()){
-        sorted_output.push_back(llt);
-        break;
-      }
-    }
+  std::vector<lanelet::ConstLanelet> output;
+  output.reserve(matches.size());
+  for (auto interval : matches)
+  {
+    output.push_back(interval->lanelet);
   }
 
-  return sorted_output;
+  return output;
 }
 
 std::vector<lanelet::BasicPoint2d> CARMAWorldModel::sampleRoutePoints(double start_downtrack, double end_downtrack,
                                                                       double step_size) const
 {
   std::vector<lanelet::BasicPoint2d> output;
+  sampleRoutePoints(start_downtrack, end_downtrack, step_size, output);
+  return output;
+}
+
+void CARMAWorldModel::sampleRoutePoints(double start_downtrack, double end_downtrack, double step_size,
+                                        std::vector<lanelet::BasicPoint2d>& output) const
+{
+  output.clear();
   if (!route_)
   {
     ROS_WARN_STREAM("Route has not yet been loaded");
-    return output;
+    return;
   }
 
   double route_end = getRouteEndTrackPos().downtrack;
@@ -326,29 +435,175 @@ std::vector<lanelet::BasicPoint2d> CARMAWorldModel::sampleRoutePoints(double sta
       start_downtrack > end_downtrack)
   {
     ROS_WARN_STREAM("Invalid input downtracks");
-    return output;
+    return;
   }
 
-  TrackPos route_pos(start_downtrack, 0);
-
   if (end_downtrack == start_downtrack)
   {
-    output.emplace_back(*(pointFromRouteTrackPos(route_pos)));  // If a single point was provided return that point
-    return output;
+    output.emplace_back(*(pointFromRouteTrackPos(TrackPos(start_downtrack, 0))));  // If a single point was provided return that point
+    return;
+  }
+
+  if (step_size <= 0)
+  {
+    ROS_WARN_STREAM("Invalid step size: " << step_size);
+    return;
   }
 
   output.reserve(2 + (end_downtrack - start_downtrack) / step_size);
+
+  // Locate the starting point once then walk the reference line forward as the downtrack increases
+  size_t ls_i = shortest_path_distance_map_.getElementIndexByDistance(start_downtrack);
+  size_t p_i = shortest_path_distance_map_.getPointIndexByDistance(
+      ls_i, start_downtrack - shortest_path_distance_map_.distanceToElement(ls_i));
+
+  auto sample = [&](double downtrack) {
+    double relative_downtrack = advanceReferenceLine(downtrack, ls_i, p_i);
+    output.emplace_back(interpolateReferenceLine(ls_i, p_i, relative_downtrack));
+  };
+
   double downtrack = start_downtrack;
   while (downtrack < end_downtrack)
   {
-    route_pos.downtrack = downtrack;
-    output.emplace_back(*(pointFromRouteTrackPos(route_pos)));
+    sample(downtrack);
     downtrack += step_size;
   }
 
-  route_pos.downtrack = end_downtrack;
-  output.emplace_back(*(pointFromRouteTrackPos(route_pos)));
-  return output;
+  sample(end_downtrack);
+}
+
+void CARMAWorldModel::sampleRouteProfile(double start_downtrack, double end_downtrack, double step_size,
+                                         std::vector<RouteProfileSample>& output) const
+{
+  output.clear();
+  if (!route_)
+  {
+    ROS_WARN_STREAM("Route has not yet been loaded");
+    return;
+  }
+
+  double route_end = getRouteEndTrackPos().downtrack;
+
+  if (start_downtrack < 0 || start_downtrack > route_end || end_downtrack < 0 || end_downtrack > route_end ||
+      start_downtrack > end_downtrack)
+  {
+    ROS_WARN_STREAM("Invalid input downtracks");
+    return;
+  }
+
+  if (end_downtrack != start_downtrack && step_size <= 0)
+  {
+    ROS_WARN_STREAM("Invalid step size: " << step_size);
+    return;
+  }
+
+  if (end_downtrack != start_downtrack)
+  {
+    output.reserve(2 + (end_downtrack - start_downtrack) / step_size);
+  }
+
+  size_t ls_i = shortest_path_distance_map_.getElementIndexByDistance(start_downtrack);
+  size_t p_i = shortest_path_distance_map_.getPointIndexByDistance(
+      ls_i, start_downtrack - shortest_path_distance_map_.distanceToElement(ls_i));
+
+  auto next_speed_limit =
+      std::upper_bound(route_speed_limit_downtracks_.begin(), route_speed_limit_downtracks_.end(), start_downtrack);
+
+  auto sample = [&](double downtrack) {
+    double relative_downtrack = advanceReferenceLine(downtrack, ls_i, p_i);
+
+    while (next_speed_limit != route_speed_limit_downtracks_.end() && *next_speed_limit <= downtrack)
+    {
+      next_speed_limit++;
+    }
+
+    // Linearly interpolate the profile between the surrounding reference line points
+    const RouteProfilePoint& prior = route_profile_points_[ls_i][p_i];
+    const RouteProfilePoint& next = route_profile_points_[ls_i][std::min(p_i + 1, route_profile_points_[ls_i].size() - 1)];
+    double ratio = 0;
+    if (p_i + 1 < shortest_path_distance_map_.size(ls_i))
+    {
+      double prior_downtrack = shortest_path_distance_map_.distanceToPointAlongElement(ls_i, p_i);
+      double segment_length = shortest_path_distance_map_.distanceToPointAlongElement(ls_i, p_i + 1) - prior_downtrack;
+      if (segment_length > 0)
+      {
+        ratio = std::min(1.0, std::max(0.0, (relative_downtrack - prior_downtrack) / segment_length));
+      }
+    }
+
+    RouteProfileSample profile;
+    profile.downtrack = downtrack;
+    profile.point = interpolateReferenceLine(ls_i, p_i, relative_downtrack);
+    profile.heading = prior.heading + ratio * std::remainder(next.heading - prior.heading, 2 * M_PI);
+    profile.curvature = prior.curvature + ratio * (next.curvature - prior.curvature);
+    profile.left_bound = prior.left_bound + ratio * (next.left_bound - prior.left_bound);
+    profile.right_bound = prior.right_bound + ratio * (next.right_bound - prior.right_bound);
+    if (!route_speed_limits_.empty())
+    {
+      size_t speed_index = next_speed_limit == route_speed_limit_downtracks_.begin() ?
+                               0 :
+                               (next_speed_limit - route_speed_limit_downtracks_.begin()) - 1;
+      profile.speed_limit = route_speed_limits_[speed_index];
+    }
+    output.push_back(profile);
+  };
+
+  double downtrack = start_downtrack;
+  while (downtrack < end_downtrack)
+  {
+    sample(downtrack);
+    downtrack += step_size;
+  }
+
+  sample(end_downtrack);
+}
+
+double CARMAWorldModel::advanceReferenceLine(double downtrack, size_t& ls_i, size_t& p_i) const
+{
+  // Advance to the last linestring starting at or before the downtrack
+  while (ls_i + 1 < shortest_path_distance_map_.size() &&
+         shortest_path_distance_map_.distanceToElement(ls_i + 1) <= downtrack)
+  {
+    ls_i++;
+    p_i = 0;
+  }
+  double relative_downtrack = downtrack - shortest_path_distance_map_.distanceToElement(ls_i);
+
+  // Advance to the last point at or before the downtrack
+  while (p_i + 1 < shortest_path_distance_map_.size(ls_i) &&
+         shortest_path_distance_map_.distanceToPointAlongElement(ls_i, p_i + 1) <= relative_downtrack)
+  {
+    p_i++;
+  }
+  return relative_downtrack;
+}
+
+lanelet::BasicPoint2d CARMAWorldModel::interpolateReferenceLine(size_t ls_i, size_t prior_idx,
+                                                                double relative_downtrack) const
+{
+  const auto& linestring = shortest_path_centerline_points_[ls_i];
+  size_t next_idx = std::min(prior_idx + 1, linestring.size() - 1);
+
+  if (prior_idx == next_idx)
+  {  // If both indexes are the same we are on the point
+    return linestring[prior_idx];
+  }
+
+  double prior_downtrack = shortest_path_distance_map_.distanceToPointAlongElement(ls_i, prior_idx);
+  double next_downtrack = shortest_path_distance_map_.distanceToPointAlongElement(ls_i, next_idx);
+
+  double prior_to_next_dist = next_downtrack - prior_downtrack;
+  double prior_to_target_dist = relative_downtrack - prior_downtrack;
+  double interpolation_percentage = 0;
+  if (prior_to_next_dist >= 0.000001)
+  {
+    interpolation_percentage = prior_to_target_dist / prior_to_next_dist;
+  }
+
+  const auto& prior_point = linestring[prior_idx];
+  auto delta_vec = linestring[next_idx] - prior_point;
+  return lanelet::BasicPoint2d(prior_point.x() + interpolation_percentage * delta_vec.x(),
+                               prior_point.y() + interpolation_percentage * delta_vec.y());
 }
 
 boost::optional<lanelet::BasicPoint2d> CARMAWorldModel::pointFromRouteTrackPos(const TrackPos& route_pos) const
@@ -372,17 +627,14 @@ boost::optional<lanelet::BasicPoint2d> CARMAWorldModel::pointFromRouteTrackPos(c
 
   // Use fast lookup to identify the points before and after the provided downtrack on the route
   size_t ls_i = shortest_path_distance_map_.getElementIndexByDistance(downtrack); // Get the linestring matching the provided downtrack
-  double ls_length = shortest_path_distance_map_.elementLength(ls_i);
   double ls_downtrack = shortest_path_distance_map_.distanceToElement(ls_i);
   auto linestring = shortest_path_centerlines_[ls_i];
 
-  // Use the percentage traveled along this linestring to index into the cenertline
+  // Search the precomputed point distances of this linestring for the segment containing the downtrack
   double relative_downtrack = downtrack - ls_downtrack;
-  double lanelet_percentage = relative_downtrack / ls_length;
   int centerline_size = linestring.size();
-  int index = lanelet_percentage * centerline_size;
-  int prior_idx = std::min(index, centerline_size - 1);
-  int next_idx = std::min(index + 1, centerline_size - 1);
+  int prior_idx = shortest_path_distance_map_.getPointIndexByDistance(ls_i, relative_downtrack);
+  int next_idx = std::min(prior_idx + 1, centerline_size - 1);
 
   // This if block handles the edge case where the downtrack distance has landed exactly on an existing point
   if (prior_idx == next_idx)
@@ -469,15 +721,46 @@ TrackPos CARMAWorldModel::getRouteEndTrackPos() const
   return p;
 }
 
-void CARMAWorldModel::setMap(lanelet::LaneletMapPtr map, size_t map_version)
+void CARMAWorldModel::setMap(lanelet::LaneletMapPtr map, size_t map_version, bool recompute_routing_graph)
 {
+  bool same_map = semantic_map_ == map;
   semantic_map_ = map;
   map_version_ = map_version;
+
+  if (!recompute_routing_graph && same_map && map_routing_graph_)
+  {
+    ROS_DEBUG_STREAM("Reusing existing routing graph for map version " << map_version_);
+    lanelet_index_valid_ = false; // The caller reindexes the lanelets it edited with updateLaneletIndex()
+    return;
+  }
+
+  computeTrafficRulesCache();
+
   // Build routing graph from map
   TrafficRulesConstPtr traffic_rules = *(getTrafficRules(lanelet::Participants::Vehicle));
 
   lanelet::routing::RoutingGraphUPtr map_graph = lanelet::routing::RoutingGraph::build(*semantic_map_, *traffic_rules);
   map_routing_graph_ = std::move(map_graph);
+
+  lanelet_index_.build(semantic_map_->laneletLayer);
+  lanelet_index_valid_ = true;
+  centerline_indexes_.clear();
+
+  // Lane changing objects are indexed using the routing graph
+  computeRoadwayObjectIndex();
+
+  computeSpeedLimits();
+}
+
+void CARMAWorldModel::updateLaneletIndex(const std::vector<lanelet::Id>& lanelet_ids)
+{
+  if (!semantic_map_)
+  {
+    return;
+  }
+  lanelet_index_.update(semantic_map_->laneletLayer, lanelet_ids);
+  lanelet_index_valid_ = true;
+  centerline_indexes_.clear();
 }
 
 size_t CARMAWorldModel::getMapVersion() const 
@@ -487,19 +770,91 @@ size_t CARMAWorldModel::getMapVersion() const
 
 lanelet::LaneletMapPtr CARMAWorldModel::getMutableMap() const
 {
+  // The caller may edit the geometry of any lanelet so the index can no longer be trusted
+  lanelet_index_valid_ = false;
   return semantic_map_;
 }
 
 void CARMAWorldModel::setRoute(LaneletRoutePtr route)
 {
   route_ = route;
+  route_lanelet_track_pos_.clear();  // Cleared so stale entries are not used while the route geometry is rebuilt
   lanelet::ConstLanelets path_lanelets(route_->shortestPath().begin(), route_->shortestPath().end());
   shortest_path_view_ = lanelet::utils::createConstSubmap(path_lanelets, {});
   computeDowntrackReferenceLine();
+  computeRouteLaneletIntervals();
+  computeRouteSpeedLimits();
   route_length_ = routeTrackPos(route_->getEndPoint().basicPoint2d()).downtrack;  // Cache the route length with
                                                                                   // consideration for endpoint
 }
 
+void CARMAWorldModel::computeRouteLaneletIntervals()
+{
+  std::unordered_map<lanelet::Id, long> shortest_path_indexes;
+  long path_index = 0;
+  for (const auto& ll : route_->shortestPath())
+  {
+    shortest_path_indexes.emplace(ll.id(), path_index);
+    path_index++;
+  }
+
+  std::vector<LaneletDowntrackInterval> intervals;
+  intervals.reserve(route_->laneletMap()->laneletLayer.size());
+  double max_length = 0;
+
+  std::unordered_map<lanelet::Id, std::pair<TrackPos, TrackPos>> track_positions;
+  track_positions.reserve(3 * route_->laneletMap()->laneletLayer.size());
+
+  auto centerline_track_pos = [this](const lanelet::ConstLanelet& ll) {
+    lanelet::ConstLineString2d centerline = lanelet::utils::to2D(ll.centerline());
+    return std::make_pair(routeTrackPos(centerline.front()), routeTrackPos(centerline.back()));
+  };
+
+  for (lanelet::ConstLanelet ll : route_->laneletMap()->laneletLayer)
+  {
+    auto track_pos = centerline_track_pos(ll);
+    track_positions.emplace(ll.id(), track_pos);
+
+    LaneletDowntrackInterval interval;
+    interval.lanelet = ll;
+    interval.start = track_pos.first.downtrack;
+    interval.end = track_pos.second.downtrack;
+
+    auto index_it = shortest_path_indexes.find(ll.id());
+    if (index_it != shortest_path_indexes.end())
+    {
+      interval.shortest_path_index = index_it->second;
+    }
+
+    max_length = std::max(max_length, interval.end - interval.start);
+    intervals.push_back(interval);
+  }
+
+  std::stable_sort(intervals.begin(), intervals.end(),
+                   [](const LaneletDowntrackInterval& a, const LaneletDowntrackInterval& b) { return a.start < b.start; });
+
+  // Lanelets beside the route are looked up by lane change and obstacle logic so they are included as well
+  if (map_routing_graph_)
+  {
+    for (const auto& interval : intervals)
+    {
+      for (const auto& neighbor :
+           { map_routing_graph_->left(interval.lanelet), map_routing_graph_->adjacentLeft(interval.lanelet),
+             map_routing_graph_->right(interval.lanelet), map_routing_graph_->adjacentRight(interval.lanelet) })
+      {
+        if (neighbor && track_positions.find(neighbor->id()) == track_positions.end())
+        {
+          track_positions.emplace(neighbor->id(), centerline_track_pos(*neighbor));
+        }
+      }
+    }
+  }
+
+  route_lanelet_intervals_ = std::move(intervals);
+  max_route_lanelet_interval_length_ = max_length;
+  route_lanelet_track_pos_ = std::move(track_positions);
+}
+
 void CARMAWorldModel::setRouteEndPoint(const lanelet::BasicPoint3d& end_point)
 {
   lanelet::ConstPoint3d const_end_point{ lanelet::utils::getId(), end_point.x(), end_point.y(), end_point.z() };
@@ -532,6 +887,22 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
 
   std::vector<lanelet::LineString3d> lineStrings;  // List of continuos line strings representing segments of the route
                                                    // reference line
+  std::vector<std::vector<RouteProfilePoint>> profiles;  // Lateral bounds of each point in lineStrings
+
+  // Records the distances from the centerline points of a lanelet to its bounds
+  auto append_bounds = [&profiles](const lanelet::ConstLanelet& ll, const lanelet::LineString3d& centerline,
+                                   size_t offset) {
+    lanelet::BasicLineString2d left = ll.leftBound2d().basicLineString();
+    lanelet::BasicLineString2d right = ll.rightBound2d().basicLineString();
+    for (size_t i = offset; i < centerline.size(); i++)
+    {
+      lanelet::BasicPoint2d point = lanelet::utils::to2D(centerline[i]).basicPoint();
+      RouteProfilePoint profile;
+      profile.left_bound = boost::geometry::distance(point, left);
+      profile.right_bound = boost::geometry::distance(point, right);
+      profiles.back().push_back(profile);
+    }
+  };
 
   bool first = true;
   size_t next_index = 0;
@@ -542,6 +913,8 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
     if (first)
     {  // For the first lanelet store its centerline and length
       lineStrings.push_back(copyConstructLineString(ll.centerline()));
+      profiles.emplace_back();
+      append_bounds(ll, lineStrings.back(), 0);
       first = false;
     }
     if (next_index < shortest_path.size())
@@ -563,6 +936,7 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
           throw std::invalid_argument("Cannot process route with lanelet containing very short centerline");
         }
         lineStrings.back().insert(lineStrings.back().end(), nextCenterline.begin() + offset, nextCenterline.end());
+        append_bounds(nextLanelet, nextCenterline, offset);
       }
       else if (connectionCount == 0)
       {
@@ -575,6 +949,7 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
         empty_linestring.setId(lanelet::utils::getId());
         distance_map.pushBack(lanelet::utils::to2D(lineStrings.back()));
         lineStrings.push_back(empty_linestring);
+        profiles.emplace_back();
       }
       else
       {
@@ -584,7 +959,10 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
   }
   // Copy values to member variables
   while (lineStrings.back().size() == 0)
+  {
     lineStrings.pop_back();  // clear empty linestrings that was never used in the end
+    profiles.pop_back();
+  }
   shortest_path_centerlines_ = lineStrings;
   shortest_path_distance_map_ = distance_map;
 
@@ -598,38 +976,268 @@ void CARMAWorldModel::computeDowntrackReferenceLine()
   // Since our copy constructed linestrings do not contain references to lanelets they can be added to a full map
   // instead of a submap
   shortest_path_filtered_centerline_view_ = lanelet::utils::createMap(shortest_path_centerlines_);
-}
 
-LaneletRoutingGraphConstPtr CARMAWorldModel::getMapRoutingGraph() const
-{
-  return std::static_pointer_cast<const lanelet::routing::RoutingGraph>(map_routing_graph_);  // Cast pointer to const
-                                                                                              // variant
+  computeRouteCursorClearances();
+
+  route_profile_points_ = std::move(profiles);
+  computeRouteProfileGeometry();
 }
 
-lanelet::Optional<TrafficRulesConstPtr> CARMAWorldModel::getTrafficRules(const std::string& participant) const
+void CARMAWorldModel::computeRouteProfileGeometry()
 {
-  lanelet::Optional<TrafficRulesConstPtr> optional_ptr;
-  // Create carma traffic rules object
-  try
+  for (size_t ls_i = 0; ls_i < shortest_path_centerline_points_.size(); ls_i++)
   {
-    lanelet::traffic_rules::TrafficRulesUPtr traffic_rules = lanelet::traffic_rules::TrafficRulesFactory::create(
-        lanelet::traffic_rules::CarmaUSTrafficRules::Location, participant);
-
-    auto carma_traffic_rules = std::make_shared<lanelet::traffic_rules::CarmaUSTrafficRules>();
+    const auto& points = shortest_path_centerline_points_[ls_i];
+    auto& profiles = route_profile_points_[ls_i];
+    if (points.empty())
+    {
+      continue;
+    }
 
-    carma_traffic_rules = std::static_pointer_cast<lanelet::traffic_rules::CarmaUSTrafficRules>(
-        lanelet::traffic_rules::TrafficRulesPtr(std::move(traffic_rules)));
-    carma_traffic_rules->setConfigSpeedLimit(config_speed_limit_);
+    std::vector<double> headings = geometry::compute_tangent_orientations(points);
 
-    optional_ptr = std::static_pointer_cast<const lanelet::traffic_rules::CarmaUSTrafficRules>(carma_traffic_rules);
+    for (size_t p_i = 0; p_i < points.size(); p_i++)
+    {
+      profiles[p_i].heading = headings[p_i];
+
+      // Rate of change of heading using the neighboring points
+      size_t prev = p_i == 0 ? 0 : p_i - 1;
+      size_t next = std::min(p_i + 1, points.size() - 1);
+      double arc_length = shortest_path_distance_map_.distanceToPointAlongElement(ls_i, next) -
+                          shortest_path_distance_map_.distanceToPointAlongElement(ls_i, prev);
+      if (arc_length > 0)
+      {
+        double heading_change = std::remainder(headings[next] - headings[prev], 2 * M_PI);
+        profiles[p_i].curvature = std::fabs(heading_change) / arc_length;
+      }
+    }
   }
-  catch (const lanelet::InvalidInputError& e)
+}
+
+void CARMAWorldModel::computeRouteCursorClearances()
+{
+  shortest_path_centerline_points_.clear();
+  shortest_path_point_clearances_.clear();
+  shortest_path_centerline_points_.reserve(shortest_path_centerlines_.size());
+  shortest_path_point_clearances_.reserve(shortest_path_centerlines_.size());
+
+  for (const auto& centerline : shortest_path_centerlines_)
   {
-    return optional_ptr;
+    shortest_path_centerline_points_.emplace_back(lanelet::utils::to2D(centerline).basicLineString());
   }
 
-  return optional_ptr;
-}
+  // Enough neighbors are requested that at least one of them must lie outside the cursor window of the query point
+  const unsigned candidate_count = 2 * ROUTE_CURSOR_WINDOW + 2;
+
+  for (size_t ls_i = 0; ls_i < shortest_path_centerline_points_.size(); ls_i++)
+  {
+    std::vector<double> clearances;
+    clearances.reserve(shortest_path_centerline_points_[ls_i].size());
+
+    for (size_t p_i = 0; p_i < shortest_path_centerline_points_[ls_i].size(); p_i++)
+    {
+      const auto& point = shortest_path_centerline_points_[ls_i][p_i];
+      lanelet::Points3d near_points =
+          shortest_path_filtered_centerline_view_->pointLayer.nearest(point, candidate_count);
+
+      double clearance = std::numeric_limits<double>::infinity();
+      double farthest_candidate = 0;
+      bool found_outside_window = false;
+      for (const auto& near_point : near_points)
+      {
+        double distance = (lanelet::utils::to2D(near_point).basicPoint() - point).norm();
+        farthest_candidate = std::max(farthest_candidate, distance);
+
+        auto indexes = shortest_path_distance_map_.getIndexFromId(near_point.id());
+        size_t index_diff = indexes.second > p_i ? indexes.second - p_i : p_i - indexes.second;
+        if (indexes.first != ls_i || index_diff > ROUTE_CURSOR_WINDOW)
+        {
+          clearance = std::min(clearance, distance);
+          found_outside_window = true;
+        }
+      }
+
+      // If every candidate was inside the window then all unreturned points are at least as far as the farthest
+      // candidate. If the search returned fewer points than requested then there are no other points at all
+      if (!found_outside_window && near_points.size() == candidate_count)
+      {
+        clearance = farthest_candidate;
+      }
+
+      clearances.push_back(clearance);
+    }
+
+    shortest_path_point_clearances_.emplace_back(std::move(clearances));
+  }
+}
+
+LaneletRoutingGraphConstPtr CARMAWorldModel::getMapRoutingGraph() const
+{
+  return std::static_pointer_cast<const lanelet::routing::RoutingGraph>(map_routing_graph_);  // Cast pointer to const
+                                                                                              // variant
+}
+
+lanelet::Optional<TrafficRulesConstPtr> CARMAWorldModel::getTrafficRules(const std::string& participant) const
+{
+  auto cached_rules = traffic_rules_cache_.find(participant);
+  if (cached_rules != traffic_rules_cache_.end())
+  {
+    return cached_rules->second;
+  }
+
+  return buildTrafficRules(participant);
+}
+
+lanelet::Optional<TrafficRulesConstPtr> CARMAWorldModel::buildTrafficRules(const std::string& participant) const
+{
+  lanelet::Optional<TrafficRulesConstPtr> optional_ptr;
+  // Create carma traffic rules object
+  try
+  {
+    lanelet::traffic_rules::TrafficRulesUPtr traffic_rules = lanelet::traffic_rules::TrafficRulesFactory::create(
+        lanelet::traffic_rules::CarmaUSTrafficRules::Location, participant);
+
+    auto carma_traffic_rules = std::make_shared<lanelet::traffic_rules::CarmaUSTrafficRules>();
+
+    carma_traffic_rules = std::static_pointer_cast<lanelet::traffic_rules::CarmaUSTrafficRules>(
+        lanelet::traffic_rules::TrafficRulesPtr(std::move(traffic_rules)));
+    carma_traffic_rules->setConfigSpeedLimit(config_speed_limit_);
+
+    optional_ptr = std::static_pointer_cast<const lanelet::traffic_rules::CarmaUSTrafficRules>(carma_traffic_rules);
+  }
+  catch (const lanelet::InvalidInputError& e)
+  {
+    return optional_ptr;
+  }
+
+  return optional_ptr;
+}
+
+void CARMAWorldModel::computeTrafficRulesCache()
+{
+  traffic_rules_cache_.clear();
+  for (const std::string& participant :
+       { lanelet::Participants::Vehicle, lanelet::Participants::VehicleCar, lanelet::Participants::VehicleTruck,
+         lanelet::Participants::Bicycle, lanelet::Participants::Pedestrian })
+  {
+    auto traffic_rules = buildTrafficRules(participant);
+    if (traffic_rules)
+    {
+      traffic_rules_cache_[participant] = traffic_rules.get();
+    }
+  }
+}
+
+void CARMAWorldModel::computeSpeedLimits()
+{
+  lanelet_speed_limits_.clear();
+  auto traffic_rules = getTrafficRules(lanelet::Participants::Vehicle);
+  if (semantic_map_ && traffic_rules)
+  {
+    lanelet_speed_limits_.reserve(semantic_map_->laneletLayer.size());
+    for (const auto& llt : semantic_map_->laneletLayer)
+    {
+      try
+      {
+        lanelet_speed_limits_[llt.id()] = (*traffic_rules)->speedLimit(llt).speedLimit.value();
+      }
+      catch (const std::exception& e)
+      {
+        // Lanelets without a valid speed limit are left out of the cache and are evaluated on request
+        ROS_DEBUG_STREAM("Could not cache speed limit of lanelet " << llt.id() << ": " << e.what());
+      }
+    }
+  }
+
+  computeRouteSpeedLimits();
+}
+
+void CARMAWorldModel::updateSpeedLimits(const std::vector<lanelet::Id>& lanelet_ids)
+{
+  auto traffic_rules = getTrafficRules(lanelet::Participants::Vehicle);
+  if (!semantic_map_ || !traffic_rules)
+  {
+    return;
+  }
+
+  for (auto id : lanelet_ids)
+  {
+    auto llt = semantic_map_->laneletLayer.find(id);
+    if (llt == semantic_map_->laneletLayer.end())
+    {
+      continue;
+    }
+
+    try
+    {
+      lanelet_speed_limits_[id] = (*traffic_rules)->speedLimit(*llt).speedLimit.value();
+    }
+    catch (const std::exception& e)
+    {
+      lanelet_speed_limits_.erase(id);
+      ROS_DEBUG_STREAM("Could not cache speed limit of lanelet " << id << ": " << e.what());
+    }
+  }
+
+  computeRouteSpeedLimits();
+}
+
+void CARMAWorldModel::computeRouteSpeedLimits()
+{
+  route_speed_limit_downtracks_.clear();
+  route_speed_limits_.clear();
+
+  // route_lanelet_intervals_ is sorted by start downtrack
+  for (const auto& interval : route_lanelet_intervals_)
+  {
+    if (interval.shortest_path_index < 0)
+    {
+      continue;
+    }
+    try
+    {
+      double speed_limit = getSpeedLimit(interval.lanelet);
+      route_speed_limit_downtracks_.push_back(interval.start);
+      route_speed_limits_.push_back(speed_limit);
+    }
+    catch (const std::exception& e)
+    {
+      // The previous lanelet's speed limit is extended over this lanelet
+      ROS_WARN_STREAM("Route lanelet " << interval.lanelet.id() << " has no valid speed limit: " << e.what());
+    }
+  }
+}
+
+double CARMAWorldModel::getSpeedLimit(const lanelet::ConstLanelet& lanelet) const
+{
+  auto speed_limit = lanelet_speed_limits_.find(lanelet.id());
+  if (speed_limit != lanelet_speed_limits_.end())
+  {
+    return speed_limit->second;
+  }
+
+  // Lanelets which are not part of the current map are evaluated directly
+  auto traffic_rules = getTrafficRules(lanelet::Participants::Vehicle);
+  if (!traffic_rules)
+  {
+    throw std::invalid_argument("Valid traffic rules object could not be built");
+  }
+  return (*traffic_rules)->speedLimit(lanelet).speedLimit.value();
+}
+
+double CARMAWorldModel::getRouteSpeedLimit(double downtrack) const
+{
+  if (!route_ || route_speed_limits_.empty())
+  {
+    throw std::invalid_argument("Route has not yet been loaded");
+  }
+
+  // Find the last lanelet which starts at or before the downtrack
+  auto next = std::upper_bound(route_speed_limit_downtracks_.begin(), route_speed_limit_downtracks_.end(), downtrack);
+  size_t index = next == route_speed_limit_downtracks_.begin() ? 0 : (next - route_speed_limit_downtracks_.begin()) - 1;
+
+  return route_speed_limits_[index];
+}
 
 lanelet::Optional<cav_msgs::RoadwayObstacle>
 CARMAWorldModel::toRoadwayObstacle(const cav_msgs::ExternalObject& object) const
@@ -639,14 +1247,18 @@ CARMAWorldModel::toRoadwayObstacle(const cav_msgs::ExternalObject& object) const
     throw std::invalid_argument("Map is not set or does not contain lanelets");
   }
 
-  lanelet::BasicPoint2d object_center(object.pose.pose.position.x, object.pose.pose.position.y);
-
   auto nearestLaneletBoost = getIntersectingLanelet(object);
 
   if (!nearestLaneletBoost)
     return boost::none;
 
-  lanelet::Lanelet nearestLanelet = nearestLaneletBoost.get();
+  return obstacleOnLanelet(object, nearestLaneletBoost.get());
+}
+
+cav_msgs::RoadwayObstacle CARMAWorldModel::obstacleOnLanelet(const cav_msgs::ExternalObject& object,
+                                                             const lanelet::ConstLanelet& nearestLanelet) const
+{
+  lanelet::BasicPoint2d object_center(object.pose.pose.position.x, object.pose.pose.position.y);
 
   cav_msgs::RoadwayObstacle obs;
   obs.object = object;
@@ -654,21 +1266,27 @@ CARMAWorldModel::toRoadwayObstacle(const cav_msgs::ExternalObject& object) const
       cav_msgs::ConnectedVehicleType::NOT_CONNECTED;  // TODO No clear way to determine automation state at this time
   obs.lanelet_id = nearestLanelet.id();
 
-  carma_wm::TrackPos obj_track_pos = geometry::trackPos(nearestLanelet, object_center);
+  carma_wm::TrackPos obj_track_pos = laneletTrackPos(nearestLanelet, object_center);
   obs.down_track = obj_track_pos.downtrack;
   obs.cross_track = obj_track_pos.crosstrack;
 
-  for (auto prediction : object.predictions)
+  obs.predicted_lanelet_ids.reserve(object.predictions.size());
+  obs.predicted_cross_tracks.reserve(object.predictions.size());
+  obs.predicted_down_tracks.reserve(object.predictions.size());
+  obs.predicted_lanelet_id_confidences.reserve(object.predictions.size());
+  obs.predicted_cross_track_confidences.reserve(object.predictions.size());
+  obs.predicted_down_track_confidences.reserve(object.predictions.size());
+
+  // Predictions are ordered in time so each search starts from the lanelet of the previous prediction
+  lanelet::ConstLanelet predNearestLanelet = nearestLanelet;
+  for (const auto& prediction : object.predictions)
   {
-    // Compute prediction polygon
-    lanelet::BasicPolygon2d prediction_polygon =
-        geometry::objectToMapPolygon(prediction.predicted_position, object.size);
     lanelet::BasicPoint2d prediction_center(prediction.predicted_position.position.x,
                                             prediction.predicted_position.position.y);
 
-    auto predNearestLanelet = semantic_map_->laneletLayer.nearest(prediction_center, 1)[0];
+    predNearestLanelet = predictionLanelet(prediction_center, predNearestLanelet);
 
-    carma_wm::TrackPos pred_track_pos = geometry::trackPos(predNearestLanelet, prediction_center);
+    carma_wm::TrackPos pred_track_pos = laneletTrackPos(predNearestLanelet, prediction_center);
 
     obs.predicted_lanelet_ids.emplace_back(predNearestLanelet.id());
     obs.predicted_cross_tracks.emplace_back(pred_track_pos.crosstrack);
@@ -684,9 +1302,227 @@ CARMAWorldModel::toRoadwayObstacle(const cav_msgs::ExternalObject& object) const
   return obs;
 }
 
+std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+CARMAWorldModel::toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects,
+                                    unsigned int thread_count) const
+{
+  return toRoadwayObstacles(objects, {}, thread_count);
+}
+
+std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>>
+CARMAWorldModel::toRoadwayObstacles(const std::vector<cav_msgs::ExternalObject>& objects,
+                                    const std::vector<lanelet::Id>& lanelet_hints, unsigned int thread_count) const
+{
+  if (!semantic_map_ || semantic_map_->laneletLayer.size() == 0)
+  {
+    throw std::invalid_argument("Map is not set or does not contain lanelets");
+  }
+
+  if (!lanelet_hints.empty() && lanelet_hints.size() != objects.size())
+  {
+    throw std::invalid_argument("Number of lanelet hints does not match the number of objects");
+  }
+
+  std::vector<lanelet::Optional<cav_msgs::RoadwayObstacle>> obstacles(objects.size());
+
+  auto convert_range = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+    {
+      if (!lanelet_hints.empty() && lanelet_hints[i] != lanelet::InvalId)
+      {
+        lanelet::BasicPoint2d object_center(objects[i].pose.pose.position.x, objects[i].pose.pose.position.y);
+        auto hinted_lanelet = hintedLanelet(object_center, lanelet_hints[i]);
+        if (hinted_lanelet)
+        {
+          obstacles[i] = obstacleOnLanelet(objects[i], hinted_lanelet.get());
+          continue;
+        }
+      }
+      obstacles[i] = toRoadwayObstacle(objects[i]);
+    }
+  };
+
+  // Each thread converts a contiguous block of objects and writes only to its own block of results
+  size_t thread_total = std::max<size_t>(1, std::min<size_t>(thread_count, objects.size()));
+  if (thread_total == 1)
+  {
+    convert_range(0, objects.size());
+    return obstacles;
+  }
+
+  size_t block_size = (objects.size() + thread_total - 1) / thread_total;
+  std::vector<std::future<void>> blocks;
+  blocks.reserve(thread_total - 1);
+  for (size_t begin = block_size; begin < objects.size(); begin += block_size)
+  {
+    blocks.push_back(
+        std::async(std::launch::async, convert_range, begin, std::min(begin + block_size, objects.size())));
+  }
+  convert_range(0, std::min(block_size, objects.size()));
+
+  for (auto& block : blocks)
+  {
+    block.get();  // Rethrows any exception from the conversion
+  }
+
+  return obstacles;
+}
+
+lanelet::Optional<lanelet::ConstLanelet> CARMAWorldModel::hintedLanelet(const lanelet::BasicPoint2d& point,
+                                                                        lanelet::Id hint) const
+{
+  auto hint_llt = semantic_map_->laneletLayer.find(hint);
+  if (hint_llt == semantic_map_->laneletLayer.end())
+  {
+    return boost::none;
+  }
+
+  lanelet::BasicPolygon2d polygon_storage;
+  if (boost::geometry::within(point, laneletPolygon(*hint_llt, polygon_storage)))
+  {
+    return lanelet::ConstLanelet(*hint_llt);
+  }
+
+  if (!map_routing_graph_)
+  {
+    return boost::none;
+  }
+
+  // Objects which left the hinted lanelet have usually moved onto a successor or changed lanes
+  lanelet::ConstLanelets nearby = map_routing_graph_->following(*hint_llt);
+  for (const auto& neighbor : { map_routing_graph_->left(*hint_llt), map_routing_graph_->right(*hint_llt),
+                                map_routing_graph_->adjacentLeft(*hint_llt),
+                                map_routing_graph_->adjacentRight(*hint_llt) })
+  {
+    if (neighbor)
+    {
+      nearby.push_back(neighbor.get());
+    }
+  }
+
+  for (const auto& llt : nearby)
+  {
+    if (boost::geometry::within(point, laneletPolygon(llt, polygon_storage)))
+    {
+      return llt;
+    }
+  }
+
+  return boost::none;
+}
+
+lanelet::ConstLanelet CARMAWorldModel::predictionLanelet(const lanelet::BasicPoint2d& point,
+                                                         const lanelet::ConstLanelet& previous) const
+{
+  lanelet::BasicPolygon2d polygon_storage;
+  if (boost::geometry::within(point, laneletPolygon(previous, polygon_storage)))
+  {
+    return previous;
+  }
+
+  if (map_routing_graph_)
+  {
+    for (const auto& following : map_routing_graph_->following(previous))
+    {
+      if (boost::geometry::within(point, laneletPolygon(following, polygon_storage)))
+      {
+        return following;
+      }
+    }
+  }
+
+  // The index is only used while it matches the lanelets of the map
+  if (lanelet_index_valid_)
+  {
+    auto containing = containingLaneletIds(point);
+    if (!containing.empty())
+    {
+      return semantic_map_->laneletLayer.get(containing.front());
+    }
+  }
+
+  return semantic_map_->laneletLayer.nearest(point, 1)[0];
+}
+
 void CARMAWorldModel::setRoadwayObjects(const std::vector<cav_msgs::RoadwayObstacle>& rw_objs)
 {
   roadway_objects_ = rw_objs;
+  computeRoadwayObjectIndex();
+}
+
+void CARMAWorldModel::computeRoadwayObjectIndex()
+{
+  roadway_object_polygons_.clear();
+  roadway_object_index_.clear();
+  roadway_object_polygons_.reserve(roadway_objects_.size());
+  lanelet::BasicPolygon2d polygon_storage;
+
+  for (size_t i = 0; i < roadway_objects_.size(); i++)
+  {
+    const auto& obj = roadway_objects_[i];
+    roadway_object_polygons_.push_back(geometry::objectToMapPolygon(obj.object.pose.pose, obj.object.size));
+    roadway_object_index_[obj.lanelet_id].push_back(i);
+
+    if (!semantic_map_ || !map_routing_graph_)
+    {
+      continue;
+    }
+
+    auto obj_llt = semantic_map_->laneletLayer.find(obj.lanelet_id);
+    if (obj_llt == semantic_map_->laneletLayer.end())
+    {
+      continue;
+    }
+
+    // handle a case where an object might be lane-changing. Any lanelet which has the object's lanelet as its left or
+    // right neighbor shares a bound with it
+    std::unordered_set<lanelet::Id> checked_ids = { obj.lanelet_id };
+    for (const auto& bound : { obj_llt->leftBound(), obj_llt->rightBound() })
+    {
+      for (const auto& llt : semantic_map_->laneletLayer.findUsages(bound))
+      {
+        if (!checked_ids.insert(llt.id()).second)
+        {
+          continue;
+        }
+
+        auto left = map_routing_graph_->left(llt);
+        auto right = map_routing_graph_->right(llt);
+        if (((left && left.get().id() == obj.lanelet_id) || (right && right.get().id() == obj.lanelet_id)) &&
+            boost::geometry::intersects(laneletPolygon(llt, polygon_storage), roadway_object_polygons_.back()))
+        {
+          roadway_object_index_[llt.id()].push_back(i);
+        }
+      }
+    }
+  }
+}
+
+std::vector<std::pair<size_t, size_t>>
+CARMAWorldModel::getInLaneObjectIndexes(const std::vector<lanelet::ConstLanelet>& lane) const
+{
+  std::vector<std::pair<size_t, size_t>> matches;
+  std::unordered_set<size_t> matched_objects;
+
+  for (size_t lane_idx = 0; lane_idx < lane.size(); lane_idx++)
+  {
+    auto indexed_objects = roadway_object_index_.find(lane[lane_idx].id());
+    if (indexed_objects == roadway_object_index_.end())
+    {
+      continue;
+    }
+
+    for (size_t obj_idx : indexed_objects->second)
+    {
+      // An object is only associated with the first lanelet it is found in
+      if (matched_objects.insert(obj_idx).second)
+      {
+        matches.emplace_back(lane_idx, obj_idx);
+      }
+    }
+  }
+
+  return matches;
 }
 
 std::vector<cav_msgs::RoadwayObstacle> CARMAWorldModel::getRoadwayObjects() const
@@ -706,62 +1542,67 @@ std::vector<cav_msgs::RoadwayObstacle> CARMAWorldModel::getInLaneObjects(const l
     return std::vector<cav_msgs::RoadwayObstacle>{};
   }
 
-  // Initialize useful variables
-  std::vector<cav_msgs::RoadwayObstacle> lane_objects, roadway_objects_copy = roadway_objects_;
-
   /*
    * Get all in lane objects
-   * For each lane, we check if each object is on it by matching lanelet_id
-   * Complexity N*K, where N: num of lanelets, K: num of objects
+   * Objects are looked up by lanelet id in the index built by setRoadwayObjects
+   * Complexity N+K, where N: num of lanelets, K: num of objects in the lane
    */
-  int curr_idx;
-  std::queue<int> obj_idxs_queue;
+  std::vector<cav_msgs::RoadwayObstacle> lane_objects;
+  for (const auto& match : getInLaneObjectIndexes(lane))
+  {
+    lane_objects.push_back(roadway_objects_[match.second]);
+  }
 
-  // Create an index queue for roadway objects to quickly pop the idx if associated
-  // lanelet is found. This is to reduce number of objects to check as we check new lanelets
-  for (size_t i = 0; i < roadway_objects_copy.size(); i++)
+  return lane_objects;
+}
+
+const lanelet::BasicPolygon2d& CARMAWorldModel::laneletPolygon(const lanelet::ConstLanelet& lanelet,
+                                                               lanelet::BasicPolygon2d& storage) const
+{
+  const LaneletGeometry* geometry = lanelet_index_valid_ ? lanelet_index_.geometry(lanelet) : nullptr;
+  if (geometry)
   {
-    obj_idxs_queue.push((int)i);
+    return geometry->polygon;
   }
+  storage = lanelet.polygon2d().basicPolygon();
+  return storage;
+}
 
-  // check each lanelets
-  for (auto llt : lane)
+TrackPos CARMAWorldModel::laneletTrackPos(const lanelet::ConstLanelet& lanelet,
+                                          const lanelet::BasicPoint2d& point) const
+{
+  // Objects and their predictions are usually matched against the same few lanelets, so the O(n) build of each
+  // hierarchy is shared by many O(log n) queries
+  if (!lanelet_index_valid_)
   {
-    int checked_queue_items = 0, to_check = obj_idxs_queue.size();
-    // check each objects
-    while (checked_queue_items < to_check)
-    {
-      curr_idx = obj_idxs_queue.front();
-      obj_idxs_queue.pop();
-      checked_queue_items++;
+    return geometry::trackPos(lanelet, point); // The map may have been edited since the cache was last cleared
+  }
+  return centerline_indexes_.trackPos(lanelet, point);
+}
 
-      // Check if the object is in the lanelet
-      auto curr_obj = roadway_objects_copy[curr_idx];
-      if (curr_obj.lanelet_id == llt.id())
-      {
-        // found intersecting lanelet for this object
-        lane_objects.push_back(curr_obj);
-      }
-      // handle a case where an object might be lane-changing, so check adjacent ids
-      // a bit faster than checking intersection solely as && is left-to-right evaluation
-      else if (((map_routing_graph_->left(llt) && curr_obj.lanelet_id == map_routing_graph_->left(llt).get().id()) ||
-                (map_routing_graph_->right(llt) && curr_obj.lanelet_id == map_routing_graph_->right(llt).get().id())) &&
-               boost::geometry::intersects(
-                   llt.polygon2d().basicPolygon(),
-                   geometry::objectToMapPolygon(curr_obj.object.pose.pose, curr_obj.object.size)))
-      {
-        // found intersecting lanelet for this object
-        lane_objects.push_back(curr_obj);
-      }
-      else
-      {
-        // did not find suitable lanelet, so it will be processed again for next lanelet
-        obj_idxs_queue.push(curr_idx);
-      }
+std::vector<lanelet::Id> CARMAWorldModel::containingLaneletIds(const lanelet::BasicPoint2d& point) const
+{
+  // Only the lanelets whose bounding box contains the point need the exact containment check
+  std::vector<std::pair<double, lanelet::Id>> containing;
+  for (auto id : lanelet_index_.candidates(point))
+  {
+    const LaneletGeometry* geometry = lanelet_index_.geometry(id);
+    if (boost::geometry::within(point, geometry->polygon))
+    {
+      containing.emplace_back(boost::geometry::distance(point, geometry->centerline), id);
     }
   }
 
-  return lane_objects;
+  // Where lanelets overlap the one whose centerline is closest to the point is the best match
+  std::sort(containing.begin(), containing.end());
+
+  std::vector<lanelet::Id> ids;
+  ids.reserve(containing.size());
+  for (const auto& llt : containing)
+  {
+    ids.push_back(llt.second);
+  }
+  return ids;
 }
 
 lanelet::Optional<lanelet::Lanelet>
@@ -781,7 +1622,8 @@ CARMAWorldModel::getIntersectingLanelet(const cav_msgs::ExternalObject& object)
 
   // Check if the object is inside or intersecting this lanelet
   // If no intersection then the object can be considered off the road and does not need to processed
-  if (!boost::geometry::intersects(nearestLanelet.polygon2d().basicPolygon(), object_polygon))
+  lanelet::BasicPolygon2d polygon_storage;
+  if (!boost::geometry::intersects(laneletPolygon(nearestLanelet, polygon_storage), object_polygon))
   {
     return boost::none;
   }
@@ -801,24 +1643,21 @@ lanelet::Optional<double> CARMAWorldModel::distToNearestObjInLane(const lanelet:
     return boost::none;
 
   // Get the lanelet of this point
-  auto curr_lanelet = semantic_map_->laneletLayer.nearest(object_center, 1)[0];
-
-  // Check if this point at least is actually within this lanelet; otherwise, it wouldn't be "in-lane"
-  if (!boost::geometry::within(object_center, curr_lanelet.polygon2d().basicPolygon()))
+  // Check if this point at least is actually within a lanelet; otherwise, it wouldn't be "in-lane"
+  auto containing_lanelets = getLaneletsFromPoint(object_center, 1);
+  if (containing_lanelets.empty())
     throw std::invalid_argument("Given point is not within any lanelet");
 
-  std::vector<cav_msgs::RoadwayObstacle> lane_objects = getInLaneObjects(curr_lanelet);
+  lanelet::ConstLanelet curr_lanelet = containing_lanelets.front();
 
   // return empty if there is no object in the lane
-  if (lane_objects.size() == 0)
+  if (getInLaneObjectIndexes(getLane(curr_lanelet)).empty())
     return boost::none;
 
   // Record the closest distance out of all polygons, 4 points each
   double min_dist = INFINITY;
-  for (auto obj : roadway_objects_)
+  for (const auto& object_polygon : roadway_object_polygons_)
   {
-    lanelet::BasicPolygon2d object_polygon = geometry::objectToMapPolygon(obj.object.pose.pose, obj.object.size);
-
     // Point to closest edge on polygon distance by boost library
     double curr_dist = lanelet::geometry::distance(object_center, object_polygon);
     if (min_dist > curr_dist)
@@ -843,75 +1682,32 @@ CARMAWorldModel::getNearestObjInLane(const lanelet::BasicPoint2d& object_center,
     return boost::none;
 
   // Get the lanelet of this point
-  auto curr_lanelet = semantic_map_->laneletLayer.nearest(object_center, 1)[0];
-
-  // Check if this point at least is actually within this lanelet; otherwise, it wouldn't be "in-lane"
-  if (!boost::geometry::within(object_center, curr_lanelet.polygon2d().basicPolygon()))
+  // Check if this point at least is actually within a lanelet; otherwise, it wouldn't be "in-lane"
+  auto containing_lanelets = getLaneletsFromPoint(object_center, 1);
+  if (containing_lanelets.empty())
     throw std::invalid_argument("Given point is not within any lanelet");
 
+  lanelet::ConstLanelet curr_lanelet = containing_lanelets.front();
+
+  // Get the lane that is including this lanelet
+  std::vector<lanelet::ConstLanelet> lane_section = getLane(curr_lanelet, section);
+
   // Get objects that are in the lane
-  std::vector<cav_msgs::RoadwayObstacle> lane_objects = getInLaneObjects(curr_lanelet, section);
+  std::vector<std::pair<size_t, size_t>> lane_objects = getInLaneObjectIndexes(lane_section);
 
   // return empty if there is no object in the lane
   if (lane_objects.size() == 0)
     return boost::none;
 
-  // Get the lane that is including this lanelet
-  std::vector<lanelet::ConstLanelet> lane_section = getLane(curr_lanelet, section);
-
-  std::vector<double> object_downtracks, object_crosstracks;
-  std::vector<int> object_idxs;
-  std::queue<int> obj_idxs_queue;
+  // Downtrack of the start of each lanelet along the lane
+  std::vector<double> base_downtracks;
+  base_downtracks.reserve(lane_section.size());
   double base_downtrack = 0;
   double input_obj_downtrack = 0;
-  int curr_idx = 0;
-
-  // Create an index queue for in lane objects to quickly pop the idx if associated
-  // lanelet is found. This is to reduce number of objects to check as we check new lanelets
-  for (size_t i = 0; i < lane_objects.size(); i++)
-  {
-    obj_idxs_queue.push((int)i);
-  }
-
-  // For each lanelet, check if each object is inside it. if so, calculate downtrack
   for (auto llt : lane_section)
   {
-    int checked_queue_items = 0, to_check = obj_idxs_queue.size();
+    base_downtracks.push_back(base_downtrack);
 
-    // check each remaining objects
-    while (checked_queue_items < to_check)
-    {
-      curr_idx = obj_idxs_queue.front();
-      obj_idxs_queue.pop();
-      checked_queue_items++;
-
-      // if the object is on it, store its total downtrack distance
-      if (lane_objects[curr_idx].lanelet_id == llt.id())
-      {
-        object_downtracks.push_back(base_downtrack + lane_objects[curr_idx].down_track);
-        object_crosstracks.push_back(lane_objects[curr_idx].cross_track);
-        object_idxs.push_back(curr_idx);
-      }
-      // if it's not on it, try adjacent lanelets because the object could be lane changing
-      else if ((map_routing_graph_->left(llt) &&
-                lane_objects[curr_idx].lanelet_id == map_routing_graph_->left(llt).get().id()) ||
-               (map_routing_graph_->right(llt) &&
-                lane_objects[curr_idx].lanelet_id == map_routing_graph_->right(llt).get().id()))
-      {
-        // no need to check intersection as the objects are guaranteed to be intersecting this lane
-        lanelet::BasicPoint2d obj_center(lane_objects[curr_idx].object.pose.pose.position.x,
-                                         lane_objects[curr_idx].object.pose.pose.position.y);
-        TrackPos new_tp = geometry::trackPos(llt, obj_center);
-        object_downtracks.push_back(base_downtrack + new_tp.downtrack);
-        object_crosstracks.push_back(lane_objects[curr_idx].cross_track);
-        object_idxs.push_back(curr_idx);
-      }
-      else
-      {
-        // the object is not in the lanelet if above conditions do not meet
-        obj_idxs_queue.push(curr_idx);
-      }
-    }
     // try to update object_center's downtrack
     if (curr_lanelet.id() == llt.id())
       input_obj_downtrack = base_downtrack + geometry::trackPos(llt, object_center).downtrack;
@@ -923,6 +1719,29 @@ CARMAWorldModel::getNearestObjInLane(const lanelet::BasicPoint2d& object_center,
             .downtrack;
   }
 
+  std::vector<double> object_downtracks, object_crosstracks;
+  std::vector<size_t> object_idxs;
+  for (const auto& match : lane_objects)
+  {
+    const lanelet::ConstLanelet& llt = lane_section[match.first];
+    const cav_msgs::RoadwayObstacle& obj = roadway_objects_[match.second];
+
+    // if the object is on it, store its total downtrack distance
+    if (obj.lanelet_id == llt.id())
+    {
+      object_downtracks.push_back(base_downtracks[match.first] + obj.down_track);
+    }
+    // otherwise the object is lane changing into this lanelet from an adjacent lanelet
+    else
+    {
+      lanelet::BasicPoint2d obj_center(obj.object.pose.pose.position.x, obj.object.pose.pose.position.y);
+      TrackPos new_tp = geometry::trackPos(llt, obj_center);
+      object_downtracks.push_back(base_downtracks[match.first] + new_tp.downtrack);
+    }
+    object_crosstracks.push_back(obj.cross_track);
+    object_idxs.push_back(match.second);
+  }
+
   // compare with input's downtrack and return the min_dist
   size_t min_idx = 0;
   double min_dist = INFINITY;
@@ -940,7 +1759,7 @@ CARMAWorldModel::getNearestObjInLane(const lanelet::BasicPoint2d& object_center,
   return std::tuple<TrackPos, cav_msgs::RoadwayObstacle>(
       TrackPos(object_downtracks[min_idx] - input_obj_downtrack,
                object_crosstracks[min_idx] - geometry::trackPos(curr_lanelet, object_center).crosstrack),
-      lane_objects[object_idxs[min_idx]]);
+      roadway_objects_[object_idxs[min_idx]]);
 }
 
 lanelet::Optional<std::tuple<TrackPos, cav_msgs::RoadwayObstacle>>
@@ -1025,17 +1844,31 @@ std::vector<lanelet::Lanelet> CARMAWorldModel::getLaneletsFromPoint(const lanele
     throw std::invalid_argument("Map is not set or does not contain lanelets");
   }
   std::vector<lanelet::Lanelet> possible_lanelets;
-  auto nearestLanelets = lanelet::geometry::findNearest(semantic_map_->laneletLayer, point, n);
-  if (nearestLanelets.size() == 0)
-    return {};
-  int id = 0;  // closest ones are in the back
-  // loop through until the point is no longer geometrically in the lanelet
-  while (boost::geometry::within(point, nearestLanelets[id].second.polygon2d()))
-  {
-    possible_lanelets.push_back(nearestLanelets[id].second);
-    id++;
-    if (id >= nearestLanelets.size())
+
+  // The map may have been edited in place since it was last indexed, in which case the nearest lanelets are searched
+  // instead
+  if (!lanelet_index_valid_)
+  {
+    auto nearestLanelets = lanelet::geometry::findNearest(semantic_map_->laneletLayer, point, n);
+    if (nearestLanelets.size() == 0)
+      return {};
+    int id = 0;  // closest ones are in the back
+    // loop through until the point is no longer geometrically in the lanelet
+    while (boost::geometry::within(point, nearestLanelets[id].second.polygon2d()))
+    {
+      possible_lanelets.push_back(nearestLanelets[id].second);
+      id++;
+      if (id >= nearestLanelets.size())
+        break;
+    }
+    return possible_lanelets;
+  }
+
+  for (auto id : containingLaneletIds(point))
+  {
+    if (possible_lanelets.size() >= n)
       break;
+    possible_lanelets.push_back(semantic_map_->laneletLayer.get(id));
   }
   return possible_lanelets;
 }
@@ -1043,6 +1876,10 @@ std::vector<lanelet::Lanelet> CARMAWorldModel::getLaneletsFromPoint(const lanele
 void CARMAWorldModel::setConfigSpeedLimit(double config_lim)
 {
   config_speed_limit_ = config_lim;
+
+  // The traffic rules and the speed limits they define depend on the configured limit
+  computeTrafficRulesCache();
+  computeSpeedLimits();
 }
 
 }  // namespace carma_wm
\ No newline at end of file
@@ -0,0 +1,337 @@
+#pragma once
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <lanelet2_core/primitives/RegulatoryElement.h>
+#include <lanelet2_core/Exceptions.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Internal helpers shared by the flat binary map format and the compact map update format
+ */
+namespace carma_wm
+{
+namespace flat_binary
+{
+// Type tags of regulatory element parameters
+enum class ParameterType : uint8_t
+{
+  POINT = 0,
+  LINE_STRING = 1,
+  POLYGON = 2,
+  LANELET = 3,
+  AREA = 4
+};
+
+// Reference to a regulatory element parameter by id
+struct ParameterRef
+{
+  ParameterType type;
+  lanelet::Id id;
+  bool inverted;
+};
+
+/**
+ * Appends values to a byte buffer in host byte order
+ */
+class FlatWriter
+{
+public:
+  explicit FlatWriter(std::vector<uint8_t>& buffer) : buffer_(buffer)
+  {
+  }
+
+  template <typename T>
+  void write(const T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written directly");
+    size_t offset = buffer_.size();
+    buffer_.resize(offset + sizeof(T));
+    std::memcpy(buffer_.data() + offset, &value, sizeof(T));
+  }
+
+  void writeBytes(const uint8_t* data, size_t size)
+  {
+    buffer_.insert(buffer_.end(), data, data + size);
+  }
+
+  void writeString(const std::string& value)
+  {
+    write<uint32_t>(static_cast<uint32_t>(value.size()));
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+  }
+
+  void writeAttributes(const lanelet::AttributeMap& attributes)
+  {
+    write<uint32_t>(static_cast<uint32_t>(attributes.size()));
+    for (const auto& attribute : attributes)
+    {
+      writeString(attribute.first);
+      writeString(attribute.second.value());
+    }
+  }
+
+  void writeLineStringRef(const lanelet::ConstLineString3d& ls)
+  {
+    write<lanelet::Id>(ls.id());
+    write<uint8_t>(ls.inverted() ? 1 : 0);
+  }
+
+  void writeLineStringRefs(const lanelet::ConstLineStrings3d& line_strings)
+  {
+    write<uint64_t>(line_strings.size());
+    for (const auto& ls : line_strings)
+    {
+      writeLineStringRef(ls);
+    }
+  }
+
+private:
+  std::vector<uint8_t>& buffer_;
+};
+
+/**
+ * Reads values written by FlatWriter from a read only buffer with bounds checking.
+ * The description names the format in error messages.
+ */
+class FlatReader
+{
+public:
+  FlatReader(const uint8_t* data, size_t size, const char* description)
+    : data_(data), size_(size), description_(description)
+  {
+  }
+
+  template <typename T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read directly");
+    require(sizeof(T));
+    T value;
+    std::memcpy(&value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  // Returns a pointer to the next size bytes and skips over them
+  const uint8_t* readBytes(size_t size)
+  {
+    require(size);
+    const uint8_t* bytes = data_ + offset_;
+    offset_ += size;
+    return bytes;
+  }
+
+  std::string readString()
+  {
+    uint32_t length = read<uint32_t>();
+    const uint8_t* bytes = readBytes(length);
+    return std::string(reinterpret_cast<const char*>(bytes), length);
+  }
+
+  lanelet::AttributeMap readAttributes()
+  {
+    lanelet::AttributeMap attributes;
+    uint32_t count = read<uint32_t>();
+    for (uint32_t i = 0; i < count; i++)
+    {
+      std::string key = readString();
+      attributes[key] = lanelet::Attribute(readString());
+    }
+    return attributes;
+  }
+
+  // Reads a count and checks that at least min_element_size bytes remain for each element so corrupt counts fail early
+  uint64_t readCount(size_t min_element_size)
+  {
+    uint64_t count = read<uint64_t>();
+    if (min_element_size > 0 && count > (size_ - offset_) / min_element_size)
+    {
+      throw std::invalid_argument(std::string(description_) + " is truncated");
+    }
+    return count;
+  }
+
+  bool atEnd() const
+  {
+    return offset_ == size_;
+  }
+
+  size_t remaining() const
+  {
+    return size_ - offset_;
+  }
+
+  const char* description() const
+  {
+    return description_;
+  }
+
+private:
+  void require(size_t bytes) const
+  {
+    if (bytes > size_ - offset_)
+    {
+      throw std::invalid_argument(std::string(description_) + " is truncated");
+    }
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_ = 0;
+  const char* description_;
+};
+
+template <typename Map>
+const typename Map::mapped_type& lookup(const Map& primitives, lanelet::Id id, const char* primitive_name,
+                                        const char* description)
+{
+  auto it = primitives.find(id);
+  if (it == primitives.end())
+  {
+    throw std::invalid_argument(std::string(description) + " references unknown " + primitive_name + " " +
+                                std::to_string(id));
+  }
+  return it->second;
+}
+
+/**
+ * Returns the references of the parameters of a regulatory element role.
+ * Expired lanelet or area references cannot be restored so they are dropped.
+ */
+inline std::vector<ParameterRef> parameterRefs(const lanelet::RuleParameters& parameters)
+{
+  std::vector<ParameterRef> refs;
+  refs.reserve(parameters.size());
+  for (const auto& parameter : parameters)
+  {
+    if (auto point = boost::get<lanelet::Point3d>(&parameter))
+    {
+      refs.push_back({ ParameterType::POINT, point->id(), false });
+    }
+    else if (auto ls = boost::get<lanelet::LineString3d>(&parameter))
+    {
+      refs.push_back({ ParameterType::LINE_STRING, ls->id(), ls->inverted() });
+    }
+    else if (auto polygon = boost::get<lanelet::Polygon3d>(&parameter))
+    {
+      refs.push_back({ ParameterType::POLYGON, polygon->id(), false });
+    }
+    else if (auto weak_lanelet = boost::get<lanelet::WeakLanelet>(&parameter))
+    {
+      if (!weak_lanelet->expired())
+      {
+        lanelet::Lanelet llt = weak_lanelet->lock();
+        refs.push_back({ ParameterType::LANELET, llt.id(), llt.inverted() });
+      }
+    }
+    else if (auto weak_area = boost::get<lanelet::WeakArea>(&parameter))
+    {
+      if (!weak_area->expired())
+      {
+        refs.push_back({ ParameterType::AREA, weak_area->lock().id(), false });
+      }
+    }
+  }
+  return refs;
+}
+
+/**
+ * Writes the id, attributes and parameter references of a regulatory element
+ */
+inline void writeRegulatoryElement(FlatWriter& writer, const lanelet::RegulatoryElement& regem)
+{
+  writer.write<lanelet::Id>(regem.id());
+  writer.writeAttributes(regem.attributes());
+
+  const auto& parameters = regem.getParameters();
+  writer.write<uint32_t>(static_cast<uint32_t>(parameters.size()));
+  for (const auto& role : parameters)
+  {
+    writer.writeString(role.first);
+
+    std::vector<ParameterRef> refs = parameterRefs(role.second);
+    writer.write<uint64_t>(refs.size());
+    for (const auto& ref : refs)
+    {
+      writer.write<uint8_t>(static_cast<uint8_t>(ref.type));
+      writer.write<lanelet::Id>(ref.id);
+      writer.write<uint8_t>(ref.inverted ? 1 : 0);
+    }
+  }
+}
+
+/**
+ * Reads a regulatory element written by writeRegulatoryElement(). The resolve function is called with each
+ * ParameterRef and returns the lanelet::RuleParameter it refers to.
+ *
+ * The regulatory element is constructed with lanelet::RegulatoryElementFactory using its subtype attribute. Unknown
+ * rule types are loaded as lanelet::GenericRegulatoryElement.
+ */
+template <typename ResolveFunc>
+lanelet::RegulatoryElementPtr readRegulatoryElement(FlatReader& reader, ResolveFunc resolve)
+{
+  lanelet::Id id = reader.read<lanelet::Id>();
+  lanelet::AttributeMap attributes = reader.readAttributes();
+
+  lanelet::RuleParameterMap parameters;
+  uint32_t role_count = reader.read<uint32_t>();
+  for (uint32_t j = 0; j < role_count; j++)
+  {
+    std::string role = reader.readString();
+    uint64_t param_count = reader.readCount(2 * sizeof(uint8_t) + sizeof(lanelet::Id));
+    lanelet::RuleParameters params;
+    params.reserve(param_count);
+    for (uint64_t k = 0; k < param_count; k++)
+    {
+      ParameterRef ref;
+      uint8_t type = reader.read<uint8_t>();
+      if (type > static_cast<uint8_t>(ParameterType::AREA))
+      {
+        throw std::invalid_argument(std::string(reader.description()) +
+                                    " contains unknown regulatory element parameter type");
+      }
+      ref.type = static_cast<ParameterType>(type);
+      ref.id = reader.read<lanelet::Id>();
+      ref.inverted = reader.read<uint8_t>() != 0;
+      params.push_back(resolve(ref));
+    }
+    parameters[role] = params;
+  }
+
+  auto regem_data = std::make_shared<lanelet::RegulatoryElementData>(id, parameters, attributes);
+  auto subtype = attributes.find(lanelet::AttributeName::Subtype);
+  try
+  {
+    if (subtype == attributes.end())
+    {
+      throw lanelet::InvalidInputError("Regulatory element has no subtype");
+    }
+    return lanelet::RegulatoryElementFactory::create(subtype->second.value(), regem_data);
+  }
+  catch (const lanelet::LaneletError&)
+  {
+    return std::make_shared<lanelet::GenericRegulatoryElement>(regem_data);
+  }
+}
+
+}  // namespace flat_binary
+}  // namespace carma_wm
@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <carma_wm/FlatBinaryMap.h>
+#include <lanelet2_extension/utility/message_conversion.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FlatBinaryIO.h"
+
+namespace carma_wm
+{
+namespace
+{
+using flat_binary::FlatReader;
+using flat_binary::FlatWriter;
+using flat_binary::ParameterRef;
+using flat_binary::ParameterType;
+
+constexpr char FLAT_BINARY_MAP_MAGIC[4] = { 'C', 'W', 'M', 'F' };
+
+constexpr const char* FLAT_BINARY_MAP = "Flat binary map";
+
+template <typename Map>
+const typename Map::mapped_type& lookup(const Map& primitives, lanelet::Id id, const char* primitive_name)
+{
+  return flat_binary::lookup(primitives, id, primitive_name, FLAT_BINARY_MAP);
+}
+
+lanelet::LineString3d readLineStringRef(FlatReader& reader,
+                                        const std::unordered_map<lanelet::Id, lanelet::LineString3d>& line_strings)
+{
+  lanelet::Id id = reader.read<lanelet::Id>();
+  bool inverted = reader.read<uint8_t>() != 0;
+  lanelet::LineString3d ls = lookup(line_strings, id, "line string");
+  return inverted ? ls.invert() : ls;
+}
+
+lanelet::LineStrings3d readLineStringRefs(FlatReader& reader,
+                                          const std::unordered_map<lanelet::Id, lanelet::LineString3d>& line_strings)
+{
+  uint64_t count = reader.readCount(sizeof(lanelet::Id) + sizeof(uint8_t));
+  lanelet::LineStrings3d result;
+  result.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    result.push_back(readLineStringRef(reader, line_strings));
+  }
+  return result;
+}
+
+void writeRegulatoryElementIds(FlatWriter& writer, const lanelet::RegulatoryElementConstPtrs& regems)
+{
+  writer.write<uint64_t>(regems.size());
+  for (const auto& regem : regems)
+  {
+    writer.write<lanelet::Id>(regem->id());
+  }
+}
+
+std::vector<lanelet::Id> readIds(FlatReader& reader)
+{
+  uint64_t count = reader.readCount(sizeof(lanelet::Id));
+  std::vector<lanelet::Id> ids;
+  ids.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    ids.push_back(reader.read<lanelet::Id>());
+  }
+  return ids;
+}
+
+}  // namespace
+
+void toFlatBinary(const lanelet::LaneletMap& map, std::vector<uint8_t>& output)
+{
+  output.clear();
+  FlatWriter writer(output);
+
+  for (char c : FLAT_BINARY_MAP_MAGIC)
+  {
+    writer.write<char>(c);
+  }
+  writer.write<uint32_t>(FLAT_BINARY_MAP_VERSION);
+
+  // Points
+  writer.write<uint64_t>(map.pointLayer.size());
+  for (const auto& point : map.pointLayer)
+  {
+    writer.write<lanelet::Id>(point.id());
+    writer.write<double>(point.x());
+    writer.write<double>(point.y());
+    writer.write<double>(point.z());
+    writer.writeAttributes(point.attributes());
+  }
+
+  // Line strings are stored in their non inverted orientation
+  writer.write<uint64_t>(map.lineStringLayer.size());
+  for (const auto& ls : map.lineStringLayer)
+  {
+    lanelet::ConstLineString3d forward = ls.inverted() ? ls.invert() : ls;
+    writer.write<lanelet::Id>(forward.id());
+    writer.writeAttributes(forward.attributes());
+    writer.write<uint64_t>(forward.size());
+    for (const auto& point : forward)
+    {
+      writer.write<lanelet::Id>(point.id());
+    }
+  }
+
+  // Polygons
+  writer.write<uint64_t>(map.polygonLayer.size());
+  for (const lanelet::ConstPolygon3d polygon : map.polygonLayer)
+  {
+    writer.write<lanelet::Id>(polygon.id());
+    writer.writeAttributes(polygon.attributes());
+    writer.write<uint64_t>(polygon.size());
+    for (const auto& point : polygon)
+    {
+      writer.write<lanelet::Id>(point.id());
+    }
+  }
+
+  // Lanelets. Their regulatory elements are stored by id and linked after the regulatory elements are read
+  writer.write<uint64_t>(map.laneletLayer.size());
+  for (const auto& llt : map.laneletLayer)
+  {
+    lanelet::ConstLanelet lanelet = llt.inverted() ? llt.invert() : llt;
+    writer.write<lanelet::Id>(lanelet.id());
+    writer.writeAttributes(lanelet.attributes());
+    writer.writeLineStringRef(lanelet.leftBound());
+    writer.writeLineStringRef(lanelet.rightBound());
+
+    // Custom centerlines are not part of the map layers so they are stored inline
+    bool custom_centerline = lanelet.hasCustomCenterline();
+    writer.write<uint8_t>(custom_centerline ? 1 : 0);
+    if (custom_centerline)
+    {
+      lanelet::ConstLineString3d centerline = lanelet.centerline();
+      writer.write<lanelet::Id>(centerline.id());
+      writer.writeAttributes(centerline.attributes());
+      writer.write<uint64_t>(centerline.size());
+      for (const auto& point : centerline)
+      {
+        writer.write<lanelet::Id>(point.id());
+        writer.write<double>(point.x());
+        writer.write<double>(point.y());
+        writer.write<double>(point.z());
+      }
+    }
+
+    writeRegulatoryElementIds(writer, lanelet.regulatoryElements());
+  }
+
+  // Areas
+  writer.write<uint64_t>(map.areaLayer.size());
+  for (const lanelet::ConstArea area : map.areaLayer)
+  {
+    writer.write<lanelet::Id>(area.id());
+    writer.writeAttributes(area.attributes());
+    writer.writeLineStringRefs(area.outerBound());
+    auto inner_bounds = area.innerBounds();
+    writer.write<uint64_t>(inner_bounds.size());
+    for (const auto& inner_bound : inner_bounds)
+    {
+      writer.writeLineStringRefs(inner_bound);
+    }
+    writeRegulatoryElementIds(writer, area.regulatoryElements());
+  }
+
+  // Regulatory elements
+  writer.write<uint64_t>(map.regulatoryElementLayer.size());
+  for (const auto& regem : map.regulatoryElementLayer)
+  {
+    flat_binary::writeRegulatoryElement(writer, *regem);
+  }
+}
+
+lanelet::LaneletMapPtr fromFlatBinary(const uint8_t* data, size_t size)
+{
+  if (data == nullptr && size != 0)
+  {
+    throw std::invalid_argument("Flat binary map data is null");
+  }
+
+  FlatReader reader(data, size, FLAT_BINARY_MAP);
+
+  for (char c : FLAT_BINARY_MAP_MAGIC)
+  {
+    if (reader.read<char>() != c)
+    {
+      throw std::invalid_argument("Data is not a flat binary map");
+    }
+  }
+  uint32_t version = reader.read<uint32_t>();
+  if (version != FLAT_BINARY_MAP_VERSION)
+  {
+    throw std::invalid_argument("Unsupported flat binary map version " + std::to_string(version) + " expected " +
+                                std::to_string(FLAT_BINARY_MAP_VERSION));
+  }
+
+  // Points
+  uint64_t count = reader.readCount(sizeof(lanelet::Id) + 3 * sizeof(double));
+  std::unordered_map<lanelet::Id, lanelet::Point3d> points;
+  points.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id id = reader.read<lanelet::Id>();
+    double x = reader.read<double>();
+    double y = reader.read<double>();
+    double z = reader.read<double>();
+    points.emplace(id, lanelet::Point3d(id, x, y, z, reader.readAttributes()));
+  }
+
+  auto read_points = [&]() {
+    uint64_t point_count = reader.readCount(sizeof(lanelet::Id));
+    lanelet::Points3d result;
+    result.reserve(point_count);
+    for (uint64_t i = 0; i < point_count; i++)
+    {
+      result.push_back(lookup(points, reader.read<lanelet::Id>(), "point"));
+    }
+    return result;
+  };
+
+  // Line strings
+  count = reader.readCount(sizeof(lanelet::Id));
+  std::unordered_map<lanelet::Id, lanelet::LineString3d> line_strings;
+  line_strings.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id id = reader.read<lanelet::Id>();
+    lanelet::AttributeMap attributes = reader.readAttributes();
+    line_strings.emplace(id, lanelet::LineString3d(id, read_points(), attributes));
+  }
+
+  // Polygons
+  count = reader.readCount(sizeof(lanelet::Id));
+  std::unordered_map<lanelet::Id, lanelet::Polygon3d> polygons;
+  polygons.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id id = reader.read<lanelet::Id>();
+    lanelet::AttributeMap attributes = reader.readAttributes();
+    polygons.emplace(id, lanelet::Polygon3d(id, read_points(), attributes));
+  }
+
+  // Lanelets
+  count = reader.readCount(sizeof(lanelet::Id));
+  std::unordered_map<lanelet::Id, lanelet::Lanelet> lanelets;
+  std::vector<std::pair<lanelet::Lanelet, std::vector<lanelet::Id>>> lanelet_regems;
+  lanelets.reserve(count);
+  lanelet_regems.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id id = reader.read<lanelet::Id>();
+    lanelet::AttributeMap attributes = reader.readAttributes();
+    lanelet::LineString3d left = readLineStringRef(reader, line_strings);
+    lanelet::LineString3d right = readLineStringRef(reader, line_strings);
+    lanelet::Lanelet llt(id, left, right, attributes);
+
+    if (reader.read<uint8_t>() != 0)
+    {
+      lanelet::Id centerline_id = reader.read<lanelet::Id>();
+      lanelet::AttributeMap centerline_attributes = reader.readAttributes();
+      uint64_t point_count = reader.readCount(sizeof(lanelet::Id) + 3 * sizeof(double));
+      lanelet::Points3d centerline_points;
+      centerline_points.reserve(point_count);
+      for (uint64_t j = 0; j < point_count; j++)
+      {
+        lanelet::Id point_id = reader.read<lanelet::Id>();
+        double x = reader.read<double>();
+        double y = reader.read<double>();
+        double z = reader.read<double>();
+        auto existing = points.find(point_id);
+        centerline_points.push_back(existing != points.end() ? existing->second : lanelet::Point3d(point_id, x, y, z));
+      }
+      llt.setCenterline(lanelet::LineString3d(centerline_id, centerline_points, centerline_attributes));
+    }
+
+    lanelets.emplace(id, llt);
+    lanelet_regems.emplace_back(llt, readIds(reader));
+  }
+
+  // Areas
+  count = reader.readCount(sizeof(lanelet::Id));
+  std::unordered_map<lanelet::Id, lanelet::Area> areas;
+  std::vector<std::pair<lanelet::Area, std::vector<lanelet::Id>>> area_regems;
+  areas.reserve(count);
+  area_regems.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id id = reader.read<lanelet::Id>();
+    lanelet::AttributeMap attributes = reader.readAttributes();
+    lanelet::LineStrings3d outer_bound = readLineStringRefs(reader, line_strings);
+    uint64_t inner_count = reader.readCount(sizeof(uint64_t));
+    lanelet::InnerBounds inner_bounds;
+    inner_bounds.reserve(inner_count);
+    for (uint64_t j = 0; j < inner_count; j++)
+    {
+      inner_bounds.push_back(readLineStringRefs(reader, line_strings));
+    }
+    lanelet::Area area(id, outer_bound, inner_bounds, attributes);
+    areas.emplace(id, area);
+    area_regems.emplace_back(area, readIds(reader));
+  }
+
+  // Regulatory elements
+  auto resolve_parameter = [&](const ParameterRef& ref) -> lanelet::RuleParameter {
+    switch (ref.type)
+    {
+      case ParameterType::POINT:
+        return lookup(points, ref.id, "point");
+      case ParameterType::LINE_STRING:
+      {
+        lanelet::LineString3d ls = lookup(line_strings, ref.id, "line string");
+        return ref.inverted ? ls.invert() : ls;
+      }
+      case ParameterType::POLYGON:
+        return lookup(polygons, ref.id, "polygon");
+      case ParameterType::LANELET:
+      {
+        lanelet::Lanelet llt = lookup(lanelets, ref.id, "lanelet");
+        return lanelet::WeakLanelet(ref.inverted ? llt.invert() : llt);
+      }
+      default:
+        return lanelet::WeakArea(lookup(areas, ref.id, "area"));
+    }
+  };
+
+  count = reader.readCount(sizeof(lanelet::Id));
+  std::unordered_map<lanelet::Id, lanelet::RegulatoryElementPtr> regems;
+  regems.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::RegulatoryElementPtr regem = flat_binary::readRegulatoryElement(reader, resolve_parameter);
+    regems.emplace(regem->id(), regem);
+  }
+
+  if (!reader.atEnd())
+  {
+    throw std::invalid_argument("Flat binary map contains trailing data");
+  }
+
+  for (auto& llt_regems : lanelet_regems)
+  {
+    for (lanelet::Id regem_id : llt_regems.second)
+    {
+      llt_regems.first.addRegulatoryElement(lookup(regems, regem_id, "regulatory element"));
+    }
+  }
+  for (auto& area_regem_ids : area_regems)
+  {
+    for (lanelet::Id regem_id : area_regem_ids.second)
+    {
+      area_regem_ids.first.addRegulatoryElement(lookup(regems, regem_id, "regulatory element"));
+    }
+  }
+
+  // Adding a primitive also adds the primitives it references so existence is checked to avoid adding them twice
+  auto map = std::make_shared<lanelet::LaneletMap>();
+  for (const auto& llt_regems : lanelet_regems)
+  {
+    if (!map->laneletLayer.exists(llt_regems.first.id()))
+      map->add(llt_regems.first);
+  }
+  for (const auto& area_regem_ids : area_regems)
+  {
+    if (!map->areaLayer.exists(area_regem_ids.first.id()))
+      map->add(area_regem_ids.first);
+  }
+  for (const auto& regem : regems)
+  {
+    if (!map->regulatoryElementLayer.exists(regem.first))
+      map->add(regem.second);
+  }
+  for (const auto& polygon : polygons)
+  {
+    if (!map->polygonLayer.exists(polygon.first))
+      map->add(polygon.second);
+  }
+  for (const auto& ls : line_strings)
+  {
+    if (!map->lineStringLayer.exists(ls.first))
+      map->add(ls.second);
+  }
+  for (const auto& point : points)
+  {
+    if (!map->pointLayer.exists(point.first))
+      map->add(point.second);
+  }
+
+  return map;
+}
+
+void saveFlatBinaryMap(const lanelet::LaneletMap& map, const std::string& path)
+{
+  std::vector<uint8_t> buffer;
+  toFlatBinary(map, buffer);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+  if (!file)
+  {
+    throw std::runtime_error("Failed to write flat binary map to " + path);
+  }
+}
+
+lanelet::LaneletMapPtr loadFlatBinaryMap(const std::string& path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Failed to open flat binary map " + path);
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0)
+  {
+    close(fd);
+    throw std::runtime_error("Failed to read size of flat binary map " + path);
+  }
+
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0)
+  {
+    close(fd);
+    throw std::invalid_argument("Flat binary map " + path + " is empty");
+  }
+
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid after the descriptor is closed
+  if (mapped == MAP_FAILED)
+  {
+    throw std::runtime_error("Failed to memory map flat binary map " + path);
+  }
+
+  try
+  {
+    lanelet::LaneletMapPtr map = fromFlatBinary(static_cast<const uint8_t*>(mapped), size);
+    munmap(mapped, size);
+    return map;
+  }
+  catch (...)
+  {
+    munmap(mapped, size);
+    throw;
+  }
+}
+
+void toFlatBinMsg(const lanelet::LaneletMap& map, autoware_lanelet2_msgs::MapBin* msg)
+{
+  toFlatBinary(map, msg->data);
+}
+
+bool isFlatBinMsg(const autoware_lanelet2_msgs::MapBin& msg)
+{
+  return msg.data.size() >= sizeof(FLAT_BINARY_MAP_MAGIC) &&
+         std::equal(std::begin(FLAT_BINARY_MAP_MAGIC), std::end(FLAT_BINARY_MAP_MAGIC), msg.data.begin());
+}
+
+lanelet::LaneletMapPtr mapFromBinMsg(const autoware_lanelet2_msgs::MapBin& msg)
+{
+  if (isFlatBinMsg(msg))
+  {
+    return fromFlatBinary(msg.data.data(), msg.data.size());
+  }
+
+  lanelet::LaneletMapPtr map(new lanelet::LaneletMap);
+  lanelet::utils::conversion::fromBinMsg(msg, map);
+  return map;
+}
+
+}  // namespace carma_wm
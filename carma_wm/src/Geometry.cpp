@@ -19,6 +19,8 @@
 #include <tf2/LinearMath/Transform.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <tf/transform_datatypes.h>
+#include <algorithm>
+#include <array>
 
 namespace carma_wm
 {
@@ -184,6 +186,51 @@ bool selectFirstSegment(const TrackPos& first_seg_trackPos, const TrackPos& seco
   }
 }
 
+TrackPos trackPosFromNearestPoint(const lanelet::BasicPoint2d& p, const lanelet::BasicLineString2d& line_string,
+                                  size_t best_point_index, double best_accumulated_length,
+                                  double best_last_accumulated_length, double best_seg_length,
+                                  double best_last_seg_length, size_t& segment_start_index)
+{
+  // Minimum point has been found next step is to determine which segment it should go with using the following rules.
+  // If the minimum point is the first point then use the first segment
+  // If the minimum point is the last point then use the last segment
+  // If the minimum point is within the downtrack bounds of one segment but not the other then use the one it is within
+  // If the minimum point is within the downtrack bounds of both segments then use the one with the smallest crosstrack
+  // distance If the minimum point is within the downtrack bounds of both segments and has exactly equal crosstrack
+  // bounds with each segment then use the first one
+  TrackPos best_pos(0, 0);
+  if (best_point_index == 0)
+  {
+    best_pos = trackPos(p, line_string[0], line_string[1]);
+    segment_start_index = 0;
+  }
+  else if (best_point_index == line_string.size() - 1)
+  {
+    best_pos = trackPos(p, line_string[line_string.size() - 2], line_string[line_string.size() - 1]);
+    best_pos.downtrack += best_last_accumulated_length;
+    segment_start_index = line_string.size() - 2;
+  }
+  else
+  {
+    TrackPos first_seg_trackPos = trackPos(p, line_string[best_point_index - 1], line_string[best_point_index]);
+    TrackPos second_seg_trackPos = trackPos(p, line_string[best_point_index], line_string[best_point_index + 1]);
+    if (selectFirstSegment(first_seg_trackPos, second_seg_trackPos, best_last_seg_length, best_seg_length))
+    {
+      best_pos = first_seg_trackPos;
+      best_pos.downtrack += best_last_accumulated_length;
+      segment_start_index = best_point_index - 1;
+    }
+    else
+    {
+      best_pos = second_seg_trackPos;
+      best_pos.downtrack += best_accumulated_length;
+      segment_start_index = best_point_index;
+    }
+  }
+
+  return best_pos;
+}
+
 std::tuple<TrackPos, lanelet::BasicSegment2d> matchSegment(const lanelet::BasicPoint2d& p,
                                                            const lanelet::BasicLineString2d& line_string)
 {
@@ -230,46 +277,237 @@ std::tuple<TrackPos, lanelet::BasicSegment2d> matchSegment(const lanelet::BasicP
     last_seg_length = seg_length;
   }
 
-  // Minimum point has been found next step is to determine which segment it should go with using the following rules.
-  // If the minimum point is the first point then use the first segment
-  // If the minimum point is the last point then use the last segment
-  // If the minimum point is within the downtrack bounds of one segment but not the other then use the one it is within
-  // If the minimum point is within the downtrack bounds of both segments then use the one with the smallest crosstrack
-  // distance If the minimum point is within the downtrack bounds of both segments and has exactly equal crosstrack
-  // bounds with each segment then use the first one
-  TrackPos best_pos(0, 0);
-  if (best_point_index == 0)
+  size_t segment_start_index = 0;
+  TrackPos best_pos =
+      trackPosFromNearestPoint(p, line_string, best_point_index, best_accumulated_length, best_last_accumulated_length,
+                               best_seg_length, best_last_seg_length, segment_start_index);
+  best_segment = std::make_pair(line_string[segment_start_index], line_string[segment_start_index + 1]);
+
+  // couldn't find a matching segment, so use the first segment within the downtrack range of.
+  // Or the starting segment assuming we are before the route
+  return std::make_tuple(best_pos, best_segment);
+}
+
+namespace
+{
+// Upper limit on the number of vertex blocks used to prune the nearest vertex search in the batch trackPos function.
+// Fixed so the blocks can be stored on the stack
+constexpr size_t MAX_VERTEX_BLOCKS = 64;
+
+/*! \brief Axis aligned bounding box of a contiguous range of line string vertices
+ */
+struct VertexBlock
+{
+  size_t begin = 0;  // Index of the first vertex in the block
+  size_t end = 0;    // Index one past the last vertex in the block
+  double min_x = 0;
+  double min_y = 0;
+  double max_x = 0;
+  double max_y = 0;
+};
+
+// Lower bound of the distance from p to any vertex in the block
+double distanceToBlock(const lanelet::BasicPoint2d& p, const VertexBlock& block)
+{
+  double dx = std::max({ block.min_x - p.x(), 0.0, p.x() - block.max_x });
+  double dy = std::max({ block.min_y - p.y(), 0.0, p.y() - block.max_y });
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+/*! \brief Cursor which tracks the accumulated length of a line string up to a vertex.
+ *         Lengths are summed in the same order as matchSegment when moving forward
+ */
+class AccumulatedLengthCursor
+{
+public:
+  explicit AccumulatedLengthCursor(const lanelet::BasicLineString2d& line_string) : line_string_(line_string)
   {
-    best_pos = trackPos(p, line_string[0], line_string[1]);
-    best_segment = std::make_pair(line_string[0], line_string[1]);
   }
-  else if (best_point_index == line_string.size() - 1)
+
+  double segmentLength(size_t i) const
   {
-    best_pos = trackPos(p, line_string[line_string.size() - 2], line_string[line_string.size() - 1]);
-    best_pos.downtrack += best_last_accumulated_length;
-    best_segment = std::make_pair(line_string[line_string.size() - 2], line_string[line_string.size() - 1]);
+    return lanelet::geometry::distance2d(line_string_[i], line_string_[i + 1]);
   }
-  else
+
+  // Returns the length of the line string from its first vertex to the vertex at index
+  double lengthTo(size_t index)
   {
-    TrackPos first_seg_trackPos = trackPos(p, line_string[best_point_index - 1], line_string[best_point_index]);
-    TrackPos second_seg_trackPos = trackPos(p, line_string[best_point_index], line_string[best_point_index + 1]);
-    if (selectFirstSegment(first_seg_trackPos, second_seg_trackPos, best_last_seg_length, best_seg_length))
+    while (index_ < index)
     {
-      best_pos = first_seg_trackPos;
-      best_pos.downtrack += best_last_accumulated_length;
-      best_segment = std::make_pair(line_string[best_point_index - 1], line_string[best_point_index]);
+      length_ += segmentLength(index_);
+      index_++;
     }
-    else
+    while (index_ > index)
     {
-      best_pos = second_seg_trackPos;
-      best_pos.downtrack += best_accumulated_length;
-      best_segment = std::make_pair(line_string[best_point_index], line_string[best_point_index + 1]);
+      index_--;
+      length_ -= segmentLength(index_);
     }
+    return length_;
   }
 
-  // couldn't find a matching segment, so use the first segment within the downtrack range of.
-  // Or the starting segment assuming we are before the route
-  return std::make_tuple(best_pos, best_segment);
+private:
+  const lanelet::BasicLineString2d& line_string_;
+  size_t index_ = 0;
+  double length_ = 0;
+};
+}  // namespace
+
+void trackPos(const lanelet::BasicLineString2d& line_string, const std::vector<lanelet::BasicPoint2d>& points,
+              std::vector<TrackPos>& output)
+{
+  if (line_string.size() < 2)
+  {
+    throw std::invalid_argument("Provided with linestring containing fewer than 2 points");
+  }
+
+  output.clear();
+  output.reserve(points.size());
+
+  // Group the vertices into at most MAX_VERTEX_BLOCKS bounding boxes
+  const size_t vertex_count = line_string.size();
+  const size_t block_size = (vertex_count + MAX_VERTEX_BLOCKS - 1) / MAX_VERTEX_BLOCKS;
+  std::array<VertexBlock, MAX_VERTEX_BLOCKS> blocks;
+  size_t block_count = 0;
+  for (size_t begin = 0; begin < vertex_count; begin += block_size)
+  {
+    VertexBlock& block = blocks[block_count++];
+    block.begin = begin;
+    block.end = std::min(begin + block_size, vertex_count);
+    block.min_x = block.max_x = line_string[begin].x();
+    block.min_y = block.max_y = line_string[begin].y();
+    for (size_t i = begin + 1; i < block.end; i++)
+    {
+      block.min_x = std::min(block.min_x, line_string[i].x());
+      block.max_x = std::max(block.max_x, line_string[i].x());
+      block.min_y = std::min(block.min_y, line_string[i].y());
+      block.max_y = std::max(block.max_y, line_string[i].y());
+    }
+  }
+
+  AccumulatedLengthCursor lengths(line_string);
+  size_t hint = 0;
+
+  for (const auto& p : points)
+  {
+    // Descend from the previous nearest vertex to a local minimum. Ties move towards the front of the line string as
+    // matchSegment keeps the first vertex with the minimum distance
+    size_t best_point_index = hint;
+    double min_distance = lanelet::geometry::distance2d(p, line_string[best_point_index]);
+    while (best_point_index + 1 < vertex_count)
+    {
+      double distance = lanelet::geometry::distance2d(p, line_string[best_point_index + 1]);
+      if (distance >= min_distance)
+        break;
+      min_distance = distance;
+      best_point_index++;
+    }
+    size_t visited_end = std::min(best_point_index + 2, vertex_count);  // One past the last vertex the descent checked
+    while (best_point_index > 0)
+    {
+      double distance = lanelet::geometry::distance2d(p, line_string[best_point_index - 1]);
+      if (distance > min_distance)
+        break;
+      min_distance = distance;
+      best_point_index--;
+    }
+    size_t visited_begin = best_point_index > 0 ? best_point_index - 1 : 0;  // First vertex the descent checked
+
+    // The local minimum is only the global minimum if no block could contain a closer vertex. The tolerance keeps the
+    // pruning conservative with respect to rounding. Every vertex the descent checked, other than the local minimum,
+    // is either farther or equally far with a larger index, so those vertices are skipped
+    for (size_t b = 0; b < block_count; b++)
+    {
+      const VertexBlock& block = blocks[b];
+      size_t skip_begin = std::max(block.begin, visited_begin);
+      size_t skip_end = std::min(block.end, visited_end);
+      if ((skip_begin == block.begin && skip_end == block.end) || distanceToBlock(p, block) > min_distance + 1e-9)
+      {
+        continue;
+      }
+      for (size_t i = block.begin; i < block.end; i++)
+      {
+        if (i == skip_begin && skip_begin < skip_end)
+        {
+          i = skip_end - 1;
+          continue;
+        }
+        double distance = lanelet::geometry::distance2d(p, line_string[i]);
+        if (distance < min_distance || (distance == min_distance && i < best_point_index))
+        {
+          min_distance = distance;
+          best_point_index = i;
+        }
+      }
+    }
+
+    // Gather the same segment lengths matchSegment records for the nearest vertex
+    double best_last_accumulated_length = 0;
+    double best_accumulated_length = 0;
+    double best_last_seg_length = 0;
+    double best_seg_length = 0;
+    if (best_point_index > 0)
+    {
+      best_last_accumulated_length = lengths.lengthTo(best_point_index - 1);
+      best_last_seg_length = lengths.segmentLength(best_point_index - 1);
+      best_accumulated_length = best_last_accumulated_length + best_last_seg_length;
+      if (best_point_index < vertex_count - 1)
+      {
+        best_seg_length = lengths.segmentLength(best_point_index);
+      }
+    }
+
+    size_t segment_start_index = 0;
+    output.push_back(trackPosFromNearestPoint(p, line_string, best_point_index, best_accumulated_length,
+                                              best_last_accumulated_length, best_seg_length, best_last_seg_length,
+                                              segment_start_index));
+    hint = best_point_index;
+  }
+}
+
+void pointsFromTrackPos(const lanelet::BasicLineString2d& line_string, const std::vector<TrackPos>& track_positions,
+                        std::vector<lanelet::BasicPoint2d>& output)
+{
+  if (line_string.size() < 2)
+  {
+    throw std::invalid_argument("Provided with linestring containing fewer than 2 points");
+  }
+
+  output.clear();
+  output.reserve(track_positions.size());
+
+  const size_t last_segment = line_string.size() - 2;
+  size_t segment = 0;
+  double segment_start = 0;  // Downtrack of the first point of segment
+  double segment_length = lanelet::geometry::distance2d(line_string[0], line_string[1]);
+
+  for (const auto& track_pos : track_positions)
+  {
+    // Walk to the segment containing the downtrack. Downtracks outside the line string stay on the end segments
+    while (segment < last_segment && segment_start + segment_length <= track_pos.downtrack)
+    {
+      segment_start += segment_length;
+      segment++;
+      segment_length = lanelet::geometry::distance2d(line_string[segment], line_string[segment + 1]);
+    }
+    while (segment > 0 && track_pos.downtrack < segment_start)
+    {
+      segment--;
+      segment_length = lanelet::geometry::distance2d(line_string[segment], line_string[segment + 1]);
+      segment_start -= segment_length;
+    }
+
+    const lanelet::BasicPoint2d& start = line_string[segment];
+    if (segment_length == 0)
+    {
+      output.push_back(start);
+      continue;
+    }
+
+    // Positive crosstrack is to the right of the segment direction
+    lanelet::BasicPoint2d direction = (line_string[segment + 1] - start) / segment_length;
+    lanelet::BasicPoint2d right(direction.y(), -direction.x());
+    output.emplace_back(start + direction * (track_pos.downtrack - segment_start) + right * track_pos.crosstrack);
+  }
 }
 
 // NOTE: See Geometry.h header file for details on source of logic in this function
@@ -332,23 +570,8 @@ template <class P, class A>
 std::vector<double>
 templated_local_curvatures(const std::vector<P, A>& centerline_points)
 {
-
-  if (centerline_points.empty()) {
-    throw std::invalid_argument("No points in centerline for curvature calculation");
-  }
-
-  std::vector<Eigen::Vector2d> spatial_derivative = compute_finite_differences(centerline_points);
-  std::vector<Eigen::Vector2d> normalized_tangent_vectors = normalize_vectors(spatial_derivative);
-
-  std::vector<double> arc_lengths = compute_arc_lengths(centerline_points);
-
-  std::vector<Eigen::Vector2d> tangent_derivative = 
-    compute_finite_differences(
-      normalized_tangent_vectors, 
-      arc_lengths);
-
-  std::vector<double> curvature = compute_magnitude_of_vectors(tangent_derivative);
-
+  std::vector<double> curvature(centerline_points.size());
+  local_curvatures(makePointArrayView(centerline_points), curvature.data());
   return curvature;
 }
 
@@ -390,28 +613,11 @@ template <class P, class A>
 std::vector<Eigen::Vector2d> 
 compute_templated_finite_differences(const std::vector<P,A>& data)
 {
-  std::vector<Eigen::Vector2d> out;
-  Eigen::Vector2d diff;
-  Eigen::Vector2d vec_i_plus_1;
-  Eigen::Vector2d vec_i_minus_1;
-
-  for (size_t i = 0; i < data.size(); i++) {
-    if (i == 0) {
-      // Compute forward derivative
-      diff = (data[i + 1] - data[i]);
-    } else if (i == data.size() - 1) {
-      // Compute backward derivative
-      diff = (data[i] - data[i - 1]);
-    } else {
-      // Else, compute centered derivative
-      vec_i_plus_1 = data[i + 1];
-      vec_i_minus_1 = data[i - 1];
-      diff = (vec_i_plus_1 - vec_i_minus_1)/2.0;
-    }
-
-    out.push_back(diff);
+  std::vector<Eigen::Vector2d> out(data.size());
+  if (!out.empty()) {
+    // Eigen::Vector2d elements are stored as contiguous x,y pairs
+    compute_finite_differences(makePointArrayView(data), &out[0][0], &out[0][1], 2);
   }
-
   return out;
 }
 
@@ -473,19 +679,8 @@ compute_finite_differences(const std::vector<Eigen::Vector2d>& x,const std::vect
 template <class P, class A>
 std::vector<double>
 compute_templated_arc_lengths(const std::vector<P, A>& data) {
-  std::vector<double> out;
-  double total = 0;
-  double diff = 0;
-  for (size_t i =  0; i < data.size(); i++) {
-    if (i == 0) {
-      out.push_back(0);
-    } else {
-      diff = compute_euclidean_distance(data[i - 1], data[i]);
-      total += diff;
-      out.push_back(total);
-    }
-  }
-
+  std::vector<double> out(data.size());
+  compute_arc_lengths(makePointArrayView(data), out.data());
   return out;
 }
 
@@ -531,27 +726,8 @@ template<class P, class A>
 std::vector<double>
 compute_templated_tangent_orientations(const std::vector<P,A>& centerline)
 {
-  std::vector<double> out;
-  if (centerline.empty())
-    return out;
-
-  std::vector<Eigen::Vector2d> tangents = carma_wm::geometry::compute_templated_finite_differences(centerline);
-
-  for (auto tangent : tangents)
-  {
-    geometry_msgs::Quaternion q;
-
-    // Derive angle by cos theta = (u . v)/(||u| * ||v||)
-    double yaw = 0;
-    double norm = tangent.norm();
-    if (norm != 0.0) {
-      auto normalized_tanged = tangent / norm;
-      yaw = atan2(normalized_tanged[1], normalized_tanged[0]);
-    }
-
-    out.push_back(yaw);
-  }
-
+  std::vector<double> out(centerline.size());
+  compute_tangent_orientations(makePointArrayView(centerline), out.data());
   return out;
 }
 
@@ -608,32 +784,223 @@ double circular_arc_curvature(const lanelet::BasicPoint2d& cur_point, const lane
 }
 
 std::vector<double> local_circular_arc_curvatures(const std::vector<lanelet::BasicPoint2d>& points, int lookahead) {
-  std::vector<double> curvatures;
-  curvatures.reserve(points.size());
-
   if (lookahead <= 0) {
     throw std::invalid_argument("local_circular_arc_curvatures lookahead must be greater than 0");
   }
 
-  if (points.empty()) {
-    return curvatures;
+  std::vector<double> curvatures(points.size());
+  local_circular_arc_curvatures(makePointArrayView(points), lookahead, curvatures.data());
+  return curvatures;
+}
+
+static_assert(sizeof(lanelet::BasicPoint2d) == 2 * sizeof(double), "BasicPoint2d must be stored as an x,y pair");
+
+PointArrayView makePointArrayView(const double* x, const double* y, size_t size)
+{
+  PointArrayView view;
+  view.x = x;
+  view.y = y;
+  view.size = size;
+  view.stride = 1;
+  return view;
+}
+
+PointArrayView makePointArrayView(const lanelet::BasicLineString2d& points)
+{
+  PointArrayView view;
+  view.size = points.size();
+  view.stride = 2;
+  if (!points.empty())
+  {
+    view.x = points.front().data();
+    view.y = view.x + 1;
+  }
+  return view;
+}
+
+PointArrayView makePointArrayView(const std::vector<lanelet::BasicPoint2d>& points)
+{
+  PointArrayView view;
+  view.size = points.size();
+  view.stride = 2;
+  if (!points.empty())
+  {
+    view.x = points.front().data();
+    view.y = view.x + 1;
+  }
+  return view;
+}
+
+void compute_finite_differences(const PointArrayView& points, double* dx_out, double* dy_out, size_t out_stride)
+{
+  const size_t n = points.size;
+  if (n == 0)
+  {
+    return;
+  }
+  if (n == 1)
+  {
+    dx_out[0] = 0;
+    dy_out[0] = 0;
+    return;
+  }
+
+  // Forward derivative for the first point and backward derivative for the last
+  dx_out[0] = points.xAt(1) - points.xAt(0);
+  dy_out[0] = points.yAt(1) - points.yAt(0);
+  dx_out[(n - 1) * out_stride] = points.xAt(n - 1) - points.xAt(n - 2);
+  dy_out[(n - 1) * out_stride] = points.yAt(n - 1) - points.yAt(n - 2);
+
+  // Centered derivatives. Kept branch free so the loop can be vectorized
+  for (size_t i = 1; i < n - 1; i++)
+  {
+    dx_out[i * out_stride] = (points.xAt(i + 1) - points.xAt(i - 1)) / 2.0;
+    dy_out[i * out_stride] = (points.yAt(i + 1) - points.yAt(i - 1)) / 2.0;
+  }
+}
+
+void compute_arc_lengths(const PointArrayView& points, double* arc_lengths_out)
+{
+  compute_centerline_geometry(points, arc_lengths_out, nullptr, nullptr);
+}
+
+void compute_tangent_orientations(const PointArrayView& points, double* orientations_out)
+{
+  compute_centerline_geometry(points, nullptr, orientations_out, nullptr);
+}
+
+void local_curvatures(const PointArrayView& points, double* curvatures_out)
+{
+  if (points.size == 0)
+  {
+    throw std::invalid_argument("No points in centerline for curvature calculation");
+  }
+  compute_centerline_geometry(points, nullptr, nullptr, curvatures_out);
+}
+
+void local_circular_arc_curvatures(const PointArrayView& points, int lookahead, double* curvatures_out)
+{
+  if (lookahead <= 0)
+  {
+    throw std::invalid_argument("local_circular_arc_curvatures lookahead must be greater than 0");
+  }
+
+  const size_t n = points.size;
+  if (n == 0)
+  {
+    return;
+  }
+  else if (n == 1)
+  {
+    curvatures_out[0] = 0.0;
+    return;
+  }
+
+  for (size_t i = 0; i < n - 1; i++)
+  {
+    size_t next_point_index = std::min(i + static_cast<size_t>(lookahead), n - 1);
+    double cur = circular_arc_curvature(lanelet::BasicPoint2d(points.xAt(i), points.yAt(i)),
+                                        lanelet::BasicPoint2d(points.xAt(next_point_index), points.yAt(next_point_index)));
+    curvatures_out[i] = fabs(cur);
+  }
+  curvatures_out[n - 1] = curvatures_out[n - 2];
+}
+
+void compute_centerline_geometry(const PointArrayView& points, double* arc_lengths_out, double* orientations_out,
+                                 double* curvatures_out)
+{
+  const size_t n = points.size;
+  if (n == 0)
+  {
+    return;
   }
-  else if (points.size() == 1) {
-    curvatures.push_back(0.0);
-    return curvatures;
+  if (n == 1)
+  {
+    if (arc_lengths_out)
+      arc_lengths_out[0] = 0;
+    if (orientations_out)
+      orientations_out[0] = 0;
+    if (curvatures_out)
+      curvatures_out[0] = 0;
+    return;
   }
 
-  for (size_t i = 0; i < points.size() - 1; i++)
+  // Unit tangents and arc lengths of the previous two points are kept so the curvature of point i - 1 can be computed
+  // from the tangents of its neighbors once point i is reached
+  double tx_prev = 0, ty_prev = 0, s_prev = 0;  // Point i - 2
+  double tx_cur = 0, ty_cur = 0, s_cur = 0;     // Point i - 1
+  double arc_length = 0;
+
+  for (size_t i = 0; i < n; i++)
   {
-    size_t next_point_index = i + lookahead;
-    if (next_point_index >= points.size()) {
-      next_point_index = points.size() - 1;
+    // Finite difference matching compute_finite_differences
+    double dx, dy;
+    if (i == 0)
+    {
+      dx = points.xAt(1) - points.xAt(0);
+      dy = points.yAt(1) - points.yAt(0);
+    }
+    else if (i == n - 1)
+    {
+      dx = points.xAt(i) - points.xAt(i - 1);
+      dy = points.yAt(i) - points.yAt(i - 1);
+    }
+    else
+    {
+      dx = (points.xAt(i + 1) - points.xAt(i - 1)) / 2.0;
+      dy = (points.yAt(i + 1) - points.yAt(i - 1)) / 2.0;
+    }
+
+    // Unit tangent. Zero length tangents are left unchanged as Eigen's normalized() does
+    double tx = dx, ty = dy;
+    double squared_norm = dx * dx + dy * dy;
+    double norm = std::sqrt(squared_norm);
+    if (squared_norm > 0)
+    {
+      tx = dx / norm;
+      ty = dy / norm;
+    }
+
+    if (orientations_out)
+    {
+      orientations_out[i] = norm != 0.0 ? atan2(ty, tx) : 0.0;
+    }
+
+    if (i > 0)
+    {
+      double seg_x = points.xAt(i) - points.xAt(i - 1);
+      double seg_y = points.yAt(i) - points.yAt(i - 1);
+      arc_length += std::sqrt(seg_x * seg_x + seg_y * seg_y);
     }
-    double cur = circular_arc_curvature(points[i], points[next_point_index]);
-    curvatures.push_back(fabs(cur));
+    if (arc_lengths_out)
+    {
+      arc_lengths_out[i] = arc_length;
+    }
+
+    if (curvatures_out && i > 0)
+    {
+      // Derivative of the unit tangent with respect to arc length at point i - 1. Forward difference for the first point
+      double ds = i == 1 ? arc_length - s_cur : arc_length - s_prev;
+      double dtx = i == 1 ? (tx - tx_cur) / ds : (tx - tx_prev) / ds;
+      double dty = i == 1 ? (ty - ty_cur) / ds : (ty - ty_prev) / ds;
+      curvatures_out[i - 1] = std::sqrt(dtx * dtx + dty * dty);
+
+      if (i == n - 1)
+      {
+        // Backward difference for the last point
+        double last_dtx = (tx - tx_cur) / (arc_length - s_cur);
+        double last_dty = (ty - ty_cur) / (arc_length - s_cur);
+        curvatures_out[i] = std::sqrt(last_dtx * last_dtx + last_dty * last_dty);
+      }
+    }
+
+    tx_prev = tx_cur;
+    ty_prev = ty_cur;
+    s_prev = s_cur;
+    tx_cur = tx;
+    ty_cur = ty;
+    s_cur = arc_length;
   }
-  curvatures.push_back(curvatures.back());
-  return curvatures;
 }
 
 
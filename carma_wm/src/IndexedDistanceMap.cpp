@@ -18,26 +18,52 @@
 
 namespace carma_wm
 {
+namespace
+{
+/*!
+ * \brief Binary search which returns the number of values in the sorted range [first, first + count) which are less
+ * than or equal to value. The loop body only selects between two pointers so it compiles to a conditional move
+ * rather than a branch which avoids misprediction stalls on large routes.
+ */
+size_t countLessOrEqual(const double* first, size_t count, double value)
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+  const double* base = first;
+  size_t n = count;
+  while (n > 1)
+  {
+    size_t half = n / 2;
+    base = (base[half] <= value) ? base + half : base;
+    n -= half;
+  }
+  return (base - first) + (*base <= value ? 1 : 0);
+}
+}  // namespace
+
 void IndexedDistanceMap::pushBack(const lanelet::LineString2d& ls)
 {
   if (id_index_map.find(ls.id()) != id_index_map.end())
   {
     throw std::invalid_argument("IndexedDistanceMap already contains this ls");
   }
-  std::vector<double> accumulated_dist;
-  accumulated_dist.reserve(ls.size());
-  accumulated_dist.push_back(0);
-  size_t ls_i = accum_lengths.size();
+  size_t ls_i = element_distances.size();
+  double element_distance = totalLength();
+
+  point_distances.reserve(point_distances.size() + ls.size());
+  point_distances.push_back(0);
   id_index_map[ls.front().id()] = std::make_pair(ls_i, 0);  // Add first point to id map
   for (size_t i = 0; i < ls.numSegments(); i++)
   {
     auto segment = ls.segment(i);
     double dist = lanelet::geometry::distance2d(segment.first, segment.second);  // length of line string
-    accumulated_dist.push_back(dist + accumulated_dist.back());                  // Distance along linestring
+    point_distances.push_back(dist + point_distances.back());                    // Distance along linestring
     id_index_map[segment.second.id()] = std::make_pair(ls_i, i + 1);             // Add point id and index to map
   }
-  auto tuple = std::make_tuple(accumulated_dist, totalLength());
-  accum_lengths.push_back(tuple);
+  element_distances.push_back(element_distance);
+  element_offsets.push_back(point_distances.size());
   id_index_map[ls.id()] = std::make_pair(ls_i, 0);  // Add linestirng id
 }
 
@@ -48,26 +74,29 @@ size_t IndexedDistanceMap::getElementIndexByDistance(double distance) const {
   if (distance > totalLength()) {
     throw std::invalid_argument("Distance cannot be greater than distance map length");
   }
-  if (accum_lengths.size() == 0) {
+  if (element_distances.size() == 0) {
     throw std::invalid_argument("No data available in distance map");
   }
 
-  auto low = std::lower_bound (accum_lengths.begin(), accum_lengths.end(), distance, // Binary search to find the index 
-    [](const std::tuple<std::vector<double>, double>& a, const double& b){return std::get<1>(a) < b;});
-  if (low == accum_lengths.end()) { // If we reached the end, it means we should pick the final point since we already checked the bounds
-    return accum_lengths.size() - 1;
-  }
-  return low - accum_lengths.begin();
+  // The matching element is the last one starting at or before the distance. The first element always starts at 0 so the count is at least 1
+  size_t count = countLessOrEqual(element_distances.data(), element_distances.size(), distance);
+  return count == 0 ? 0 : count - 1;
+}
+
+size_t IndexedDistanceMap::getPointIndexByDistance(size_t index, double distance) const
+{
+  size_t count = countLessOrEqual(point_distances.data() + element_offsets[index], size(index), distance);
+  return count == 0 ? 0 : count - 1;
 }
 
 double IndexedDistanceMap::elementLength(size_t index) const
 {
-  return std::get<0>(accum_lengths[index]).back();
+  return point_distances[element_offsets[index + 1] - 1];
 }
 
 double IndexedDistanceMap::distanceToElement(size_t index) const
 {
-  return std::get<1>(accum_lengths[index]);
+  return element_distances[index];
 }
 
 double IndexedDistanceMap::distanceBetween(size_t index, size_t p1_index, size_t p2_index) const
@@ -77,16 +106,16 @@ double IndexedDistanceMap::distanceBetween(size_t index, size_t p1_index, size_t
 
 double IndexedDistanceMap::distanceToPointAlongElement(size_t index, size_t point_index) const
 {
-  return std::get<0>(accum_lengths[index])[point_index];
+  return point_distances[element_offsets[index] + point_index];
 }
 
 double IndexedDistanceMap::totalLength() const
 {
-  if (accum_lengths.size() == 0)
+  if (element_distances.size() == 0)
   {
     return 0.0;
   }
-  return distanceToElement(accum_lengths.size() - 1) + elementLength(accum_lengths.size() - 1);
+  return distanceToElement(element_distances.size() - 1) + elementLength(element_distances.size() - 1);
 }
 
 std::pair<size_t, size_t> IndexedDistanceMap::getIndexFromId(const lanelet::Id& id) const
@@ -96,12 +125,12 @@ std::pair<size_t, size_t> IndexedDistanceMap::getIndexFromId(const lanelet::Id&
 
 size_t IndexedDistanceMap::size() const
 {
-  return accum_lengths.size();
+  return element_distances.size();
 }
 
 size_t IndexedDistanceMap::size(size_t index) const
 {
-  return std::get<0>(accum_lengths[index]).size();
+  return element_offsets[index + 1] - element_offsets[index];
 }
 
 }  // namespace carma_wm
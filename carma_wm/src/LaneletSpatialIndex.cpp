@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <carma_wm/LaneletSpatialIndex.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/primitives/Traits.h>
+#include <algorithm>
+#include <iterator>
+
+namespace carma_wm
+{
+namespace bgi = boost::geometry::index;
+
+LaneletGeometry LaneletSpatialIndex::computeGeometry(const lanelet::ConstLanelet& lanelet)
+{
+  lanelet::ConstLanelet forward = lanelet.inverted() ? lanelet.invert() : lanelet;
+
+  LaneletGeometry geometry;
+  geometry.data = forward.constData().get();
+  geometry.polygon = forward.polygon2d().basicPolygon();
+  boost::geometry::envelope(geometry.polygon, geometry.bounding_box);
+  geometry.centerline = lanelet::utils::to2D(forward.centerline()).basicLineString();
+  return geometry;
+}
+
+void LaneletSpatialIndex::build(const lanelet::LaneletLayer& layer)
+{
+  std::vector<Value> values;
+  values.reserve(layer.size());
+  geometry_.clear();
+  geometry_.reserve(layer.size());
+
+  for (const auto& lanelet : layer)
+  {
+    LaneletGeometry geometry = computeGeometry(lanelet);
+    values.emplace_back(geometry.bounding_box, lanelet.id());
+    geometry_.emplace(lanelet.id(), std::move(geometry));
+  }
+
+  // The range constructor uses packing which builds a better balanced tree than repeated insertion
+  tree_ = decltype(tree_)(values.begin(), values.end());
+}
+
+void LaneletSpatialIndex::update(const lanelet::LaneletLayer& layer, const std::vector<lanelet::Id>& lanelet_ids)
+{
+  for (auto id : lanelet_ids)
+  {
+    auto existing = geometry_.find(id);
+    if (existing != geometry_.end())
+    {
+      tree_.remove(Value(existing->second.bounding_box, id));
+      geometry_.erase(existing);
+    }
+
+    auto lanelet = layer.find(id);
+    if (lanelet == layer.end())
+    {
+      continue;
+    }
+
+    LaneletGeometry geometry = computeGeometry(*lanelet);
+    tree_.insert(Value(geometry.bounding_box, id));
+    geometry_.emplace(id, std::move(geometry));
+  }
+}
+
+std::vector<lanelet::Id> LaneletSpatialIndex::candidates(const lanelet::BasicPoint2d& point) const
+{
+  std::vector<lanelet::Id> ids;
+  std::for_each(tree_.qbegin(bgi::intersects(point)), tree_.qend(),
+                [&ids](const Value& value) { ids.push_back(value.second); });
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+const LaneletGeometry* LaneletSpatialIndex::geometry(lanelet::Id id) const
+{
+  auto geometry = geometry_.find(id);
+  if (geometry == geometry_.end())
+  {
+    return nullptr;
+  }
+  return &geometry->second;
+}
+
+const LaneletGeometry* LaneletSpatialIndex::geometry(const lanelet::ConstLanelet& lanelet) const
+{
+  const LaneletGeometry* geometry = this->geometry(lanelet.id());
+  if (!geometry || geometry->data != lanelet.constData().get())
+  {
+    return nullptr;
+  }
+  return geometry;
+}
+
+size_t LaneletSpatialIndex::size() const
+{
+  return geometry_.size();
+}
+
+void LaneletSpatialIndex::clear()
+{
+  tree_.clear();
+  geometry_.clear();
+}
+}  // namespace carma_wm
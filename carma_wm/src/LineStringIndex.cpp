@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <carma_wm/LineStringIndex.h>
+#include <carma_wm/Geometry.h>
+#include <lanelet2_core/geometry/Point.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace carma_wm
+{
+namespace geometry
+{
+namespace
+{
+// Maximum number of vertices stored in a leaf node
+constexpr uint32_t LEAF_SIZE = 8;
+
+// Deep enough for any tree with fewer than 2^64 leaves
+constexpr size_t MAX_TREE_DEPTH = 64;
+
+// Tolerance used when pruning nodes so that rounding in the box distance can never discard the nearest vertex
+constexpr double PRUNE_TOLERANCE = 1e-9;
+
+template <typename NodeT>
+double distanceToNode(const lanelet::BasicPoint2d& p, const NodeT& node)
+{
+  double dx = std::max({ node.min_x - p.x(), 0.0, p.x() - node.max_x });
+  double dy = std::max({ node.min_y - p.y(), 0.0, p.y() - node.max_y });
+  return std::sqrt(dx * dx + dy * dy);
+}
+}  // namespace
+
+LineStringIndex::LineStringIndex(const lanelet::BasicLineString2d& line_string) : points_(line_string)
+{
+  if (points_.size() < 2)
+  {
+    throw std::invalid_argument("Provided with linestring containing fewer than 2 points");
+  }
+  if (points_.size() > std::numeric_limits<uint32_t>::max())
+  {
+    throw std::invalid_argument("Provided linestring is too large to index");
+  }
+
+  // Lengths are accumulated front to back in the same order as matchSegment so the results match exactly
+  accumulated_lengths_.resize(points_.size());
+  accumulated_lengths_[0] = 0;
+  for (size_t i = 1; i < points_.size(); i++)
+  {
+    accumulated_lengths_[i] = accumulated_lengths_[i - 1] + lanelet::geometry::distance2d(points_[i - 1], points_[i]);
+  }
+
+  nodes_.reserve(2 * (points_.size() / LEAF_SIZE + 1));
+  build(0, static_cast<uint32_t>(points_.size()));
+}
+
+int32_t LineStringIndex::build(uint32_t begin, uint32_t end)
+{
+  int32_t index = static_cast<int32_t>(nodes_.size());
+  nodes_.emplace_back();
+
+  Node node;
+  node.begin = begin;
+  node.end = end;
+  node.left = -1;
+  node.right = -1;
+
+  if (end - begin <= LEAF_SIZE)
+  {
+    node.min_x = node.max_x = points_[begin].x();
+    node.min_y = node.max_y = points_[begin].y();
+    for (uint32_t i = begin + 1; i < end; i++)
+    {
+      node.min_x = std::min(node.min_x, points_[i].x());
+      node.max_x = std::max(node.max_x, points_[i].x());
+      node.min_y = std::min(node.min_y, points_[i].y());
+      node.max_y = std::max(node.max_y, points_[i].y());
+    }
+  }
+  else
+  {
+    // Splitting by vertex order keeps each node a connected piece of the line string which is spatially compact for
+    // the smooth line strings found in maps
+    uint32_t middle = begin + (end - begin) / 2;
+    node.left = build(begin, middle);
+    node.right = build(middle, end);
+
+    const Node& left = nodes_[node.left];
+    const Node& right = nodes_[node.right];
+    node.min_x = std::min(left.min_x, right.min_x);
+    node.max_x = std::max(left.max_x, right.max_x);
+    node.min_y = std::min(left.min_y, right.min_y);
+    node.max_y = std::max(left.max_y, right.max_y);
+  }
+
+  nodes_[index] = node;
+  return index;
+}
+
+size_t LineStringIndex::nearestVertex(const lanelet::BasicPoint2d& p) const
+{
+  // Matches the initial state of matchSegment
+  return nearestVertex(p, 0, lanelet::geometry::distance2d(p, points_[0]), 0, 1);
+}
+
+size_t LineStringIndex::nearestVertex(const lanelet::BasicPoint2d& p, size_t best_point_index, double min_distance,
+                                      size_t skip_begin, size_t skip_end) const
+{
+  std::array<int32_t, MAX_TREE_DEPTH + 1> stack;
+  size_t stack_size = 0;
+  stack[stack_size++] = 0;
+
+  while (stack_size > 0)
+  {
+    const Node& node = nodes_[stack[--stack_size]];
+    if ((node.begin >= skip_begin && node.end <= skip_end) ||
+        distanceToNode(p, node) > min_distance + PRUNE_TOLERANCE)
+    {
+      continue;
+    }
+
+    if (node.left < 0)
+    {
+      for (size_t i = node.begin; i < node.end; i++)
+      {
+        if (i >= skip_begin && i < skip_end)
+        {
+          continue;
+        }
+        double distance = lanelet::geometry::distance2d(p, points_[i]);
+        if (distance < min_distance || (distance == min_distance && i < best_point_index))
+        {
+          min_distance = distance;
+          best_point_index = i;
+        }
+      }
+      continue;
+    }
+
+    // Push the farther child first so the nearer child is searched first and tightens the bound sooner
+    const Node& left = nodes_[node.left];
+    const Node& right = nodes_[node.right];
+    if (distanceToNode(p, left) <= distanceToNode(p, right))
+    {
+      stack[stack_size++] = node.right;
+      stack[stack_size++] = node.left;
+    }
+    else
+    {
+      stack[stack_size++] = node.left;
+      stack[stack_size++] = node.right;
+    }
+  }
+
+  return best_point_index;
+}
+
+TrackPos LineStringIndex::trackPos(const lanelet::BasicPoint2d& p, size_t& segment_start_index) const
+{
+  return trackPosFromNearestVertex(p, nearestVertex(p), segment_start_index);
+}
+
+TrackPos LineStringIndex::trackPosFromNearestVertex(const lanelet::BasicPoint2d& p, size_t best_point_index,
+                                                    size_t& segment_start_index) const
+{
+  // Gather the same segment lengths matchSegment records for the nearest vertex
+  double best_accumulated_length = accumulated_lengths_[best_point_index];
+  double best_last_accumulated_length = 0;
+  double best_last_seg_length = 0;
+  double best_seg_length = 0;
+  if (best_point_index > 0)
+  {
+    best_last_accumulated_length = accumulated_lengths_[best_point_index - 1];
+    best_last_seg_length = lanelet::geometry::distance2d(points_[best_point_index - 1], points_[best_point_index]);
+  }
+  if (best_point_index < points_.size() - 1)
+  {
+    best_seg_length = lanelet::geometry::distance2d(points_[best_point_index], points_[best_point_index + 1]);
+  }
+
+  return trackPosFromNearestPoint(p, points_, best_point_index, best_accumulated_length, best_last_accumulated_length,
+                                  best_seg_length, best_last_seg_length, segment_start_index);
+}
+
+std::tuple<TrackPos, lanelet::BasicSegment2d> LineStringIndex::matchSegment(const lanelet::BasicPoint2d& p) const
+{
+  size_t segment_start_index = 0;
+  TrackPos pos = trackPos(p, segment_start_index);
+  return std::make_tuple(pos, std::make_pair(points_[segment_start_index], points_[segment_start_index + 1]));
+}
+
+TrackPos LineStringIndex::trackPos(const lanelet::BasicPoint2d& p) const
+{
+  size_t segment_start_index = 0;
+  return trackPos(p, segment_start_index);
+}
+
+void LineStringIndex::trackPos(const std::vector<lanelet::BasicPoint2d>& points, std::vector<TrackPos>& output) const
+{
+  output.clear();
+  output.reserve(points.size());
+
+  const size_t vertex_count = points_.size();
+  size_t hint = 0;
+
+  for (const auto& p : points)
+  {
+    // Descend from the previous nearest vertex to a local minimum in the same way as the batch geometry::trackPos
+    size_t best_point_index = hint;
+    double min_distance = lanelet::geometry::distance2d(p, points_[best_point_index]);
+    while (best_point_index + 1 < vertex_count)
+    {
+      double distance = lanelet::geometry::distance2d(p, points_[best_point_index + 1]);
+      if (distance >= min_distance)
+        break;
+      min_distance = distance;
+      best_point_index++;
+    }
+    size_t visited_end = std::min(best_point_index + 2, vertex_count);
+    while (best_point_index > 0)
+    {
+      double distance = lanelet::geometry::distance2d(p, points_[best_point_index - 1]);
+      if (distance > min_distance)
+        break;
+      min_distance = distance;
+      best_point_index--;
+    }
+    size_t visited_begin = best_point_index > 0 ? best_point_index - 1 : 0;
+
+    // The vertices checked by the descent are no nearer than the local minimum, so only the rest of the hierarchy
+    // needs to be searched for a closer vertex
+    best_point_index = nearestVertex(p, best_point_index, min_distance, visited_begin, visited_end);
+
+    size_t segment_start_index = 0;
+    output.push_back(trackPosFromNearestVertex(p, best_point_index, segment_start_index));
+    hint = best_point_index;
+  }
+}
+
+const lanelet::BasicLineString2d& LineStringIndex::lineString() const
+{
+  return points_;
+}
+
+double LineStringIndex::length() const
+{
+  return accumulated_lengths_.back();
+}
+
+LineStringIndexCache::LineStringIndexCache(size_t capacity) : capacity_(capacity)
+{
+}
+
+LineStringIndexConstPtr LineStringIndexCache::get(const lanelet::ConstLineString2d& line_string)
+{
+  return get(Key{ Kind::LINE_STRING, line_string.id(), line_string.inverted() }, line_string);
+}
+
+LineStringIndexConstPtr LineStringIndexCache::getCenterline(const lanelet::ConstLanelet& lanelet)
+{
+  return get(Key{ Kind::CENTERLINE, lanelet.id(), lanelet.inverted() }, lanelet.centerline2d());
+}
+
+TrackPos LineStringIndexCache::trackPos(const lanelet::ConstLanelet& lanelet, const lanelet::BasicPoint2d& point)
+{
+  return getCenterline(lanelet)->trackPos(point);
+}
+
+LineStringIndexConstPtr LineStringIndexCache::get(const Key& key, const lanelet::ConstLineString2d& line_string)
+{
+  if (line_string.size() < 2)
+  {
+    throw std::invalid_argument("Provided with linestring containing fewer than 2 points");
+  }
+
+  if (key.id != lanelet::InvalId)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = indexes_.find(key);
+    if (it != indexes_.end())
+    {
+      const auto& cached = it->second->lineString();
+      if (cached.size() == line_string.size() && cached.front() == line_string.front().basicPoint() &&
+          cached.back() == line_string.back().basicPoint())
+      {
+        return it->second;
+      }
+    }
+  }
+
+  // Build outside of the lock so that concurrent lookups of other line strings are not blocked
+  auto index = std::make_shared<const LineStringIndex>(line_string.basicLineString());
+
+  if (key.id != lanelet::InvalId)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (indexes_.size() >= capacity_ && indexes_.find(key) == indexes_.end())
+    {
+      indexes_.clear();
+    }
+    indexes_[key] = index;
+  }
+
+  return index;
+}
+
+void LineStringIndexCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  indexes_.clear();
+}
+
+size_t LineStringIndexCache::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return indexes_.size();
+}
+
+}  // namespace geometry
+}  // namespace carma_wm
@@ -116,6 +116,10 @@ carma_debug_msgs::MapUpdateReadable mapUpdateCallback(const autoware_lanelet2_ms
   auto control = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
   carma_wm::fromBinMsg(*update, control);
 
+  if (control->isConsolidated()) {
+    ROS_INFO_STREAM("Map update is a consolidated update of all updates on map version " << update->map_version);
+  }
+
   carma_debug_msgs::MapUpdateReadable msg;
   msg.header = update->header;
   msg.format_version = update->format_version;
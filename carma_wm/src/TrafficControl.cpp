@@ -17,9 +17,176 @@
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <carma_wm/TrafficControl.h>
+#include <carma_wm/FlatBinaryMap.h>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+#include "FlatBinaryIO.h"
+
+#ifdef CARMA_WM_LZ4
+#include <lz4.h>
+#endif
 
 namespace carma_wm
 {
+namespace
+{
+using flat_binary::FlatReader;
+using flat_binary::FlatWriter;
+using flat_binary::ParameterRef;
+using flat_binary::ParameterType;
+
+using RegemPairs = std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>>;
+
+constexpr uint8_t COMPACT_MAP_UPDATE_MAGIC[4] = { 'C', 'W', 'M', 'U' };
+constexpr const char* COMPACT_MAP_UPDATE = "Compact map update";
+constexpr uint8_t COMPRESSED_FLAG = 1;
+
+// Messages written by toBinMsg start with the length of the boost archive signature so they never match the magic
+bool isCompactBinMsg(const autoware_lanelet2_msgs::MapBin& msg)
+{
+  return msg.data.size() >= sizeof(COMPACT_MAP_UPDATE_MAGIC) &&
+         std::equal(std::begin(COMPACT_MAP_UPDATE_MAGIC), std::end(COMPACT_MAP_UPDATE_MAGIC), msg.data.begin());
+}
+
+// Returns true if the primitive is the same object as the primitive with its id in the layer
+template <typename Layer, typename Primitive>
+bool isReferenced(const Layer* layer, const Primitive& primitive)
+{
+  if (!layer)
+  {
+    return false;
+  }
+  auto existing = layer->find(primitive.id());
+  return existing != layer->end() && existing->constData() == primitive.constData();
+}
+
+/**
+ * Adds a regulatory element parameter which is not part of the reference map to the map of primitives which are
+ * written in full. Lanelets and areas are copied without their regulatory elements.
+ */
+void addUnreferencedParameter(const lanelet::RuleParameter& parameter, const lanelet::LaneletMap* reference_map,
+                              lanelet::LaneletMap& embedded)
+{
+  if (auto point = boost::get<lanelet::Point3d>(&parameter))
+  {
+    if (!isReferenced(reference_map ? &reference_map->pointLayer : nullptr, *point) &&
+        !embedded.pointLayer.exists(point->id()))
+    {
+      embedded.add(*point);
+    }
+  }
+  else if (auto ls = boost::get<lanelet::LineString3d>(&parameter))
+  {
+    if (!isReferenced(reference_map ? &reference_map->lineStringLayer : nullptr, *ls) &&
+        !embedded.lineStringLayer.exists(ls->id()))
+    {
+      embedded.add(ls->inverted() ? ls->invert() : *ls);
+    }
+  }
+  else if (auto polygon = boost::get<lanelet::Polygon3d>(&parameter))
+  {
+    if (!isReferenced(reference_map ? &reference_map->polygonLayer : nullptr, *polygon) &&
+        !embedded.polygonLayer.exists(polygon->id()))
+    {
+      embedded.add(*polygon);
+    }
+  }
+  else if (auto weak_lanelet = boost::get<lanelet::WeakLanelet>(&parameter))
+  {
+    if (weak_lanelet->expired())
+    {
+      return;
+    }
+    lanelet::Lanelet llt = weak_lanelet->lock();
+    if (llt.inverted())
+    {
+      llt = llt.invert();
+    }
+    if (!isReferenced(reference_map ? &reference_map->laneletLayer : nullptr, llt) &&
+        !embedded.laneletLayer.exists(llt.id()))
+    {
+      lanelet::Lanelet copy(llt.id(), llt.leftBound(), llt.rightBound(), llt.attributes());
+      if (llt.hasCustomCenterline())
+      {
+        lanelet::ConstLineString3d centerline = llt.centerline();
+        copy.setCenterline(lanelet::LineString3d(
+            std::const_pointer_cast<lanelet::LineStringData>(centerline.constData()), centerline.inverted()));
+      }
+      embedded.add(copy);
+    }
+  }
+  else if (auto weak_area = boost::get<lanelet::WeakArea>(&parameter))
+  {
+    if (weak_area->expired())
+    {
+      return;
+    }
+    lanelet::Area area = weak_area->lock();
+    if (!isReferenced(reference_map ? &reference_map->areaLayer : nullptr, area) &&
+        !embedded.areaLayer.exists(area.id()))
+    {
+      embedded.add(lanelet::Area(area.id(), area.outerBound(), area.innerBounds(), area.attributes()));
+    }
+  }
+}
+
+/**
+ * Returns the primitive with the referenced id from the embedded primitives or else the reference map.
+ * Without a reference map unknown primitives are restored as placeholders which only carry their id.
+ */
+template <typename Primitive, typename Layer>
+Primitive resolvePrimitive(Layer& embedded, Layer* reference, const ParameterRef& ref, const char* primitive_name)
+{
+  auto primitive = embedded.find(ref.id);
+  if (primitive != embedded.end())
+  {
+    return *primitive;
+  }
+  if (!reference)
+  {
+    return Primitive(ref.id);
+  }
+  primitive = reference->find(ref.id);
+  if (primitive == reference->end())
+  {
+    throw std::invalid_argument(std::string(COMPACT_MAP_UPDATE) + " references unknown " + primitive_name + " " +
+                                std::to_string(ref.id));
+  }
+  return *primitive;
+}
+
+void writeRegemPairs(FlatWriter& writer, const std::vector<std::pair<lanelet::Id, uint32_t>>& pairs)
+{
+  writer.write<uint64_t>(pairs.size());
+  for (const auto& pair : pairs)
+  {
+    writer.write<lanelet::Id>(pair.first);
+    writer.write<uint32_t>(pair.second);
+  }
+}
+
+RegemPairs readRegemPairs(FlatReader& reader, const lanelet::RegulatoryElementPtrs& regems)
+{
+  uint64_t count = reader.readCount(sizeof(lanelet::Id) + sizeof(uint32_t));
+  RegemPairs pairs;
+  pairs.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    lanelet::Id lanelet_id = reader.read<lanelet::Id>();
+    uint32_t index = reader.read<uint32_t>();
+    if (index >= regems.size())
+    {
+      throw std::invalid_argument(std::string(COMPACT_MAP_UPDATE) + " references unknown regulatory element index " +
+                                  std::to_string(index));
+    }
+    pairs.emplace_back(lanelet_id, regems[index]);
+  }
+  return pairs;
+}
+
+}  // namespace
 
 void toBinMsg(std::shared_ptr<carma_wm::TrafficControl> gf_ptr, autoware_lanelet2_msgs::MapBin* msg)
 {
@@ -38,6 +205,107 @@ void toBinMsg(std::shared_ptr<carma_wm::TrafficControl> gf_ptr, autoware_lanelet
 }
 
 void fromBinMsg(const autoware_lanelet2_msgs::MapBin& msg, std::shared_ptr<carma_wm::TrafficControl> gf_ptr)
+{
+  fromBinMsg(msg, gf_ptr, nullptr);
+}
+
+void toCompactBinMsg(std::shared_ptr<carma_wm::TrafficControl> gf_ptr, autoware_lanelet2_msgs::MapBin* msg,
+                     lanelet::LaneletMapConstPtr reference_map, bool compress)
+{
+  if (msg == nullptr)
+  {
+    ROS_ERROR_STREAM(__FUNCTION__ << ": msg is null pointer!");
+    return;
+  }
+
+  // Each regulatory element is written once and paired with lanelets by index, as the boost archive tracks pointers
+  lanelet::RegulatoryElementPtrs regems;
+  std::unordered_map<const lanelet::RegulatoryElement*, uint32_t> regem_indices;
+  auto to_indexed_pairs = [&](const RegemPairs& pairs) {
+    std::vector<std::pair<lanelet::Id, uint32_t>> indexed_pairs;
+    indexed_pairs.reserve(pairs.size());
+    for (const auto& pair : pairs)
+    {
+      if (!pair.second)
+      {
+        throw std::invalid_argument("Map update for lanelet " + std::to_string(pair.first) +
+                                    " has a null regulatory element");
+      }
+      auto index = regem_indices.emplace(pair.second.get(), static_cast<uint32_t>(regems.size()));
+      if (index.second)
+      {
+        regems.push_back(pair.second);
+      }
+      indexed_pairs.emplace_back(pair.first, index.first->second);
+    }
+    return indexed_pairs;
+  };
+  auto remove_list = to_indexed_pairs(gf_ptr->remove_list_);
+  auto update_list = to_indexed_pairs(gf_ptr->update_list_);
+
+  lanelet::LaneletMap embedded;
+  for (const auto& regem : regems)
+  {
+    for (const auto& role : regem->getParameters())
+    {
+      for (const auto& parameter : role.second)
+      {
+        addUnreferencedParameter(parameter, reference_map.get(), embedded);
+      }
+    }
+  }
+  std::vector<uint8_t> embedded_data;
+  if (!embedded.empty())
+  {
+    toFlatBinary(embedded, embedded_data);
+  }
+
+  std::vector<uint8_t> payload;
+  FlatWriter payload_writer(payload);
+  payload_writer.writeBytes(gf_ptr->id_.begin(), gf_ptr->id_.size());
+  payload_writer.write<uint64_t>(embedded_data.size());
+  payload_writer.writeBytes(embedded_data.data(), embedded_data.size());
+  payload_writer.write<uint64_t>(regems.size());
+  for (const auto& regem : regems)
+  {
+    flat_binary::writeRegulatoryElement(payload_writer, *regem);
+  }
+  writeRegemPairs(payload_writer, remove_list);
+  writeRegemPairs(payload_writer, update_list);
+
+  msg->data.clear();
+  FlatWriter writer(msg->data);
+  writer.writeBytes(COMPACT_MAP_UPDATE_MAGIC, sizeof(COMPACT_MAP_UPDATE_MAGIC));
+  writer.write<uint32_t>(COMPACT_MAP_UPDATE_VERSION);
+
+  // LZ4 block compression is used as the uncompressed size is written in the header so the frame format is not needed
+#ifdef CARMA_WM_LZ4
+  if (compress && payload.size() <= LZ4_MAX_INPUT_SIZE)
+  {
+    std::vector<uint8_t> compressed(LZ4_compressBound(static_cast<int>(payload.size())));
+    int compressed_size =
+        LZ4_compress_default(reinterpret_cast<const char*>(payload.data()), reinterpret_cast<char*>(compressed.data()),
+                             static_cast<int>(payload.size()), static_cast<int>(compressed.size()));
+
+    // Small updates may not shrink in which case they are sent uncompressed
+    if (compressed_size > 0 && static_cast<size_t>(compressed_size) < payload.size())
+    {
+      writer.write<uint8_t>(COMPRESSED_FLAG);
+      writer.write<uint64_t>(payload.size());
+      writer.writeBytes(compressed.data(), static_cast<size_t>(compressed_size));
+      return;
+    }
+  }
+#else
+  (void)compress;  // Compression is unavailable so the payload is always sent uncompressed
+#endif
+
+  writer.write<uint8_t>(0);
+  writer.writeBytes(payload.data(), payload.size());
+}
+
+void fromBinMsg(const autoware_lanelet2_msgs::MapBin& msg, std::shared_ptr<carma_wm::TrafficControl> gf_ptr,
+                lanelet::LaneletMapPtr reference_map)
 {
   if (!gf_ptr)
   {
@@ -45,13 +313,125 @@ void fromBinMsg(const autoware_lanelet2_msgs::MapBin& msg, std::shared_ptr<carma
     return;
   }
 
-  std::string data_str;
-  data_str.assign(msg.data.begin(), msg.data.end());
-  
-  std::stringstream ss;
-  ss << data_str;
-  boost::archive::binary_iarchive oa(ss);
-  oa >> *gf_ptr;
+  if (!isCompactBinMsg(msg))
+  {
+    std::string data_str;
+    data_str.assign(msg.data.begin(), msg.data.end());
+
+    std::stringstream ss;
+    ss << data_str;
+    boost::archive::binary_iarchive oa(ss);
+    oa >> *gf_ptr;
+    return;
+  }
+
+  FlatReader header(msg.data.data(), msg.data.size(), COMPACT_MAP_UPDATE);
+  header.readBytes(sizeof(COMPACT_MAP_UPDATE_MAGIC));
+  uint32_t version = header.read<uint32_t>();
+  if (version != COMPACT_MAP_UPDATE_VERSION)
+  {
+    throw std::invalid_argument("Unsupported compact map update version " + std::to_string(version) + " expected " +
+                                std::to_string(COMPACT_MAP_UPDATE_VERSION));
+  }
+
+  uint8_t flags = header.read<uint8_t>();
+  std::vector<uint8_t> decompressed;
+  const uint8_t* payload;
+  size_t payload_size;
+  if (flags & COMPRESSED_FLAG)
+  {
+#ifdef CARMA_WM_LZ4
+    uint64_t raw_size = header.read<uint64_t>();
+    size_t compressed_size = header.remaining();
+    const uint8_t* compressed = header.readBytes(compressed_size);
+    if (raw_size > LZ4_MAX_INPUT_SIZE || compressed_size > LZ4_MAX_INPUT_SIZE)
+    {
+      throw std::invalid_argument("Compact map update is too large to decompress");
+    }
+    decompressed.resize(raw_size);
+    int size = LZ4_decompress_safe(reinterpret_cast<const char*>(compressed), reinterpret_cast<char*>(decompressed.data()),
+                                   static_cast<int>(compressed_size), static_cast<int>(raw_size));
+    if (size < 0 || static_cast<uint64_t>(size) != raw_size)
+    {
+      throw std::invalid_argument("Compact map update could not be decompressed");
+    }
+    payload = decompressed.data();
+    payload_size = decompressed.size();
+#else
+    throw std::invalid_argument("Compact map update is LZ4 compressed but carma_wm was built without LZ4 support");
+#endif
+  }
+  else
+  {
+    payload_size = header.remaining();
+    payload = header.readBytes(payload_size);
+  }
+
+  FlatReader reader(payload, payload_size, COMPACT_MAP_UPDATE);
+  boost::uuids::uuid id;
+  const uint8_t* id_bytes = reader.readBytes(id.size());
+  std::copy(id_bytes, id_bytes + id.size(), id.begin());
+
+  uint64_t embedded_size = reader.read<uint64_t>();
+  const uint8_t* embedded_data = reader.readBytes(embedded_size);
+  lanelet::LaneletMapPtr embedded =
+      embedded_size > 0 ? fromFlatBinary(embedded_data, embedded_size) : std::make_shared<lanelet::LaneletMap>();
+
+  // Regulatory elements only hold weak references to lanelets and areas so the update keeps them alive
+  std::vector<lanelet::ConstLaneletOrArea> lanelets_and_areas;
+  auto resolve_parameter = [&](const ParameterRef& ref) -> lanelet::RuleParameter {
+    switch (ref.type)
+    {
+      case ParameterType::POINT:
+        return resolvePrimitive<lanelet::Point3d>(embedded->pointLayer,
+                                                  reference_map ? &reference_map->pointLayer : nullptr, ref, "point");
+      case ParameterType::LINE_STRING:
+      {
+        auto ls = resolvePrimitive<lanelet::LineString3d>(
+            embedded->lineStringLayer, reference_map ? &reference_map->lineStringLayer : nullptr, ref, "line string");
+        return ref.inverted ? ls.invert() : ls;
+      }
+      case ParameterType::POLYGON:
+        return resolvePrimitive<lanelet::Polygon3d>(
+            embedded->polygonLayer, reference_map ? &reference_map->polygonLayer : nullptr, ref, "polygon");
+      case ParameterType::LANELET:
+      {
+        auto llt = resolvePrimitive<lanelet::Lanelet>(
+            embedded->laneletLayer, reference_map ? &reference_map->laneletLayer : nullptr, ref, "lanelet");
+        lanelets_and_areas.emplace_back(llt);
+        return lanelet::WeakLanelet(ref.inverted ? llt.invert() : llt);
+      }
+      default:
+      {
+        auto area = resolvePrimitive<lanelet::Area>(embedded->areaLayer,
+                                                    reference_map ? &reference_map->areaLayer : nullptr, ref, "area");
+        lanelets_and_areas.emplace_back(area);
+        return lanelet::WeakArea(area);
+      }
+    }
+  };
+
+  uint64_t regem_count = reader.readCount(sizeof(lanelet::Id));
+  lanelet::RegulatoryElementPtrs regems;
+  regems.reserve(regem_count);
+  for (uint64_t i = 0; i < regem_count; i++)
+  {
+    regems.push_back(flat_binary::readRegulatoryElement(reader, resolve_parameter));
+  }
+
+  RegemPairs remove_list = readRegemPairs(reader, regems);
+  RegemPairs update_list = readRegemPairs(reader, regems);
+
+  if (!reader.atEnd())
+  {
+    throw std::invalid_argument("Compact map update contains trailing data");
+  }
+
+  gf_ptr->id_ = id;
+  gf_ptr->remove_list_.insert(gf_ptr->remove_list_.end(), remove_list.begin(), remove_list.end());
+  gf_ptr->update_list_.insert(gf_ptr->update_list_.end(), update_list.begin(), update_list.end());
+  gf_ptr->lanelets_and_areas_.insert(gf_ptr->lanelets_and_areas_.end(), lanelets_and_areas.begin(),
+                                     lanelets_and_areas.end());
 }
 
 }  // namespace carma_wm
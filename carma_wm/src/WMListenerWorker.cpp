@@ -17,7 +17,9 @@
 #include <lanelet2_extension/utility/message_conversion.h>
 #include <lanelet2_extension/regulatory_elements/DirectionOfTravel.h>
 #include <lanelet2_extension/regulatory_elements/StopRule.h>
+#include <carma_wm/FlatBinaryMap.h>
 #include "WMListenerWorker.h"
+#include <algorithm>
 
 namespace carma_wm
 {
@@ -49,11 +51,11 @@ void WMListenerWorker::mapCallback(const autoware_lanelet2_msgs::MapBinConstPtr&
 {
   current_map_version_ = map_msg->map_version;
 
-  lanelet::LaneletMapPtr new_map(new lanelet::LaneletMap);
-
-  lanelet::utils::conversion::fromBinMsg(*map_msg, new_map);
+  // The map may be published in either the boost serialized or the flat binary map format
+  lanelet::LaneletMapPtr new_map = mapFromBinMsg(*map_msg);
 
   world_model_->setMap(new_map, current_map_version_);
+  base_lanelet_regems_.clear(); // Updates to the previous map version do not apply to the new map
 
   // After setting map evaluate the current update queue to apply any updates that arrived before the map
   bool more_updates_to_apply = true;
@@ -107,6 +109,7 @@ void WMListenerWorker::mapUpdateCallback(const autoware_lanelet2_msgs::MapBinPtr
 {
   ROS_INFO_STREAM("Map Update Being Evaluated. SeqNum: " << geofence_msg->header.seq);
 
+  // A consolidated update has the sequence number of the most recent update it includes so it is dropped if that update was already processed
   if (geofence_msg->header.seq <= most_recent_update_msg_seq_) {
     ROS_DEBUG_STREAM("Dropping map update which has already been processed. Received seq: " << geofence_msg->header.seq << " prev seq: " << most_recent_update_msg_seq_);
     return;
@@ -133,12 +136,43 @@ void WMListenerWorker::mapUpdateCallback(const autoware_lanelet2_msgs::MapBinPtr
      return;
     }
   }
-  // convert ros msg to geofence object
+  // convert ros msg to geofence object. Primitives which compact updates reference by id resolve to those of this map
   auto gf_ptr = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
-  carma_wm::fromBinMsg(*geofence_msg, gf_ptr);
+  carma_wm::fromBinMsg(*geofence_msg, gf_ptr, world_model_->getMutableMap());
 
   ROS_INFO_STREAM("Processing Map Update with Geofence Id:" << gf_ptr->id_);
 
+  // Record the routing relations of the edited lanelets so the routing graph is only rebuilt if they change
+  std::set<lanelet::Id> edited_lanelet_ids;
+  for (const auto& pair : gf_ptr->remove_list_)
+    edited_lanelet_ids.insert(pair.first);
+  for (const auto& pair : gf_ptr->update_list_)
+    edited_lanelet_ids.insert(pair.first);
+
+  // A consolidated update replaces the effect of every earlier update on this map version
+  bool consolidated = gf_ptr->isConsolidated();
+  if (consolidated)
+  {
+    for (const auto& base : base_lanelet_regems_)
+      edited_lanelet_ids.insert(base.first);
+  }
+
+  std::vector<double> relations_before_update = routingRelations(edited_lanelet_ids);
+
+  if (consolidated)
+  {
+    ROS_DEBUG_STREAM("Resetting " << base_lanelet_regems_.size() << " lanelets to the base map before applying consolidated update");
+    resetToBaseRegems();
+  }
+
+  // Record the base regulatory elements of lanelets this update edits for the first time
+  for (auto id : edited_lanelet_ids)
+  {
+    auto llt = world_model_->getMutableMap()->laneletLayer.find(id);
+    if (llt != world_model_->getMutableMap()->laneletLayer.end())
+      base_lanelet_regems_.emplace(id, llt->regulatoryElements());
+  }
+
   ROS_DEBUG_STREAM("Geofence id" << gf_ptr->id_ << " requests removal of size: " << gf_ptr->remove_list_.size());
   for (auto pair : gf_ptr->remove_list_)
   {
@@ -185,13 +219,126 @@ void WMListenerWorker::mapUpdateCallback(const autoware_lanelet2_msgs::MapBinPtr
     }
   }
   
-  // set the map to set a new routing
-  world_model_->setMap(world_model_->getMutableMap(), current_map_version_);
+  // set the map to set a new routing. The routing graph only needs to be rebuilt if the update changed passability or lane change permissions
+  bool routing_changed = routingRelations(edited_lanelet_ids) != relations_before_update;
+  ROS_DEBUG_STREAM("Geofence id" << gf_ptr->id_ << (routing_changed ? " changes" : " does not change") << " the routing graph");
+  world_model_->setMap(world_model_->getMutableMap(), current_map_version_, routing_changed);
+  if (!routing_changed)
+  {
+    // The map was edited through getMutableMap() so the lanelet index is unused until the edited lanelets are reindexed
+    std::vector<lanelet::Id> edited_ids(edited_lanelet_ids.begin(), edited_lanelet_ids.end());
+    world_model_->updateSpeedLimits(edited_ids);
+    world_model_->updateLaneletIndex(edited_ids);
+  }
 
   
   ROS_INFO_STREAM("Finished Applying the Map Update with Geofence Id:" << gf_ptr->id_); 
 }
 
+/*!
+  * \brief Restores the regulatory elements every lanelet had before its first update on the current map version
+  */
+void WMListenerWorker::resetToBaseRegems()
+{
+  auto map = world_model_->getMutableMap();
+  auto contains_regem = [](const lanelet::RegulatoryElementPtrs& regems, lanelet::Id id) {
+    return std::any_of(regems.begin(), regems.end(), [id](const auto& regem) { return regem->id() == id; });
+  };
+
+  for (const auto& base : base_lanelet_regems_)
+  {
+    auto llt = map->laneletLayer.get(base.first);
+    auto current_regems = llt.regulatoryElements(); // copy as regems are removed during iteration
+    for (const auto& regem : current_regems)
+    {
+      if (!contains_regem(base.second, regem->id()))
+        map->remove(llt, regem);
+    }
+    for (const auto& regem : base.second)
+    {
+      if (!contains_regem(current_regems, regem->id()))
+        map->update(llt, regem);
+    }
+  }
+}
+
+/*!
+  * \brief Evaluates the traffic rule queries the routing graph is built from for the provided lanelets.
+  *        This covers the passability of each lanelet in both directions and the passability and lane change permissions
+  *        to every lanelet sharing a bound or a bound end point with it, as well as its speed limit in both directions which the
+  *        travel time routing cost is computed from. Speed limits which cannot be evaluated are recorded as -1. As map updates only edit regulations, two evaluations
+  *        on the same map are directly comparable and equal results mean the routing graph is unaffected by the edit.
+  * \param lanelet_ids The ids of the lanelets to evaluate. Ids which are not in the map are ignored
+  * \return The query results in a deterministic order
+  */
+std::vector<double> WMListenerWorker::routingRelations(const std::set<lanelet::Id>& lanelet_ids) const
+{
+  std::vector<double> relations;
+  auto map = world_model_->getMutableMap();
+  auto traffic_rules = world_model_->getTrafficRules();
+  if (!map || !traffic_rules)
+  {
+    return relations;
+  }
+
+  for (auto id : lanelet_ids)
+  {
+    if (!map->laneletLayer.exists(id))
+    {
+      continue;
+    }
+    lanelet::ConstLanelet llt = map->laneletLayer.get(id);
+    relations.push_back((*traffic_rules)->canPass(llt));
+    relations.push_back((*traffic_rules)->canPass(llt.invert()));
+
+    // The travel time routing cost depends on the speed limit
+    for (const auto& direction : { llt, llt.invert() })
+    {
+      try
+      {
+        relations.push_back((*traffic_rules)->speedLimit(direction).speedLimit.value());
+      }
+      catch (const std::exception& e)
+      {
+        // Speed limits are never negative so the sentinel only matches another failed evaluation
+        ROS_DEBUG_STREAM("Could not evaluate speed limit of lanelet " << id << ": " << e.what());
+        relations.push_back(-1.0);
+      }
+    }
+
+    // Neighbors share a bound, successors and predecessors share a bound end point
+    std::set<lanelet::Id> related_ids;
+    for (const auto& bound : { llt.leftBound(), llt.rightBound() })
+    {
+      for (const auto& other : map->laneletLayer.findUsages(bound))
+      {
+        related_ids.insert(other.id());
+      }
+      for (const auto& point : { bound.front(), bound.back() })
+      {
+        for (const auto& ls : map->lineStringLayer.findUsages(point))
+        {
+          for (const auto& other : map->laneletLayer.findUsages(ls))
+          {
+            related_ids.insert(other.id());
+          }
+        }
+      }
+    }
+    related_ids.erase(id);
+
+    for (auto related_id : related_ids)
+    {
+      lanelet::ConstLanelet other = map->laneletLayer.get(related_id);
+      relations.push_back((*traffic_rules)->canPass(llt, other));
+      relations.push_back((*traffic_rules)->canPass(other, llt));
+      relations.push_back((*traffic_rules)->canChangeLane(llt, other));
+      relations.push_back((*traffic_rules)->canChangeLane(other, llt));
+    }
+  }
+  return relations;
+}
+
 /*!
   * \brief This is a helper function updates the parent_llt with specified regem. This function is needed
   *        as we need to dynamic_cast from general regem to specific type of regem based on the geofence
@@ -21,6 +21,8 @@
 #include <carma_wm/CARMAWorldModel.h>
 #include <carma_wm/TrafficControl.h>
 #include <queue>
+#include <set>
+#include <unordered_map>
 
 
 namespace carma_wm
@@ -52,6 +54,11 @@ public:
   /*!
    * \brief Callback for new map update messages (geofence). Updates the underlying map
    *
+   * An update with a nil geofence id is a consolidated update (see carma_wm::TrafficControl::isConsolidated()), which the
+   * broadcaster sends to new subscribers. Its edits
+   * are relative to the base map, so every lanelet edited by earlier updates on the current map version is first reset
+   * to its base regulatory elements. This keeps the result correct for subscribers which already applied some updates.
+   *
    * \param geofence_msg The new map update messages to generate the map edits from
    */
   void mapUpdateCallback(const autoware_lanelet2_msgs::MapBinPtr& geofence_msg);
@@ -109,6 +116,8 @@ private:
   std::function<void()> map_callback_;
   std::function<void()> route_callback_;
   void newRegemUpdateHelper(lanelet::Lanelet parent_llt, lanelet::RegulatoryElement* regem) const;
+  std::vector<double> routingRelations(const std::set<lanelet::Id>& lanelet_ids) const;
+  void resetToBaseRegems();
   double config_speed_limit_;
 
   size_t current_map_version_ = 0; // Current map version based on recived map messages
@@ -118,5 +127,6 @@ private:
   bool rerouting_flag_=false;
   bool route_node_flag_=false;
   long most_recent_update_msg_seq_ = -1; // Tracks the current sequence number for map update messages. Dropping even a single message would invalidate the map
+  std::unordered_map<lanelet::Id, lanelet::RegulatoryElementPtrs> base_lanelet_regems_; // Regulatory elements of each lanelet before its first update on the current map version
 };
 }  // namespace carma_wm
@@ -414,6 +414,20 @@ TEST(CARMAWorldModelTest, getInLaneObjects)
   // check right lane behind of middle section
   ASSERT_EQ(cmw.getInLaneObjects(llts[4], LANE_BEHIND).size(), 3);
 
+  // objects set before the map are indexed once the map is set, including the lane changing object
+  carma_wm::CARMAWorldModel cmw_objects_first;
+  cmw_objects_first.setRoadwayObjects(roadway_objects);
+  cmw_objects_first.setMap(map);
+  for (int i = 0; i < 6; i++)
+  {
+    auto expected = cmw.getInLaneObjects(llts[i], LANE_FULL);
+    auto result = cmw_objects_first.getInLaneObjects(llts[i], LANE_FULL);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t j = 0; j < result.size(); j++)
+    {
+      ASSERT_EQ(result[j].object.id, expected[j].object.id);
+    }
+  }
 }
 
 TEST(CARMAWorldModelTest, distToNearestObjInLane)
@@ -730,6 +744,49 @@ TEST(CARMAWorldModelTest, routeTrackPos_point)
   result = cmw.routeTrackPos(p);
   ASSERT_NEAR(-1.0, result.downtrack, 0.000001);
   ASSERT_NEAR(1.0, result.crosstrack, 0.000001);
+
+}
+
+TEST(CARMAWorldModelTest, routeTrackPos_points)
+{
+  CARMAWorldModel cmw;
+
+  ///// Test route exception
+  std::vector<lanelet::BasicPoint2d> points = { getBasicPoint(0.5, 0) };
+  ASSERT_THROW(cmw.routeTrackPos(points), std::invalid_argument);
+
+  ///// Test disjoint route
+  addDisjointRoute(cmw);
+
+  ///// Test empty input
+  points.clear();
+  ASSERT_TRUE(cmw.routeTrackPos(points).empty());
+
+  ///// Points ordered along the route including across the lane change and past the route ends
+  for (int i = 0; i < 30; i++)
+  {
+    points.push_back(getBasicPoint(0.5, -0.45 + 0.1 * i));
+  }
+  for (int i = 0; i < 30; i++)
+  {
+    points.push_back(getBasicPoint(1.5, -0.45 + 0.1 * i));
+  }
+  ///// Unordered points far from each other
+  points.push_back(getBasicPoint(2.0, 2.5));
+  points.push_back(getBasicPoint(0.0, -0.5));
+  points.push_back(getBasicPoint(1.5, 0.5));
+  points.push_back(getBasicPoint(10.0, 10.0));
+  points.push_back(getBasicPoint(0.5, 1.5));
+
+  auto results = cmw.routeTrackPos(points);
+  ASSERT_EQ(points.size(), results.size());
+
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    TrackPos expected = cmw.routeTrackPos(points[i]);
+    ASSERT_DOUBLE_EQ(expected.downtrack, results[i].downtrack);
+    ASSERT_DOUBLE_EQ(expected.crosstrack, results[i].crosstrack);
+  }
 }
 
 TEST(CARMAWorldModelTest, routeTrackPos_lanelet)
@@ -767,6 +824,45 @@ TEST(CARMAWorldModelTest, routeTrackPos_lanelet)
   ASSERT_NEAR(0.0, result.crosstrack, 0.000001);
 }
 
+TEST(CARMAWorldModelTest, getRouteLaneletTrackPos)
+{
+  std::shared_ptr<carma_wm::CARMAWorldModel> wm = std::make_shared<carma_wm::CARMAWorldModel>();
+
+  ASSERT_THROW(wm->getRouteLaneletTrackPos(1200), std::invalid_argument);
+
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 10);
+  wm->setMap(map);
+  carma_wm::test::setRouteByIds({ 1200, 1201, 1202, 1203 }, wm);
+
+  // Route lanelet
+  auto track_pos = wm->getRouteLaneletTrackPos(1201);
+  ASSERT_TRUE((bool)track_pos);
+  ASSERT_NEAR(10.0, track_pos->first.downtrack, 0.000001);
+  ASSERT_NEAR(0.0, track_pos->first.crosstrack, 0.000001);
+  ASSERT_NEAR(20.0, track_pos->second.downtrack, 0.000001);
+  ASSERT_NEAR(0.0, track_pos->second.crosstrack, 0.000001);
+
+  // Lanelet beside the route matches a direct computation
+  lanelet::ConstLanelet beside = map->laneletLayer.get(1211);
+  track_pos = wm->getRouteLaneletTrackPos(1211);
+  ASSERT_TRUE((bool)track_pos);
+  TrackPos expected_start = wm->routeTrackPos(beside.centerline2d().front());
+  TrackPos expected_end = wm->routeTrackPos(beside.centerline2d().back());
+  ASSERT_NEAR(expected_start.downtrack, track_pos->first.downtrack, 0.000001);
+  ASSERT_NEAR(expected_start.crosstrack, track_pos->first.crosstrack, 0.000001);
+  ASSERT_NEAR(expected_end.downtrack, track_pos->second.downtrack, 0.000001);
+  ASSERT_NEAR(expected_end.crosstrack, track_pos->second.crosstrack, 0.000001);
+  ASSERT_NEAR(3.7, std::fabs(track_pos->first.crosstrack), 0.000001);
+
+  // The lanelet overload uses the same positions
+  TrackPos result = wm->routeTrackPos(beside);
+  ASSERT_NEAR(expected_start.downtrack, result.downtrack, 0.000001);
+  ASSERT_NEAR(expected_start.crosstrack, result.crosstrack, 0.000001);
+
+  // Lanelets two lanes away are not part of the table
+  ASSERT_FALSE((bool)wm->getRouteLaneletTrackPos(1221));
+}
+
 TEST(CARMAWorldModelTest, routeTrackPos_area)
 {
   CARMAWorldModel cmw;
@@ -850,6 +946,30 @@ TEST(CARMAWorldModelTest, getLaneletsBetween)
   result = cmw.getLaneletsBetween(2.0, 2.5);
   ASSERT_EQ(1, result.size());
   ASSERT_NEAR(result[0].id(), (cmw.getRoute()->shortestPath().begin() + 1)->id(), 0.000001);
+
+  ///// Test non-inclusive bounds exclude lanelets which only touch the range
+  result = cmw.getLaneletsBetween(2.0, 2.5, false, false);
+  ASSERT_EQ(0, result.size());
+
+  ///// Test disjoint route
+  addDisjointRoute(cmw);
+
+  ///// Test shortest path lanelets are returned in shortest path order
+  auto shortest_path = cmw.getRoute()->shortestPath();
+  result = cmw.getLaneletsBetween(-1.0, 3.0, true);
+  ASSERT_EQ(shortest_path.size(), result.size());
+  for (size_t i = 0; i < result.size(); i++)
+  {
+    ASSERT_EQ(shortest_path[i].id(), result[i].id());
+  }
+
+  ///// Test all route lanelets are returned in order of increasing starting downtrack
+  result = cmw.getLaneletsBetween(-1.0, 3.0);
+  ASSERT_EQ(cmw.getRoute()->laneletMap()->laneletLayer.size(), result.size());
+  for (size_t i = 1; i < result.size(); i++)
+  {
+    ASSERT_LE(cmw.routeTrackPos(result[i - 1]).downtrack, cmw.routeTrackPos(result[i]).downtrack);
+  }
 }
 
 TEST(CARMAWorldModelTest, getTrafficRules)
@@ -883,6 +1003,36 @@ TEST(CARMAWorldModelTest, getTrafficRules)
   ASSERT_FALSE(!!default_participant);
 }
 
+TEST(CARMAWorldModelTest, getSpeedLimit)
+{
+  CARMAWorldModel cmw;
+
+  ///// Test route exception
+  ASSERT_THROW(cmw.getRouteSpeedLimit(0), std::invalid_argument);
+
+  addStraightRoute(cmw);
+
+  ///// Test traffic rules are only built once per map
+  ASSERT_EQ(cmw.getTrafficRules().get(), cmw.getTrafficRules().get());
+
+  ///// Test cached lanelet speed limits match the traffic rules
+  auto traffic_rules = cmw.getTrafficRules().get();
+  auto shortest_path = cmw.getRoute()->shortestPath();
+  for (const auto& llt : shortest_path)
+  {
+    ASSERT_DOUBLE_EQ(traffic_rules->speedLimit(llt).speedLimit.value(), cmw.getSpeedLimit(llt));
+  }
+
+  ///// Test route speed limit steps at lanelet starts and is clamped outside the route
+  double first_limit = cmw.getSpeedLimit(shortest_path[0]);
+  double second_limit = cmw.getSpeedLimit(shortest_path[1]);
+  ASSERT_DOUBLE_EQ(first_limit, cmw.getRouteSpeedLimit(-1.0));
+  ASSERT_DOUBLE_EQ(first_limit, cmw.getRouteSpeedLimit(0.5));
+  ASSERT_DOUBLE_EQ(second_limit, cmw.getRouteSpeedLimit(1.0));
+  ASSERT_DOUBLE_EQ(second_limit, cmw.getRouteSpeedLimit(1.5));
+  ASSERT_DOUBLE_EQ(second_limit, cmw.getRouteSpeedLimit(10.0));
+}
+
 TEST(CARMAWorldModelTest, toRoadwayObstacle)
 {
   CARMAWorldModel cmw;
@@ -979,6 +1129,101 @@ TEST(CARMAWorldModelTest, toRoadwayObstacle)
   ASSERT_FALSE(!!result);
 }
 
+TEST(CARMAWorldModelTest, toRoadwayObstacles)
+{
+  CARMAWorldModel cmw;
+  ASSERT_THROW(cmw.toRoadwayObstacles({}), std::invalid_argument);
+
+  // 3 lanes of 3 lanelets. Lanelets are 3.7 m wide and 25 m long
+  cmw.setMap(carma_wm::test::buildGuidanceTestMap(3.7, 25));
+
+  std::vector<cav_msgs::ExternalObject> objects;
+  for (int i = 0; i < 7; i++)
+  {
+    cav_msgs::ExternalObject obj;
+    obj.id = i;
+    obj.pose.pose.position.x = 1.85 + 3.7 * (i % 3);
+    obj.pose.pose.position.y = 5.0 + i;
+    obj.pose.pose.orientation.w = 1.0;
+    obj.size.x = 4;
+    obj.size.y = 2;
+    obj.size.z = 1;
+
+    // Predictions drive forward through every lanelet of the lane and then off the end of the map
+    for (int j = 1; j <= 70; j++)
+    {
+      cav_msgs::PredictedState pred;
+      pred.predicted_position = obj.pose.pose;
+      pred.predicted_position.position.y += j;
+      pred.predicted_position_confidence = 1.0;
+      obj.predictions.push_back(pred);
+    }
+    objects.push_back(obj);
+  }
+  objects.back().pose.pose.position.x = -50;  // Off the road
+
+  auto expect_equal = [](const lanelet::Optional<cav_msgs::RoadwayObstacle>& expected,
+                         const lanelet::Optional<cav_msgs::RoadwayObstacle>& actual) {
+    ASSERT_EQ(!!expected, !!actual);
+    if (!expected)
+      return;
+    ASSERT_EQ(expected.get().object.id, actual.get().object.id);
+    ASSERT_EQ(expected.get().lanelet_id, actual.get().lanelet_id);
+    ASSERT_EQ(expected.get().down_track, actual.get().down_track);
+    ASSERT_EQ(expected.get().cross_track, actual.get().cross_track);
+    ASSERT_EQ(expected.get().predicted_lanelet_ids, actual.get().predicted_lanelet_ids);
+    ASSERT_EQ(expected.get().predicted_down_tracks, actual.get().predicted_down_tracks);
+    ASSERT_EQ(expected.get().predicted_cross_tracks, actual.get().predicted_cross_tracks);
+    ASSERT_EQ(expected.get().predicted_lanelet_id_confidences, actual.get().predicted_lanelet_id_confidences);
+  };
+
+  for (unsigned int thread_count : { 1u, 3u, 16u })
+  {
+    auto results = cmw.toRoadwayObstacles(objects, thread_count);
+    ASSERT_EQ(objects.size(), results.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+      expect_equal(cmw.toRoadwayObstacle(objects[i]), results[i]);
+    }
+  }
+
+  auto results = cmw.toRoadwayObstacles(objects);
+  ASSERT_FALSE(!!results.back());
+
+  // The first object is in the first lane and its predictions follow the lane
+  ASSERT_TRUE(!!results[0]);
+  const auto& obs = results[0].get();
+  ASSERT_EQ(1200, obs.lanelet_id);
+  ASSERT_EQ(70u, obs.predicted_lanelet_ids.size());
+  ASSERT_EQ(1200, obs.predicted_lanelet_ids[0]);   // y = 6
+  ASSERT_EQ(1201, obs.predicted_lanelet_ids[24]);  // y = 30
+  ASSERT_EQ(1202, obs.predicted_lanelet_ids[49]);  // y = 55
+  ASSERT_NEAR(5.0, obs.predicted_down_tracks[24], 0.00001);
+  ASSERT_NEAR(0.0, obs.predicted_cross_tracks[24], 0.00001);
+  ASSERT_EQ(1202, obs.predicted_lanelet_ids[69]);  // y = 75, past the end of the map
+
+  ASSERT_TRUE(cmw.toRoadwayObstacles({}, 4).empty());
+
+  // Hints from the previous frame give the same results whether the object stayed on its lanelet, moved to a
+  // successor or neighbor, moved elsewhere or the hint no longer exists
+  std::vector<lanelet::Id> hints = { 1200, 1201, 1201, 1222, lanelet::InvalId, 1234567, 1200 };
+  objects[1].pose.pose.position.y = 30.0;  // Moved from 1210 to 1211
+  for (unsigned int thread_count : { 1u, 3u })
+  {
+    auto hinted = cmw.toRoadwayObstacles(objects, hints, thread_count);
+    ASSERT_EQ(objects.size(), hinted.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+      expect_equal(cmw.toRoadwayObstacle(objects[i]), hinted[i]);
+    }
+  }
+
+  // The object in 1211 is on the right neighbor of the hinted lanelet 1201
+  ASSERT_EQ(1211, cmw.toRoadwayObstacles(objects, hints)[1].get().lanelet_id);
+
+  ASSERT_THROW(cmw.toRoadwayObstacles(objects, { 1200 }), std::invalid_argument);
+}
+
 TEST(CARMAWorldModelTest, getLaneletsFromPoint)
 {
   carma_wm::CARMAWorldModel cmw;
@@ -1003,6 +1248,36 @@ TEST(CARMAWorldModelTest, getLaneletsFromPoint)
   ASSERT_EQ(underlyings.size(), 2);
   ASSERT_EQ(underlyings.front().id(), 1500);
   ASSERT_EQ(underlyings.back().id(), 1200);
+
+  // Once indexed every containing lanelet is found with the nearest centerline first
+  auto ll_1501 = test::getLanelet(1501, {getPoint(0.2,0.0, 0),getPoint(0.2,1.0, 0)},
+                         {getPoint(1.2,0.0, 0),getPoint(1.2,1.0, 0)}); // centerline at x = 0.7
+  cmw_ptr->getMutableMap()->add(ll_1501);
+  cmw_ptr->updateLaneletIndex({ 1500, 1501 });
+  underlyings = cmw_ptr->getLaneletsFromPoint({0.65,0.5});
+  ASSERT_EQ(underlyings.size(), 3);
+  ASSERT_EQ(underlyings[0].id(), 1501);
+  ASSERT_EQ(underlyings[1].id(), 1200); // Equal centerline distances are ordered by id
+  ASSERT_EQ(underlyings[2].id(), 1500);
+  underlyings = cmw_ptr->getLaneletsFromPoint({0.65,0.5}, 1);
+  ASSERT_EQ(underlyings.size(), 1);
+  ASSERT_EQ(underlyings.front().id(), 1501); // The nearest lanelet is kept rather than the first found
+  ASSERT_EQ(cmw_ptr->getLaneletsFromPoint({0.5,0.05}).size(), 2);
+  ASSERT_TRUE(cmw_ptr->getLaneletsFromPoint({-5.0,0.5}).empty());
+
+  // Reshaping a lanelet in place does not change the lanelet count but is still reflected
+  auto map_1501 = cmw_ptr->getMutableMap()->laneletLayer.get(1501);
+  for (auto point : map_1501.rightBound())
+  {
+    point.x() = 5.0;
+  }
+  underlyings = cmw_ptr->getLaneletsFromPoint({4.0,0.5});
+  ASSERT_EQ(underlyings.size(), 1);
+  ASSERT_EQ(underlyings.front().id(), 1501);
+  cmw_ptr->updateLaneletIndex({ 1501 });
+  underlyings = cmw_ptr->getLaneletsFromPoint({4.0,0.5});
+  ASSERT_EQ(underlyings.size(), 1);
+  ASSERT_EQ(underlyings.front().id(), 1501);
 }
 
 TEST(CARMAWorldModelTest, setConfigSpeedLimitTest)
@@ -1224,7 +1499,66 @@ TEST(CARMAWorldModelTest, sampleRoutePoints)
     }
     i++; 
   }
+
+  // Check the buffer overload reuses the provided vector and matches point by point conversion
+  std::vector<lanelet::BasicPoint2d> buffer = { lanelet::BasicPoint2d(-1, -1) };
+  wm->sampleRoutePoints(5.0, 35.0, 0.25, buffer);
+  ASSERT_EQ(121, buffer.size());
+  for (size_t j = 0; j < buffer.size(); j++)
+  {
+    double downtrack = std::min(5.0 + j * 0.25, 35.0);
+    auto expected = wm->pointFromRouteTrackPos(TrackPos(downtrack, 0));
+    ASSERT_TRUE((bool)expected);
+    ASSERT_NEAR(expected->x(), buffer[j].x(), 0.000001);
+    ASSERT_NEAR(expected->y(), buffer[j].y(), 0.000001);
+  }
+
+  // Invalid bounds clear the buffer
+  wm->sampleRoutePoints(10.0, 5.0, 1.0, buffer);
+  ASSERT_TRUE(buffer.empty());
 }
 
 
+TEST(CARMAWorldModelTest, sampleRouteProfile)
+{
+  std::shared_ptr<carma_wm::CARMAWorldModel> wm = std::make_shared<carma_wm::CARMAWorldModel>();
+
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 10);
+
+  wm->setMap(map);
+  carma_wm::test::setSpeedLimit(20_mph, wm);
+
+  std::vector<RouteProfileSample> samples;
+  wm->sampleRouteProfile(0, 10, 1, samples);
+  ASSERT_TRUE(samples.empty()); // No route
+
+  carma_wm::test::setRouteByIds({ 1200, 1201, 1202, 1203 }, wm);
+
+  wm->sampleRouteProfile(5.0, 35.0, 0.25, samples);
+  ASSERT_EQ(121, samples.size());
+  for (size_t j = 0; j < samples.size(); j++)
+  {
+    double downtrack = std::min(5.0 + j * 0.25, 35.0);
+    auto expected = wm->pointFromRouteTrackPos(TrackPos(downtrack, 0));
+    ASSERT_TRUE((bool)expected);
+    ASSERT_NEAR(downtrack, samples[j].downtrack, 0.000001);
+    ASSERT_NEAR(expected->x(), samples[j].point.x(), 0.000001);
+    ASSERT_NEAR(expected->y(), samples[j].point.y(), 0.000001);
+    ASSERT_NEAR(M_PI_2, samples[j].heading, 0.000001);
+    ASSERT_NEAR(0.0, samples[j].curvature, 0.000001);
+    ASSERT_NEAR(1.85, samples[j].left_bound, 0.000001);
+    ASSERT_NEAR(1.85, samples[j].right_bound, 0.000001);
+    ASSERT_NEAR(wm->getRouteSpeedLimit(downtrack), samples[j].speed_limit, 0.000001);
+  }
+
+  // Single point
+  wm->sampleRouteProfile(12.0, 12.0, 1.0, samples);
+  ASSERT_EQ(1, samples.size());
+  ASSERT_NEAR(12.0, samples[0].point.y(), 0.000001);
+
+  // Invalid bounds clear the buffer
+  wm->sampleRouteProfile(10.0, 5.0, 1.0, samples);
+  ASSERT_TRUE(samples.empty());
+}
+
 }  // namespace carma_wm
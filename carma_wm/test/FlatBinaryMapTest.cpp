@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <gmock/gmock.h>
+#include <carma_wm/FlatBinaryMap.h>
+#include <carma_wm/WMTestLibForGuidance.h>
+#include <lanelet2_extension/utility/message_conversion.h>
+#include <lanelet2_extension/regulatory_elements/DigitalSpeedLimit.h>
+#include <autoware_lanelet2_msgs/MapBin.h>
+#include <cstdio>
+#include "TestHelpers.h"
+
+namespace carma_wm
+{
+namespace
+{
+lanelet::LaneletMapPtr buildFlatBinaryTestMap()
+{
+  using namespace lanelet::units::literals;
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+
+  lanelet::Lanelet llt = map->laneletLayer.get(1200);
+  lanelet::DigitalSpeedLimitPtr speed_limit = std::make_shared<lanelet::DigitalSpeedLimit>(
+      lanelet::DigitalSpeedLimit::buildData(9000, 15_mph, { llt }, {}, { lanelet::Participants::VehicleCar }));
+  llt.addRegulatoryElement(speed_limit);
+  map->add(speed_limit);
+
+  // Inverted bound and custom centerline
+  lanelet::Lanelet inverted_llt = map->laneletLayer.get(1201);
+  lanelet::Lanelet reversed(1300, inverted_llt.rightBound().invert(), inverted_llt.leftBound().invert());
+  lanelet::LineString3d centerline(lanelet::utils::getId(), { test::getPoint(1.85, 50, 0), test::getPoint(1.85, 25, 0) });
+  reversed.setCenterline(centerline);
+  map->add(reversed);
+
+  return map;
+}
+
+void expectMapsEqual(const lanelet::LaneletMap& expected, const lanelet::LaneletMap& actual)
+{
+  ASSERT_EQ(expected.pointLayer.size(), actual.pointLayer.size());
+  ASSERT_EQ(expected.lineStringLayer.size(), actual.lineStringLayer.size());
+  ASSERT_EQ(expected.polygonLayer.size(), actual.polygonLayer.size());
+  ASSERT_EQ(expected.laneletLayer.size(), actual.laneletLayer.size());
+  ASSERT_EQ(expected.areaLayer.size(), actual.areaLayer.size());
+  ASSERT_EQ(expected.regulatoryElementLayer.size(), actual.regulatoryElementLayer.size());
+
+  for (const auto& point : expected.pointLayer)
+  {
+    ASSERT_TRUE(actual.pointLayer.exists(point.id()));
+    auto other = actual.pointLayer.get(point.id());
+    ASSERT_NEAR(point.x(), other.x(), 0.000001);
+    ASSERT_NEAR(point.y(), other.y(), 0.000001);
+    ASSERT_NEAR(point.z(), other.z(), 0.000001);
+  }
+
+  for (const auto& llt : expected.laneletLayer)
+  {
+    ASSERT_TRUE(actual.laneletLayer.exists(llt.id()));
+    lanelet::ConstLanelet other = actual.laneletLayer.get(llt.id());
+
+    ASSERT_EQ(llt.leftBound().id(), other.leftBound().id());
+    ASSERT_EQ(llt.leftBound().inverted(), other.leftBound().inverted());
+    ASSERT_EQ(llt.rightBound().id(), other.rightBound().id());
+    ASSERT_EQ(llt.rightBound().inverted(), other.rightBound().inverted());
+    ASSERT_EQ(llt.leftBound().front().id(), other.leftBound().front().id());
+    ASSERT_EQ(llt.attributes().size(), other.attributes().size());
+    for (const auto& attribute : llt.attributes())
+    {
+      ASSERT_EQ(attribute.second.value(), other.attribute(attribute.first).value());
+    }
+
+    ASSERT_EQ(llt.hasCustomCenterline(), other.hasCustomCenterline());
+    ASSERT_EQ(llt.centerline().size(), other.centerline().size());
+    for (size_t i = 0; i < llt.centerline().size(); i++)
+    {
+      ASSERT_NEAR(llt.centerline()[i].x(), other.centerline()[i].x(), 0.000001);
+      ASSERT_NEAR(llt.centerline()[i].y(), other.centerline()[i].y(), 0.000001);
+    }
+
+    auto regems = llt.regulatoryElements();
+    auto other_regems = other.regulatoryElements();
+    ASSERT_EQ(regems.size(), other_regems.size());
+    for (size_t i = 0; i < regems.size(); i++)
+    {
+      ASSERT_EQ(regems[i]->id(), other_regems[i]->id());
+    }
+  }
+
+  for (const auto& regem : expected.regulatoryElementLayer)
+  {
+    ASSERT_TRUE(actual.regulatoryElementLayer.exists(regem->id()));
+    auto other = actual.regulatoryElementLayer.get(regem->id());
+    ASSERT_EQ(regem->attribute(lanelet::AttributeName::Subtype).value(),
+              other->attribute(lanelet::AttributeName::Subtype).value());
+    ASSERT_EQ(regem->getParameters().size(), other->getParameters().size());
+  }
+}
+}  // namespace
+
+TEST(FlatBinaryMap, roundTrip)
+{
+  auto map = buildFlatBinaryTestMap();
+
+  std::vector<uint8_t> buffer;
+  toFlatBinary(*map, buffer);
+  auto loaded = fromFlatBinary(buffer.data(), buffer.size());
+
+  expectMapsEqual(*map, *loaded);
+
+  // Regulatory elements are restored as their concrete type
+  auto speed_limit =
+      std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>(loaded->regulatoryElementLayer.get(9000));
+  ASSERT_TRUE(!!speed_limit);
+  ASSERT_NEAR(speed_limit->speed_limit_.value(), 6.7056, 0.0001);
+  ASSERT_EQ(1, speed_limit->getParameters().at(lanelet::RoleName::Refers).size());
+  ASSERT_EQ(speed_limit, loaded->laneletLayer.get(1200).regulatoryElements().front());
+
+  // Shared primitives stay shared
+  ASSERT_EQ(loaded->laneletLayer.get(1200).rightBound().id(), loaded->laneletLayer.get(1210).leftBound().id());
+  ASSERT_EQ(loaded->laneletLayer.get(1200).rightBound().front().constData(),
+            loaded->laneletLayer.get(1210).leftBound().front().constData());
+
+  // Flat and boost serialized maps are interchangeable
+  autoware_lanelet2_msgs::MapBin msg;
+  lanelet::utils::conversion::toBinMsg(map, &msg);
+  auto boost_map = std::make_shared<lanelet::LaneletMap>();
+  lanelet::utils::conversion::fromBinMsg(msg, boost_map);
+  expectMapsEqual(*boost_map, *loaded);
+
+  std::vector<uint8_t> second_buffer;
+  toFlatBinary(*boost_map, second_buffer);
+  expectMapsEqual(*boost_map, *fromFlatBinary(second_buffer.data(), second_buffer.size()));
+}
+
+TEST(FlatBinaryMap, invalidData)
+{
+  auto map = buildFlatBinaryTestMap();
+
+  std::vector<uint8_t> buffer;
+  toFlatBinary(*map, buffer);
+
+  // Bad magic
+  std::vector<uint8_t> bad_magic = buffer;
+  bad_magic[0] = 'X';
+  ASSERT_THROW(fromFlatBinary(bad_magic.data(), bad_magic.size()), std::invalid_argument);
+
+  // Bad version
+  std::vector<uint8_t> bad_version = buffer;
+  bad_version[4] = static_cast<uint8_t>(FLAT_BINARY_MAP_VERSION + 1);
+  ASSERT_THROW(fromFlatBinary(bad_version.data(), bad_version.size()), std::invalid_argument);
+
+  // Truncated
+  ASSERT_THROW(fromFlatBinary(buffer.data(), buffer.size() / 2), std::invalid_argument);
+  ASSERT_THROW(fromFlatBinary(buffer.data(), 0), std::invalid_argument);
+
+  // Trailing data
+  std::vector<uint8_t> trailing = buffer;
+  trailing.push_back(0);
+  ASSERT_THROW(fromFlatBinary(trailing.data(), trailing.size()), std::invalid_argument);
+}
+
+TEST(FlatBinaryMap, binMsg)
+{
+  auto map = buildFlatBinaryTestMap();
+
+  autoware_lanelet2_msgs::MapBin flat_msg;
+  toFlatBinMsg(*map, &flat_msg);
+  ASSERT_TRUE(isFlatBinMsg(flat_msg));
+  expectMapsEqual(*map, *mapFromBinMsg(flat_msg));
+
+  // Boost serialized messages are still read
+  autoware_lanelet2_msgs::MapBin boost_msg;
+  lanelet::utils::conversion::toBinMsg(map, &boost_msg);
+  ASSERT_FALSE(isFlatBinMsg(boost_msg));
+  expectMapsEqual(*map, *mapFromBinMsg(boost_msg));
+
+  autoware_lanelet2_msgs::MapBin empty_msg;
+  ASSERT_FALSE(isFlatBinMsg(empty_msg));
+
+  flat_msg.data.resize(flat_msg.data.size() / 2);
+  ASSERT_THROW(mapFromBinMsg(flat_msg), std::invalid_argument);
+}
+
+TEST(FlatBinaryMap, saveAndLoad)
+{
+  auto map = buildFlatBinaryTestMap();
+
+  std::string path = "/tmp/carma_wm_flat_binary_map_test.bin";
+  saveFlatBinaryMap(*map, path);
+  auto loaded = loadFlatBinaryMap(path);
+  std::remove(path.c_str());
+
+  expectMapsEqual(*map, *loaded);
+
+  ASSERT_THROW(loadFlatBinaryMap(path), std::runtime_error);
+}
+
+}  // namespace carma_wm
@@ -562,6 +562,74 @@ TEST(GeometryTest, trackPos_line_string)
   ASSERT_EQ(pc, std::get<1>(result).second);
 }
 
+TEST(GeometryTest, trackPos_batch)
+{
+  // Hairpin shaped line string so that a point near one leg can be near a vertex of the other leg
+  lanelet::BasicLineString2d line_string;
+  for (int i = 0; i <= 200; i++)
+  {
+    line_string.emplace_back(0.5 * i, 0.002 * i * i);
+  }
+  for (int i = 0; i <= 50; i++)
+  {
+    double angle = -M_PI_2 + M_PI * i / 50.0;
+    line_string.emplace_back(100.0 + 3.0 * std::cos(angle), 83.0 + 3.0 * std::sin(angle));
+  }
+  for (int i = 200; i >= 0; i--)
+  {
+    line_string.emplace_back(0.5 * i, 6.0 + 0.002 * i * i);
+  }
+
+  // Ordered points along the line string, unordered points, and points off both ends
+  std::vector<lanelet::BasicPoint2d> points;
+  for (double x = -5; x < 110; x += 0.37)
+  {
+    points.emplace_back(x, 0.002 * x * x + 1.0);
+  }
+  for (double x = 110; x > -5; x -= 0.43)
+  {
+    points.emplace_back(x, 6.0 + 0.002 * x * x - 2.9);
+  }
+  points.emplace_back(50, 3.0);
+  points.emplace_back(-20, 40);
+  points.emplace_back(75, 200);
+  points.emplace_back(12.5, 3.3);
+
+  std::vector<TrackPos> batch;
+  geometry::trackPos(line_string, points, batch);
+  ASSERT_EQ(points.size(), batch.size());
+
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    TrackPos expected = std::get<0>(geometry::matchSegment(points[i], line_string));
+    ASSERT_NEAR(expected.downtrack, batch[i].downtrack, 1e-9) << "point index " << i;
+    ASSERT_NEAR(expected.crosstrack, batch[i].crosstrack, 1e-9) << "point index " << i;
+  }
+
+  // Converting back gives the original points when they lie within the downtrack bounds of their segment
+  std::vector<TrackPos> ordered(batch.begin(), batch.begin() + 100);
+  std::vector<lanelet::BasicPoint2d> round_trip;
+  geometry::pointsFromTrackPos(line_string, ordered, round_trip);
+  ASSERT_EQ(ordered.size(), round_trip.size());
+  for (size_t i = 0; i < ordered.size(); i++)
+  {
+    ASSERT_NEAR(points[i].x(), round_trip[i].x(), 1e-9) << "point index " << i;
+    ASSERT_NEAR(points[i].y(), round_trip[i].y(), 1e-9) << "point index " << i;
+  }
+
+  // Extrapolation before the start
+  geometry::pointsFromTrackPos(line_string, { TrackPos(-1.0, 1.0) }, round_trip);
+  ASSERT_EQ(1, round_trip.size());
+  auto first_dir = (line_string[1] - line_string[0]).normalized();
+  ASSERT_NEAR(line_string[0].x() - first_dir.x() + first_dir.y(), round_trip[0].x(), 1e-9);
+  ASSERT_NEAR(line_string[0].y() - first_dir.y() - first_dir.x(), round_trip[0].y(), 1e-9);
+
+  // Invalid line strings
+  lanelet::BasicLineString2d single_point = { lanelet::BasicPoint2d(0, 0) };
+  ASSERT_THROW(geometry::trackPos(single_point, points, batch), std::invalid_argument);
+  ASSERT_THROW(geometry::pointsFromTrackPos(single_point, batch, round_trip), std::invalid_argument);
+}
+
 TEST(Geometry, objectToMapPolygon)
 {
   geometry_msgs::Pose pose;
@@ -766,4 +834,94 @@ TEST(GeometryTest, circular_arc_curvature)
 }
 
 
+TEST(GeometryTest, centerline_geometry_kernels)
+{
+  // Spiral so that curvature varies along the line
+  std::vector<lanelet::BasicPoint2d> points;
+  std::vector<double> xs, ys;
+  for (int i = 0; i < 60; i++)
+  {
+    double angle = 0.05 * i;
+    double radius = 20.0 + 0.5 * i;
+    points.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+    xs.push_back(points.back().x());
+    ys.push_back(points.back().y());
+  }
+
+  // Reference values computed step by step as the original vector implementations did
+  std::vector<Eigen::Vector2d> tangents;
+  std::vector<double> expected_arc_lengths = { 0.0 };
+  std::vector<double> expected_orientations;
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    Eigen::Vector2d diff;
+    if (i == 0)
+      diff = points[i + 1] - points[i];
+    else if (i == points.size() - 1)
+      diff = points[i] - points[i - 1];
+    else
+      diff = (points[i + 1] - points[i - 1]) / 2.0;
+    tangents.push_back(diff.normalized());
+    expected_orientations.push_back(std::atan2(diff.y(), diff.x()));
+    if (i > 0)
+      expected_arc_lengths.push_back(expected_arc_lengths.back() + (points[i] - points[i - 1]).norm());
+  }
+  std::vector<double> expected_curvatures = geometry::compute_magnitude_of_vectors(
+      geometry::compute_finite_differences(tangents, expected_arc_lengths));
+
+  // Vector wrappers
+  std::vector<double> arc_lengths = geometry::compute_arc_lengths(points);
+  std::vector<double> orientations = geometry::compute_tangent_orientations(points);
+  std::vector<double> curvatures = geometry::local_curvatures(points);
+  ASSERT_EQ(points.size(), arc_lengths.size());
+  ASSERT_EQ(points.size(), orientations.size());
+  ASSERT_EQ(points.size(), curvatures.size());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    ASSERT_NEAR(expected_arc_lengths[i], arc_lengths[i], 1e-12);
+    ASSERT_NEAR(expected_orientations[i], orientations[i], 1e-12);
+    ASSERT_NEAR(expected_curvatures[i], curvatures[i], 1e-12);
+    ASSERT_NEAR(1.0 / (20.0 + 0.5 * i), curvatures[i], 0.01);
+  }
+
+  // Separate coordinate arrays and the fused kernel give the same results
+  auto view = geometry::makePointArrayView(xs.data(), ys.data(), xs.size());
+  std::vector<double> fused_arc_lengths(points.size()), fused_orientations(points.size()),
+      fused_curvatures(points.size());
+  geometry::compute_centerline_geometry(view, fused_arc_lengths.data(), fused_orientations.data(),
+                                        fused_curvatures.data());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    ASSERT_EQ(arc_lengths[i], fused_arc_lengths[i]);
+    ASSERT_EQ(orientations[i], fused_orientations[i]);
+    ASSERT_EQ(curvatures[i], fused_curvatures[i]);
+  }
+
+  // Null outputs are skipped
+  std::vector<double> only_curvatures(points.size());
+  geometry::compute_centerline_geometry(view, nullptr, nullptr, only_curvatures.data());
+  ASSERT_EQ(curvatures, only_curvatures);
+
+  // Finite differences into interleaved storage
+  std::vector<Eigen::Vector2d> diffs = geometry::compute_finite_differences(points);
+  std::vector<double> dx(points.size()), dy(points.size());
+  geometry::compute_finite_differences(view, dx.data(), dy.data());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    ASSERT_EQ(diffs[i].x(), dx[i]);
+    ASSERT_EQ(diffs[i].y(), dy[i]);
+  }
+
+  // Circular arc curvatures
+  std::vector<double> arc_curvatures = geometry::local_circular_arc_curvatures(points, 3);
+  std::vector<double> view_arc_curvatures(points.size());
+  geometry::local_circular_arc_curvatures(view, 3, view_arc_curvatures.data());
+  ASSERT_EQ(arc_curvatures, view_arc_curvatures);
+  ASSERT_THROW(geometry::local_circular_arc_curvatures(view, 0, view_arc_curvatures.data()), std::invalid_argument);
+
+  // Empty input
+  ASSERT_THROW(geometry::local_curvatures(geometry::makePointArrayView(nullptr, nullptr, 0), nullptr),
+               std::invalid_argument);
+}
+
 }  // namespace carma_wm
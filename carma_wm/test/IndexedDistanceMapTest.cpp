@@ -107,5 +107,27 @@ TEST(IndexedDistanceMapTest, IndexedDistanceMap)
 
   ASSERT_EQ(2, map.getIndexFromId(p8.id()).first);
   ASSERT_EQ(1, map.getIndexFromId(p8.id()).second);
+
+  // Check getElementIndexByDistance
+  ASSERT_THROW(map.getElementIndexByDistance(-0.1), std::invalid_argument);
+  ASSERT_THROW(map.getElementIndexByDistance(5.1), std::invalid_argument);
+  ASSERT_EQ(0, map.getElementIndexByDistance(0.0));
+  ASSERT_EQ(0, map.getElementIndexByDistance(0.5));
+  ASSERT_EQ(0, map.getElementIndexByDistance(2.9));
+  ASSERT_EQ(1, map.getElementIndexByDistance(3.0));
+  ASSERT_EQ(1, map.getElementIndexByDistance(3.5));
+  ASSERT_EQ(2, map.getElementIndexByDistance(4.5));
+  ASSERT_EQ(2, map.getElementIndexByDistance(5.0));
+
+  // Check getPointIndexByDistance
+  ASSERT_EQ(0, map.getPointIndexByDistance(0, -1.0));
+  ASSERT_EQ(0, map.getPointIndexByDistance(0, 0.0));
+  ASSERT_EQ(0, map.getPointIndexByDistance(0, 0.5));
+  ASSERT_EQ(1, map.getPointIndexByDistance(0, 1.0));
+  ASSERT_EQ(2, map.getPointIndexByDistance(0, 2.5));
+  ASSERT_EQ(3, map.getPointIndexByDistance(0, 3.0));
+  ASSERT_EQ(3, map.getPointIndexByDistance(0, 10.0));
+  ASSERT_EQ(0, map.getPointIndexByDistance(2, 0.5));
+  ASSERT_EQ(1, map.getPointIndexByDistance(2, 1.0));
 }
 }  // namespace carma_wm
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <gmock/gmock.h>
+#include <carma_wm/LaneletSpatialIndex.h>
+#include <carma_wm/WMTestLibForGuidance.h>
+#include "TestHelpers.h"
+
+namespace carma_wm
+{
+TEST(LaneletSpatialIndex, candidates)
+{
+  // 3 lanes of 3 lanelets. Lanelets are 3.7 m wide and 25 m long with the first lane starting at x = 0
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+
+  LaneletSpatialIndex index;
+  ASSERT_EQ(0u, index.size());
+  ASSERT_TRUE(index.candidates(lanelet::BasicPoint2d(1.0, 1.0)).empty());
+
+  index.build(map->laneletLayer);
+  ASSERT_EQ(map->laneletLayer.size(), index.size());
+
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200 }), index.candidates(lanelet::BasicPoint2d(1.0, 1.0)));
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1211 }), index.candidates(lanelet::BasicPoint2d(5.0, 30.0)));
+  ASSERT_TRUE(index.candidates(lanelet::BasicPoint2d(-1.0, 1.0)).empty());
+  ASSERT_TRUE(index.candidates(lanelet::BasicPoint2d(1.0, 100.0)).empty());
+
+  // Points on shared bounds are candidates of both lanelets
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200, 1210 }), index.candidates(lanelet::BasicPoint2d(3.7, 1.0)));
+
+  // Added lanelets are inserted
+  auto added = carma_wm::test::getLanelet(1500, { carma_wm::test::getPoint(0.0, 0.5, 0), carma_wm::test::getPoint(0.0, 1.5, 0) },
+                                          { carma_wm::test::getPoint(1.0, 0.5, 0), carma_wm::test::getPoint(1.0, 1.5, 0) });
+  map->add(added);
+  index.update(map->laneletLayer, { 1500 });
+  ASSERT_EQ(map->laneletLayer.size(), index.size());
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200, 1500 }), index.candidates(lanelet::BasicPoint2d(0.5, 1.0)));
+
+  // Edited lanelets are reindexed
+  lanelet::Lanelet edited = map->laneletLayer.get(1500);
+  edited.leftBound().back().y() = 10.0;
+  edited.rightBound().back().y() = 10.0;
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200 }), index.candidates(lanelet::BasicPoint2d(0.5, 5.0)));
+  index.update(map->laneletLayer, { 1500 });
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200, 1500 }), index.candidates(lanelet::BasicPoint2d(0.5, 5.0)));
+  ASSERT_EQ(map->laneletLayer.size(), index.size());
+
+  // Ids which are not in the layer are removed
+  auto other_map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+  index.update(other_map->laneletLayer, { 1500 });
+  ASSERT_EQ(other_map->laneletLayer.size(), index.size());
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1200 }), index.candidates(lanelet::BasicPoint2d(0.5, 5.0)));
+
+  index.clear();
+  ASSERT_EQ(0u, index.size());
+  ASSERT_TRUE(index.candidates(lanelet::BasicPoint2d(1.0, 1.0)).empty());
+}
+
+TEST(LaneletSpatialIndex, geometry)
+{
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+
+  LaneletSpatialIndex index;
+  ASSERT_EQ(nullptr, index.geometry(1200));
+
+  index.build(map->laneletLayer);
+
+  lanelet::ConstLanelet llt = map->laneletLayer.get(1210);
+  const LaneletGeometry* geometry = index.geometry(llt);
+  ASSERT_NE(nullptr, geometry);
+  ASSERT_EQ(geometry, index.geometry(1210));
+
+  auto polygon = llt.polygon2d().basicPolygon();
+  ASSERT_EQ(polygon.size(), geometry->polygon.size());
+  for (size_t i = 0; i < polygon.size(); i++)
+  {
+    ASSERT_EQ(polygon[i], geometry->polygon[i]);
+  }
+
+  ASSERT_NEAR(3.7, geometry->bounding_box.min_corner().x(), 0.000001);
+  ASSERT_NEAR(0.0, geometry->bounding_box.min_corner().y(), 0.000001);
+  ASSERT_NEAR(7.4, geometry->bounding_box.max_corner().x(), 0.000001);
+  ASSERT_NEAR(25.0, geometry->bounding_box.max_corner().y(), 0.000001);
+
+  auto centerline = lanelet::utils::to2D(llt.centerline()).basicLineString();
+  ASSERT_EQ(centerline.size(), geometry->centerline.size());
+  for (size_t i = 0; i < centerline.size(); i++)
+  {
+    ASSERT_EQ(centerline[i], geometry->centerline[i]);
+  }
+
+  // Inverted lanelets share the geometry of the non inverted lanelet
+  ASSERT_EQ(geometry, index.geometry(llt.invert()));
+
+  // Lanelets with the same id from another map are not matched
+  auto other_map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+  ASSERT_EQ(nullptr, index.geometry(lanelet::ConstLanelet(other_map->laneletLayer.get(1210))));
+
+  // Geometry is recomputed when the lanelet is reindexed
+  lanelet::Lanelet edited = map->laneletLayer.get(1210);
+  edited.leftBound().back().y() = 30.0;
+  edited.rightBound().back().y() = 30.0;
+  ASSERT_NEAR(25.0, index.geometry(1210)->bounding_box.max_corner().y(), 0.000001);
+  index.update(map->laneletLayer, { 1210 });
+  ASSERT_NEAR(30.0, index.geometry(1210)->bounding_box.max_corner().y(), 0.000001);
+}
+}  // namespace carma_wm
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <gmock/gmock.h>
+#include <carma_wm/LineStringIndex.h>
+#include <carma_wm/Geometry.h>
+#include <carma_wm/WMTestLibForGuidance.h>
+#include <cmath>
+#include "TestHelpers.h"
+
+namespace carma_wm
+{
+namespace
+{
+void expectMatchesScalar(const geometry::LineStringIndex& index, const lanelet::BasicPoint2d& p)
+{
+  auto expected = geometry::matchSegment(p, index.lineString());
+  auto actual = index.matchSegment(p);
+
+  ASSERT_EQ(std::get<0>(expected).downtrack, std::get<0>(actual).downtrack);
+  ASSERT_EQ(std::get<0>(expected).crosstrack, std::get<0>(actual).crosstrack);
+  ASSERT_EQ(std::get<1>(expected).first, std::get<1>(actual).first);
+  ASSERT_EQ(std::get<1>(expected).second, std::get<1>(actual).second);
+}
+}  // namespace
+
+TEST(LineStringIndex, matchSegment)
+{
+  ASSERT_THROW(geometry::LineStringIndex(lanelet::BasicLineString2d({ lanelet::BasicPoint2d(0, 0) })),
+               std::invalid_argument);
+
+  // Two segment line string with equal distance ties between segments
+  geometry::LineStringIndex simple({ lanelet::BasicPoint2d(0, 0), lanelet::BasicPoint2d(1, 0),
+                                     lanelet::BasicPoint2d(2, 0) });
+  ASSERT_NEAR(2.0, simple.length(), 0.000001);
+  expectMatchesScalar(simple, lanelet::BasicPoint2d(0.5, 0.5));
+  expectMatchesScalar(simple, lanelet::BasicPoint2d(1, 1));    // Equidistant from both segments
+  expectMatchesScalar(simple, lanelet::BasicPoint2d(-1, 0));   // Before the line string
+  expectMatchesScalar(simple, lanelet::BasicPoint2d(3, -1));   // After the line string
+  expectMatchesScalar(simple, lanelet::BasicPoint2d(0.5, 0));  // Equidistant from two vertices
+
+  // Long line string which doubles back on itself so distant parts of the line are spatially close
+  lanelet::BasicLineString2d hairpin;
+  for (int i = 0; i < 200; i++)
+  {
+    hairpin.push_back(lanelet::BasicPoint2d(i * 0.5, 0));
+  }
+  for (int i = 0; i < 200; i++)
+  {
+    double angle = M_PI * i / 199.0;
+    hairpin.push_back(lanelet::BasicPoint2d(100 + 5 * std::sin(angle), 5 - 5 * std::cos(angle)));
+  }
+  for (int i = 199; i >= 0; i--)
+  {
+    hairpin.push_back(lanelet::BasicPoint2d(i * 0.5, 10));
+  }
+  geometry::LineStringIndex index(hairpin);
+  ASSERT_EQ(hairpin.size(), index.lineString().size());
+
+  for (double x = -10; x < 115; x += 0.37)
+  {
+    for (double y = -4; y < 14; y += 0.61)
+    {
+      expectMatchesScalar(index, lanelet::BasicPoint2d(x, y));
+    }
+  }
+
+  // Points exactly on vertices and exactly between the two straight sections
+  for (size_t i = 0; i < hairpin.size(); i += 7)
+  {
+    expectMatchesScalar(index, hairpin[i]);
+  }
+  for (int i = 0; i < 200; i++)
+  {
+    expectMatchesScalar(index, lanelet::BasicPoint2d(i * 0.5, 5));
+    expectMatchesScalar(index, lanelet::BasicPoint2d(i * 0.5 + 0.25, 5));
+  }
+
+  // The nearest vertex is the first of equally near vertices
+  ASSERT_EQ(0u, simple.nearestVertex(lanelet::BasicPoint2d(0.5, 0)));
+  ASSERT_EQ(0u, index.nearestVertex(lanelet::BasicPoint2d(0, 5)));
+}
+
+TEST(LineStringIndex, batchTrackPos)
+{
+  // Line string which doubles back on itself so the nearest vertex often jumps between the two straight sections
+  lanelet::BasicLineString2d hairpin;
+  for (int i = 0; i < 200; i++)
+  {
+    hairpin.push_back(lanelet::BasicPoint2d(i * 0.5, 0));
+  }
+  for (int i = 199; i >= 0; i--)
+  {
+    hairpin.push_back(lanelet::BasicPoint2d(i * 0.5, 3));
+  }
+  geometry::LineStringIndex index(hairpin);
+
+  // Points along the line string followed by points in no particular order
+  std::vector<lanelet::BasicPoint2d> points;
+  for (double x = -5; x < 105; x += 0.4)
+  {
+    points.push_back(lanelet::BasicPoint2d(x, 1.4));
+  }
+  for (int i = 0; i < 200; i++)
+  {
+    points.push_back(lanelet::BasicPoint2d(std::fmod(i * 37.3, 110) - 5, std::fmod(i * 1.7, 5) - 1));
+  }
+  points.push_back(lanelet::BasicPoint2d(10, 1.5));  // Equidistant from both straight sections
+
+  std::vector<TrackPos> output;
+  index.trackPos(points, output);
+
+  ASSERT_EQ(points.size(), output.size());
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    TrackPos expected = std::get<0>(geometry::matchSegment(points[i], hairpin));
+    ASSERT_NEAR(expected.downtrack, output[i].downtrack, 1e-9);
+    ASSERT_NEAR(expected.crosstrack, output[i].crosstrack, 1e-9);
+  }
+}
+
+TEST(LineStringIndex, cache)
+{
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+  lanelet::ConstLanelet llt = map->laneletLayer.get(1200);
+
+  geometry::LineStringIndexCache cache(2);
+  ASSERT_EQ(0u, cache.size());
+
+  // Centerlines are cached by lanelet id
+  auto centerline = cache.getCenterline(llt);
+  ASSERT_EQ(1u, cache.size());
+  ASSERT_EQ(centerline, cache.getCenterline(llt));
+  ASSERT_EQ(1u, cache.size());
+
+  lanelet::BasicPoint2d p(1.0, 10.0);
+  TrackPos expected = geometry::trackPos(llt, p);
+  TrackPos actual = cache.trackPos(llt, p);
+  ASSERT_EQ(expected.downtrack, actual.downtrack);
+  ASSERT_EQ(expected.crosstrack, actual.crosstrack);
+
+  // Inverted lanelets are cached separately
+  lanelet::ConstLanelet inverted = llt.invert();
+  auto inverted_centerline = cache.getCenterline(inverted);
+  ASSERT_NE(centerline, inverted_centerline);
+  ASSERT_EQ(2u, cache.size());
+  expected = geometry::trackPos(inverted, p);
+  actual = cache.trackPos(inverted, p);
+  ASSERT_EQ(expected.downtrack, actual.downtrack);
+  ASSERT_EQ(expected.crosstrack, actual.crosstrack);
+
+  // Line strings are cached by their id and the cache is emptied once full
+  lanelet::ConstLineString2d left_bound = llt.leftBound2d();
+  auto left_index = cache.get(left_bound);
+  ASSERT_EQ(1u, cache.size());
+  ASSERT_EQ(left_index, cache.get(left_bound));
+
+  // Line strings which changed under the same id are rebuilt
+  lanelet::LineString3d modified = map->lineStringLayer.get(left_bound.id());
+  modified.push_back(carma_wm::test::getPoint(0, 30, 0));
+  auto modified_index = cache.get(lanelet::utils::to2D(modified));
+  ASSERT_NE(left_index, modified_index);
+  ASSERT_EQ(modified.size(), modified_index->lineString().size());
+  ASSERT_EQ(1u, cache.size());
+
+  // A line string with the same id as a lanelet does not replace its centerline
+  cache.clear();
+  auto llt_centerline = cache.getCenterline(llt);
+  lanelet::LineString3d same_id(llt.id(), { carma_wm::test::getPoint(0, 0, 0), carma_wm::test::getPoint(1, 0, 0) });
+  auto same_id_index = cache.get(lanelet::utils::to2D(same_id));
+  ASSERT_NE(llt_centerline, same_id_index);
+  ASSERT_EQ(2u, cache.size());
+  ASSERT_EQ(llt_centerline, cache.getCenterline(llt));
+  ASSERT_EQ(same_id_index, cache.get(lanelet::utils::to2D(same_id)));
+
+  cache.clear();
+  ASSERT_EQ(0u, cache.size());
+}
+
+}  // namespace carma_wm
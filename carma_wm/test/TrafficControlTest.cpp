@@ -91,4 +91,152 @@ TEST(TrafficControl, TrafficControlBinMsgTest)
                                                                                     // but again, they are same elements
 }
 
+TEST(TrafficControl, TrafficControlCompactBinMsgTest)
+{
+  using namespace lanelet::units::literals;
+  auto p1 = getPoint(0, 0, 0);
+  auto p2 = getPoint(0, 1, 0);
+  auto p3 = getPoint(1, 1, 0);
+  auto p4 = getPoint(1, 0, 0);
+
+  lanelet::LineString3d left_ls_1(lanelet::utils::getId(), { p1, p2 });
+  lanelet::LineString3d right_ls_1(lanelet::utils::getId(), { p4, p3 });
+
+  auto ll_1 = getLanelet(left_ls_1, right_ls_1, lanelet::AttributeValueString::SolidSolid,
+                         lanelet::AttributeValueString::Dashed);
+  lanelet::LaneletMapPtr map = lanelet::utils::createMap({ ll_1 }, {});
+
+  // A line string which is not part of the map
+  lanelet::LineString3d new_line(lanelet::utils::getId(), { getPoint(2, 0, 0), getPoint(2, 1, 0) });
+
+  lanelet::DigitalSpeedLimitPtr speed_limit_old = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(9000, 5_mph, {ll_1}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  lanelet::DigitalSpeedLimitPtr speed_limit_new = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(9001, 10_mph, {ll_1}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  lanelet::PassingControlLinePtr map_pcl = std::make_shared<lanelet::PassingControlLine>(lanelet::PassingControlLine::buildData(9002, { left_ls_1.invert() }, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  lanelet::PassingControlLinePtr new_pcl = std::make_shared<lanelet::PassingControlLine>(lanelet::PassingControlLine::buildData(9003, { new_line }, {},
+                                                     { lanelet::Participants::VehicleCar }));
+
+  auto gf_ptr = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  gf_ptr->id_ = boost::uuids::random_generator()();
+  gf_ptr->remove_list_.push_back(std::make_pair(ll_1.id(), speed_limit_old));
+  gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), speed_limit_new));
+  gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), map_pcl));
+  gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), new_pcl));
+
+  autoware_lanelet2_msgs::MapBin legacy_msg;
+  carma_wm::toBinMsg(gf_ptr, &legacy_msg);
+  autoware_lanelet2_msgs::MapBin compact_msg;
+  carma_wm::toCompactBinMsg(gf_ptr, &compact_msg, map);
+  ASSERT_LT(compact_msg.data.size(), legacy_msg.data.size());
+
+  auto legacy = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(legacy_msg, legacy);
+  auto compact = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(compact_msg, compact, map);
+
+  // Both encodings decode to the same update
+  ASSERT_EQ(compact->id_, legacy->id_);
+  ASSERT_EQ(compact->remove_list_.size(), legacy->remove_list_.size());
+  ASSERT_EQ(compact->update_list_.size(), legacy->update_list_.size());
+  for (size_t i = 0; i < legacy->update_list_.size(); i++)
+  {
+    ASSERT_EQ(compact->update_list_[i].first, legacy->update_list_[i].first);
+    ASSERT_EQ(compact->update_list_[i].second->id(), legacy->update_list_[i].second->id());
+    ASSERT_EQ(compact->update_list_[i].second->attribute(lanelet::AttributeName::Subtype).value(),
+              legacy->update_list_[i].second->attribute(lanelet::AttributeName::Subtype).value());
+  }
+  ASSERT_EQ(compact->remove_list_[0].second->id(), speed_limit_old->id());
+  ASSERT_NEAR(10_mph.value(), std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>(compact->update_list_[0].second)->getSpeedLimit().value(), 0.0001);
+
+  // Primitives of the map resolve to the map primitives while new primitives are restored from the message
+  auto compact_map_pcl = std::dynamic_pointer_cast<lanelet::PassingControlLine>(compact->update_list_[1].second);
+  ASSERT_TRUE(!!compact_map_pcl);
+  lanelet::LineString3d control_line = boost::get<lanelet::LineString3d>(compact_map_pcl->getParameters().begin()->second.front());
+  ASSERT_EQ(control_line.constData(), left_ls_1.constData());
+  ASSERT_TRUE(control_line.inverted());
+
+  auto compact_new_pcl = compact->update_list_[2].second;
+  lanelet::LineString3d new_control_line = boost::get<lanelet::LineString3d>(compact_new_pcl->getParameters().begin()->second.front());
+  ASSERT_EQ(new_control_line.id(), new_line.id());
+  ASSERT_NE(new_control_line.constData(), new_line.constData());
+  ASSERT_EQ(new_control_line.size(), new_line.size());
+  for (size_t i = 0; i < new_line.size(); i++)
+  {
+    ASSERT_EQ(new_control_line[i].id(), new_line[i].id());
+    ASSERT_EQ(new_control_line[i].basicPoint(), new_line[i].basicPoint());
+  }
+
+  // Without a map referenced primitives are placeholders with the same ids
+  auto without_map = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(compact_msg, without_map);
+  ASSERT_EQ(without_map->id_, gf_ptr->id_);
+  ASSERT_EQ(without_map->update_list_.size(), 3);
+  control_line = boost::get<lanelet::LineString3d>(without_map->update_list_[1].second->getParameters().begin()->second.front());
+  ASSERT_EQ(control_line.id(), left_ls_1.id());
+  ASSERT_TRUE(control_line.empty());
+
+  // Primitives which are missing from the provided map cannot be resolved
+  auto missing = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  ASSERT_THROW(carma_wm::fromBinMsg(compact_msg, missing, std::make_shared<lanelet::LaneletMap>()), std::invalid_argument);
+
+  // Compression is transparent to the reader
+  autoware_lanelet2_msgs::MapBin compressed_msg;
+  carma_wm::toCompactBinMsg(gf_ptr, &compressed_msg, map, true);
+  auto compressed = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(compressed_msg, compressed, map);
+  ASSERT_EQ(compressed->id_, gf_ptr->id_);
+  ASSERT_EQ(compressed->update_list_.size(), 3);
+
+  // Corrupt messages are rejected
+  autoware_lanelet2_msgs::MapBin truncated = compact_msg;
+  truncated.data.resize(truncated.data.size() / 2);
+  ASSERT_THROW(carma_wm::fromBinMsg(truncated, missing, map), std::invalid_argument);
+  autoware_lanelet2_msgs::MapBin bad_version = compact_msg;
+  bad_version.data[4] = 0xFF;
+  ASSERT_THROW(carma_wm::fromBinMsg(bad_version, missing, map), std::invalid_argument);
+}
+
+TEST(TrafficControl, TrafficControlCompactBinMsgLaneletLifetimeTest)
+{
+  using namespace lanelet::units::literals;
+  auto ll_1 = getLanelet(lanelet::LineString3d(lanelet::utils::getId(), { getPoint(0, 0, 0), getPoint(0, 1, 0) }),
+                         lanelet::LineString3d(lanelet::utils::getId(), { getPoint(1, 0, 0), getPoint(1, 1, 0) }),
+                         lanelet::AttributeValueString::SolidSolid, lanelet::AttributeValueString::Dashed);
+  lanelet::DigitalSpeedLimitPtr speed_limit = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(9000, 5_mph, {ll_1}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+
+  auto gf_ptr = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  gf_ptr->id_ = boost::uuids::random_generator()();
+  gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), speed_limit));
+
+  // Without a reference map the lanelet is embedded in the message
+  autoware_lanelet2_msgs::MapBin compact_msg;
+  carma_wm::toCompactBinMsg(gf_ptr, &compact_msg);
+
+  auto received = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(compact_msg, received);
+  ASSERT_EQ(received->update_list_.size(), 1);
+
+  // The decoded lanelet parameter is still valid after decoding returned
+  auto received_limit = std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>(received->update_list_[0].second);
+  ASSERT_TRUE(!!received_limit);
+  auto weak_lanelet = boost::get<lanelet::WeakLanelet>(received_limit->getParameters().at(lanelet::RoleName::Refers).front());
+  ASSERT_FALSE(weak_lanelet.expired());
+  lanelet::Lanelet received_llt = weak_lanelet.lock();
+  ASSERT_EQ(received_llt.id(), ll_1.id());
+  ASSERT_EQ(received_llt.leftBound().size(), 2);
+  ASSERT_EQ(received_llt.leftBound()[1].basicPoint(), ll_1.leftBound()[1].basicPoint());
+
+  // The lanelet also survives being encoded again
+  autoware_lanelet2_msgs::MapBin forwarded_msg;
+  carma_wm::toCompactBinMsg(received, &forwarded_msg);
+  auto forwarded = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(forwarded_msg, forwarded);
+  auto forwarded_limit = std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>(forwarded->update_list_[0].second);
+  ASSERT_TRUE(!!forwarded_limit);
+  ASSERT_EQ(forwarded_limit->getParameters().at(lanelet::RoleName::Refers).size(), 1);
+}
+
 }  // namespace carma_wm_ctrl
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include <lanelet2_extension/utility/message_conversion.h>
 #include <../src/WMListenerWorker.h>
 #include <carma_wm/CARMAWorldModel.h>
+#include <carma_wm/FlatBinaryMap.h>
 #include <lanelet2_core/geometry/LineString.h>
 #include <lanelet2_traffic_rules/TrafficRulesFactory.h>
 #include <lanelet2_core/Attribute.h>
@@ -87,6 +88,24 @@ TEST(WMListenerWorkerTest, mapCallback)
   wmlw.mapCallback(map_msg_ptr);
 
   ASSERT_TRUE(flag);
+
+  ///// Test clearing the user defined callback
+  flag = false;
+  wmlw.setMapCallback(std::function<void()>());
+
+  ASSERT_NO_THROW(wmlw.mapCallback(map_msg_ptr));
+  ASSERT_FALSE(flag);
+
+  ///// Test map in the flat binary map format
+  autoware_lanelet2_msgs::MapBin flat_msg;
+  toFlatBinMsg(*map_ptr, &flat_msg);
+  flat_msg.map_version = 1;
+
+  autoware_lanelet2_msgs::MapBinConstPtr flat_msg_ptr(new autoware_lanelet2_msgs::MapBin(flat_msg));
+
+  wmlw.mapCallback(flat_msg_ptr);
+  ASSERT_EQ(map_ptr->laneletLayer.size(), wmlw.getWorldModel()->getMap()->laneletLayer.size());
+  ASSERT_TRUE(wmlw.getWorldModel()->getMap()->laneletLayer.exists(map_ptr->laneletLayer.begin()->id()));
 }
 
 TEST(WMListenerWorkerTest, routeCallback)
@@ -196,8 +215,12 @@ TEST(WMListenerWorkerTest, mapUpdateCallback)
             wmlw.getWorldModel()->getMap()->regulatoryElementLayer.end());
 
   // test the MapUpdateCallback
+  auto graph_before_update = wmlw.getWorldModel()->getMapRoutingGraph();
   auto gf_msg_ptr =  boost::make_shared<autoware_lanelet2_msgs::MapBin>(gf_obj_msg);
   wmlw.mapUpdateCallback(gf_msg_ptr);
+
+  // the new speed limit has the same value so the routing costs are unchanged and the graph is not rebuilt
+  ASSERT_EQ(wmlw.getWorldModel()->getMapRoutingGraph(), graph_before_update);
   
   // check if the map has the new speed limit now
   regems = wmlw.getWorldModel()->getMap()->laneletLayer.get(ll_1.id()).regulatoryElements();
@@ -249,6 +272,122 @@ TEST(WMListenerWorkerTest, mapUpdateCallback)
   ASSERT_EQ(wmlw.getWorldModel()->getMap()->laneletLayer.findUsages(regem_old_correct_data)[0].id(), ll_1.id());
 }
 
+TEST(WMListenerWorkerTest, mapUpdateCallbackRebuildsRoutingGraph)
+{
+  auto p1 = getPoint(0, 0, 0);
+  auto p2 = getPoint(0, 1, 0);
+  auto p3 = getPoint(1, 1, 0);
+  auto p4 = getPoint(1, 0, 0);
+  lanelet::LineString3d left_ls_1(lanelet::utils::getId(), { p1, p2 });
+  lanelet::LineString3d right_ls_1(lanelet::utils::getId(), { p4, p3 });
+
+  auto ll_1 = getLanelet(left_ls_1, right_ls_1, lanelet::AttributeValueString::SolidSolid,
+                         lanelet::AttributeValueString::Dashed);
+
+  WMListenerWorker wmlw;
+  lanelet::LaneletMapPtr map = lanelet::utils::createMap({ ll_1 }, { });
+  autoware_lanelet2_msgs::MapBin map_msg;
+  lanelet::utils::conversion::toBinMsg(map, &map_msg);
+  autoware_lanelet2_msgs::MapBinConstPtr map_msg_ptr(new autoware_lanelet2_msgs::MapBin(map_msg));
+  wmlw.mapCallback(map_msg_ptr);
+
+  ASSERT_TRUE(wmlw.getWorldModel()->getMapRoutingGraph()->passableSubmap()->laneletLayer.exists(ll_1.id()));
+
+  // a different speed limit changes the travel time routing cost
+  using namespace lanelet::units::literals;
+  lanelet::DigitalSpeedLimitPtr speed_limit = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(
+      lanelet::utils::getId(), 10_mph, { ll_1 }, {}, { lanelet::Participants::VehicleCar }));
+  auto speed_gf_ptr = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  speed_gf_ptr->id_ = boost::uuids::random_generator()();
+  speed_gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), speed_limit));
+
+  autoware_lanelet2_msgs::MapBin speed_msg;
+  carma_wm::toBinMsg(speed_gf_ptr, &speed_msg);
+
+  auto graph_before_speed_update = wmlw.getWorldModel()->getMapRoutingGraph();
+  wmlw.mapUpdateCallback(boost::make_shared<autoware_lanelet2_msgs::MapBin>(speed_msg));
+  ASSERT_NE(wmlw.getWorldModel()->getMapRoutingGraph(), graph_before_speed_update);
+
+  // closing the lanelet to vehicles changes its passability
+  std::shared_ptr<lanelet::RegionAccessRule> closure = std::make_shared<lanelet::RegionAccessRule>(lanelet::RegionAccessRule::buildData(
+      lanelet::utils::getId(), { ll_1 }, {}, { lanelet::Participants::Pedestrian }));
+
+  auto gf_ptr = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  gf_ptr->id_ = boost::uuids::random_generator()();
+  gf_ptr->update_list_.push_back(std::make_pair(ll_1.id(), closure));
+
+  autoware_lanelet2_msgs::MapBin gf_obj_msg;
+  carma_wm::toBinMsg(gf_ptr, &gf_obj_msg);
+  gf_obj_msg.header.seq = 1;
+
+  auto graph_before_update = wmlw.getWorldModel()->getMapRoutingGraph();
+  wmlw.mapUpdateCallback(boost::make_shared<autoware_lanelet2_msgs::MapBin>(gf_obj_msg));
+
+  ASSERT_NE(wmlw.getWorldModel()->getMapRoutingGraph(), graph_before_update);
+  ASSERT_FALSE(wmlw.getWorldModel()->getMapRoutingGraph()->passableSubmap()->laneletLayer.exists(ll_1.id()));
+}
+
+TEST(WMListenerWorkerTest, consolidatedMapUpdate)
+{
+  using namespace lanelet::units::literals;
+  auto p1 = getPoint(0, 0, 0);
+  auto p2 = getPoint(0, 1, 0);
+  auto p3 = getPoint(1, 1, 0);
+  auto p4 = getPoint(1, 0, 0);
+  lanelet::LineString3d left_ls_1(lanelet::utils::getId(), { p1, p2 });
+  lanelet::LineString3d right_ls_1(lanelet::utils::getId(), { p4, p3 });
+
+  auto ll_1 = getLanelet(left_ls_1, right_ls_1, lanelet::AttributeValueString::SolidSolid,
+                         lanelet::AttributeValueString::Dashed);
+
+  lanelet::DigitalSpeedLimitPtr speed_limit_old = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(9000, 5_mph, {ll_1}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  lanelet::DigitalSpeedLimitPtr speed_limit_new = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(9001, 5_mph, {ll_1}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+
+  WMListenerWorker wmlw;
+  ll_1.addRegulatoryElement(speed_limit_old);
+  lanelet::LaneletMapPtr map = lanelet::utils::createMap({ ll_1 }, { });
+  autoware_lanelet2_msgs::MapBin map_msg;
+  lanelet::utils::conversion::toBinMsg(map, &map_msg);
+  autoware_lanelet2_msgs::MapBinConstPtr map_msg_ptr(new autoware_lanelet2_msgs::MapBin(map_msg));
+  wmlw.mapCallback(map_msg_ptr);
+
+  std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> update_list = { std::make_pair(ll_1.id(), speed_limit_new) };
+  std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> remove_list = { std::make_pair(ll_1.id(), speed_limit_old) };
+
+  // A live update replaces the old speed limit
+  autoware_lanelet2_msgs::MapBin live_msg;
+  carma_wm::toBinMsg(std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(boost::uuids::random_generator()(), update_list, remove_list)), &live_msg);
+  live_msg.header.seq = 1;
+  wmlw.mapUpdateCallback(boost::make_shared<autoware_lanelet2_msgs::MapBin>(live_msg));
+
+  auto regems = wmlw.getWorldModel()->getMap()->laneletLayer.get(ll_1.id()).regulatoryElements();
+  ASSERT_EQ(regems.size(), 1);
+  ASSERT_EQ(regems[0]->id(), speed_limit_new->id());
+
+  // After reconnecting the listener receives the consolidated update containing the same change relative to the base map.
+  // It is not applied twice
+  autoware_lanelet2_msgs::MapBin consolidated_msg;
+  carma_wm::toBinMsg(std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(boost::uuids::nil_uuid(), update_list, remove_list)), &consolidated_msg);
+  consolidated_msg.header.seq = 3;
+  wmlw.mapUpdateCallback(boost::make_shared<autoware_lanelet2_msgs::MapBin>(consolidated_msg));
+
+  regems = wmlw.getWorldModel()->getMap()->laneletLayer.get(ll_1.id()).regulatoryElements();
+  ASSERT_EQ(regems.size(), 1);
+  ASSERT_EQ(regems[0]->id(), speed_limit_new->id());
+
+  // The listener missed the removal of the change, so the consolidated update is empty. The lanelet returns to the base map
+  autoware_lanelet2_msgs::MapBin empty_msg;
+  carma_wm::toBinMsg(std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(boost::uuids::nil_uuid(), {}, {})), &empty_msg);
+  empty_msg.header.seq = 5;
+  wmlw.mapUpdateCallback(boost::make_shared<autoware_lanelet2_msgs::MapBin>(empty_msg));
+
+  regems = wmlw.getWorldModel()->getMap()->laneletLayer.get(ll_1.id()).regulatoryElements();
+  ASSERT_EQ(regems.size(), 1);
+  ASSERT_EQ(regems[0]->id(), speed_limit_old->id());
+}
+
 TEST(WMListenerWorkerTest, setConfigSpeedLimitTest)
 {
   WMListenerWorker wmlw;
@@ -0,0 +1,104 @@
+#pragma once
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <lanelet2_core/primitives/Lanelet.h>
+
+namespace carma_wm_ctrl
+{
+/**
+ * @brief Index of the active geofence lanelets on the current route ordered by the downtrack distance along the route
+ * at which each lanelet starts.
+ *
+ * The route downtrack of each route lanelet is computed once when the route is set. Activating or deactivating a
+ * geofence lanelet is O(log n) and finding the next active geofence lanelet ahead of a route downtrack is O(log n),
+ * so per pose checks do not need to iterate over the route or the active geofences.
+ * NOTE: This class is not thread safe. Synchronization is left to the owner.
+ */
+class RouteGeofenceIndex
+{
+public:
+  /**
+   * @brief Set the route which is indexed. Any of the provided active lanelets which are on the route are indexed.
+   * The downtrack only advances by the length of a lanelet when the next route lanelet follows it. A lanelet reached by
+   * a lane change starts at the downtrack of its first centerline point along the lanelet it was changed from.
+   *
+   * @param route The lanelets of the route in order of travel
+   * @param active_lanelet_ids The ids of the lanelets which currently have an active geofence
+   */
+  void setRoute(const lanelet::ConstLanelets& route, const std::unordered_set<lanelet::Id>& active_lanelet_ids);
+
+  /**
+   * @brief Mark the lanelet with the provided id as having an active geofence. Lanelets not on the route are ignored.
+   *
+   * @param lanelet_id The id of the lanelet
+   */
+  void activate(lanelet::Id lanelet_id);
+
+  /**
+   * @brief Mark the lanelet with the provided id as no longer having an active geofence.
+   *
+   * @param lanelet_id The id of the lanelet
+   */
+  void deactivate(lanelet::Id lanelet_id);
+
+  /**
+   * @brief Returns true if the lanelet with the provided id is on the route
+   */
+  bool onRoute(lanelet::Id lanelet_id) const;
+
+  /**
+   * @brief Returns the downtrack distance along the route of the provided point
+   *
+   * @param llt The route lanelet containing the point
+   * @param point The point to compute the downtrack of
+   *
+   * @throw std::invalid_argument if llt is not on the route
+   *
+   * @return The downtrack distance in meters from the start of the route
+   */
+  double routeDowntrack(const lanelet::ConstLanelet& llt, const lanelet::BasicPoint2d& point) const;
+
+  /**
+   * @brief Returns the route distance from the provided route downtrack to the start of the nearest active geofence
+   * lanelet which starts after it. O(log n)
+   *
+   * @param downtrack The downtrack distance along the route in meters
+   * @param current_lanelet_id The id of a lanelet to ignore such as the lanelet which the downtrack is on
+   *
+   * @return The distance in meters or 0 if there is no active geofence lanelet ahead on the route
+   */
+  double distToNextActive(double downtrack, lanelet::Id current_lanelet_id = lanelet::InvalId) const;
+
+  /**
+   * @brief Returns the ids of the active geofence lanelets on the route in order of travel
+   */
+  std::vector<lanelet::Id> activeLanelets() const;
+
+  /**
+   * @brief Remove the route and all active lanelets from this index
+   */
+  void clear();
+
+private:
+  std::unordered_map<lanelet::Id, double> route_downtracks_;  // Route downtrack at the start of each route lanelet
+  std::set<std::pair<double, lanelet::Id>> active_;           // Active geofence lanelets on the route by start downtrack
+};
+}  // namespace carma_wm_ctrl
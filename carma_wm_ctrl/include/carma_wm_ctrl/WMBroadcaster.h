@@ -23,7 +23,10 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/date_defs.hpp>
 #include <boost/icl/interval_set.hpp>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
+#include <boost/optional.hpp>
 #include "ros/ros.h"
 #include <lanelet2_core/LaneletMap.h>
 #include <lanelet2_core/geometry/Lanelet.h>
@@ -32,6 +35,7 @@
 #include <lanelet2_extension/utility/message_conversion.h>
 #include <lanelet2_extension/projection/local_frame_projector.h>
 #include <carma_wm_ctrl/GeofenceScheduler.h>
+#include <carma_wm_ctrl/RouteGeofenceIndex.h>
 #include <lanelet2_core/geometry/BoundingBox.h>
 #include <lanelet2_core/primitives/BoundingBox.h>
 #include <carma_wm/WMListener.h>
@@ -43,6 +47,7 @@
 #include <geometry_msgs/PoseStamped.h>
 
 #include <carma_wm/MapConformer.h>
+#include <carma_wm/LaneletSpatialIndex.h>
 
 #include <lanelet2_extension/traffic_rules/CarmaUSTrafficRules.h>
 #include <lanelet2_core/utility/Units.h>
@@ -84,6 +89,11 @@ public:
   /*!
    * \brief Callback to set the base map when it has been loaded
    *
+   * The map is deserialized and made compliant once and becomes current_map_. No separate copy of the base map is kept.
+   * Geofences are not applied as an overlay on an immutable base map. They edit the regulatory elements of the affected
+   * lanelets of current_map_ in place, as map users and the geofence lookups read regulatory elements directly from
+   * the lanelets. The replaced regulatory elements are restored when a geofence is removed.
+   *
    * \param map_msg The map message to use as the base map
    */
   void baseMapCallback(const autoware_lanelet2_msgs::MapBinConstPtr& map_msg);
@@ -159,6 +169,23 @@ public:
    * \brief Sets the configured speed limit. 
    */
   void setConfigSpeedLimit(double cL);
+
+  /*!
+   * \brief Sets whether map updates are published with the compact map update encoding instead of the boost archive
+   *        encoding. Compact updates reference the primitives of the base map by id so every map update subscriber
+   *        must decode them against its own copy of the map. Must be set before the base map is received
+   * \param compact_map_updates If true map updates use the compact encoding
+   * \param compress If true compact map updates are LZ4 compressed when carma_wm is built with LZ4
+   */
+  void setCompactMapUpdates(bool compact_map_updates, bool compress = false);
+
+  /*!
+   * \brief Sets whether the compliant base map is published in the flat binary map format of carma_wm::toFlatBinMsg
+   *        instead of the boost archive format. Every map subscriber must use a carma_wm which reads the flat binary
+   *        map format. Must be set before the base map is received
+   * \param flat_binary_map If true the map is published in the flat binary map format
+   */
+  void setFlatBinaryMap(bool flat_binary_map);
   
   /*!
    * \brief Returns geofence object from TrafficControlMessageV01 ROS Msg
@@ -170,6 +197,7 @@ public:
 
   /*!
    * \brief Returns the route distance (downtrack or crosstrack in meters) to the nearest active geofence lanelet
+   *        Only the active geofence lanelets on the route are evaluated, which are kept in route order as geofences activate and deactivate
    * \param curr_pos Current position in local coordinates
    * \throw InvalidObjectStateError if base_map is not set
    * \throw std::invalid_argument if curr_pos is not on the road
@@ -222,12 +250,25 @@ public:
 
   /*!
    *  \brief Callback triggered whenever a new subscriber connects to the map_update topic of this node.
-   *         This callback will publish the all updates for the current map to that node so that any missed updates are already included.
+   *         This callback will publish the consolidated update from consolidatedMapUpdate() to that node so that any missed updates are already included.
    *          
    *  \param single_sub_pub A publisher which will publish exclusively to the new subscriber 
    */ 
   void newUpdateSubscriber(const ros::SingleSubscriberPublisher& single_sub_pub) const;
 
+  /*!
+   *  \brief Returns a single map update which has the same effect as all updates applied to the current map version.
+   *         The update only contains the net difference between the current and base regulatory elements of the updated lanelets,
+   *         so geofences which were added then removed are not included and superseded changes are collapsed.
+   *         The update has the sequence number of the most recent update and a nil geofence id.
+   *         As the update is relative to the base map, a subscriber which already applied some of the updates it replaces must
+   *         reset the updated lanelets to the base map before applying it. carma_wm::WMListenerWorker does so for every update
+   *         with a nil geofence id, as defined by carma_wm::TrafficControl::isConsolidated(). For this reason an update without edits is returned once any lanelet has been updated.
+   *
+   *  \return The consolidated update or boost::none if no lanelet has been updated on the current map version
+   */
+  boost::optional<autoware_lanelet2_msgs::MapBin> consolidatedMapUpdate() const;
+
   visualization_msgs::MarkerArray tcm_marker_array_;
   cav_msgs::TrafficControlRequestPolygon tcr_polygon_;
   
@@ -242,20 +283,32 @@ public:
 private:
   lanelet::ConstLanelets route_path_;
   std::unordered_set<lanelet::Id> active_geofence_llt_ids_; 
+  RouteGeofenceIndex route_geofence_index_; // Active geofence lanelets on route_path_ ordered by route downtrack
+  std::unordered_map<lanelet::Id, cav_msgs::CheckActiveGeofence> active_geofence_info_; // Geofence fields of visited lanelets. Cleared whenever a geofence activates or deactivates
+  boost::optional<lanelet::ConstLanelet> laneletContaining(const lanelet::BasicPoint2d& point) const;
+  double routeDistToActiveGeofence(const lanelet::BasicPoint2d& curr_pos, const lanelet::ConstLanelet& curr_lanelet) const;
+  cav_msgs::CheckActiveGeofence activeGeofenceInfo(const lanelet::ConstLanelet& current_llt) const;
   void addRegulatoryComponent(std::shared_ptr<Geofence> gf_ptr) const;
   void addBackRegulatoryComponent(std::shared_ptr<Geofence> gf_ptr) const;
   void removeGeofenceHelper(std::shared_ptr<Geofence> gf_ptr) const;
   void addGeofenceHelper(std::shared_ptr<Geofence> gf_ptr) const;
+  void recordBaseRegulatoryElements(std::shared_ptr<Geofence> gf_ptr);
+  void toMapUpdateMsg(std::shared_ptr<carma_wm::TrafficControl> update, autoware_lanelet2_msgs::MapBin* msg) const;
   bool shouldChangeControlLine(const lanelet::ConstLaneletOrArea& el,const lanelet::RegulatoryElementConstPtr& regem, std::shared_ptr<Geofence> gf_ptr) const;
   void addPassingControlLineFromMsg(std::shared_ptr<Geofence> gf_ptr, const cav_msgs::TrafficControlMessageV01& msg_v01, const std::vector<lanelet::Lanelet>& affected_llts) const; 
   std::unordered_set<lanelet::Lanelet> filterSuccessorLanelets(const std::unordered_set<lanelet::Lanelet>& possible_lanelets, const std::unordered_set<lanelet::Lanelet>& root_lanelets);
-  lanelet::LaneletMapPtr base_map_;
-  lanelet::LaneletMapPtr current_map_;
+  lanelet::LaneletMapPtr current_map_; // Compliant base map with the regulatory elements of active geofences applied
+  carma_wm::LaneletSpatialIndex lanelet_index_; // Bounding boxes and polygons of the lanelets in current_map_
   lanelet::Velocity config_limit;
+  bool compact_map_updates_ = false;
+  bool compress_map_updates_ = false;
+  bool flat_binary_map_ = false;
+  // Primitives of the compliant base map. Only these are sent by reference in compact map updates as geofences add
+  // primitives to current_map_ which subscribers do not hold. Only kept when compact map updates are enabled
+  lanelet::LaneletMapConstPtr base_map_primitives_;
   std::unordered_set<std::string>  checked_geofence_ids_;
   std::unordered_set<std::string>  generated_geofence_reqids_;
-  std::vector<lanelet::LaneletMapPtr> cached_maps_;
-  std::mutex map_mutex_;
+  mutable std::mutex map_mutex_;
   PublishMapCallback map_pub_;
   PublishMapUpdateCallback map_update_pub_;
   PublishCtrlRequestCallback control_msg_pub_;
@@ -271,11 +324,12 @@ private:
 
   cav_msgs::Route current_route; // Most recently received route message
   /**
-   * Queue which stores the map updates applied to the current map version as a sequence of diffs
-   * This queue is implemented as a vector because it gets reused by each new subscriber connection
-   * NOTE: This queue should be cleared each time the current_map_version changes
+   * Regulatory elements of each lanelet edited by a map update before its first edit on the current map version
+   * Comparing these with the current regulatory elements gives the net change made by all updates
+   * NOTE: This map should be cleared each time the current_map_version changes
    */
-  std::vector<autoware_lanelet2_msgs::MapBin> map_update_message_queue_; 
+  std::map<lanelet::Id, lanelet::RegulatoryElementPtrs> base_lanelet_regems_;
+  bool updates_invalidated_route_ = false; // True if any update applied to the current map version invalidated the route
 
   size_t update_count_ = 0; // Records the total number of sent map updates. Used as the set value for update.header.seq
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <carma_wm_ctrl/RouteGeofenceIndex.h>
+#include <carma_wm/Geometry.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace carma_wm_ctrl
+{
+void RouteGeofenceIndex::setRoute(const lanelet::ConstLanelets& route,
+                                  const std::unordered_set<lanelet::Id>& active_lanelet_ids)
+{
+  clear();
+
+  double downtrack = 0;
+  for (size_t i = 0; i < route.size(); i++)
+  {
+    if (i > 0)
+    {
+      const lanelet::ConstLanelet& prev = route[i - 1];
+      if (lanelet::geometry::follows(prev, route[i]))
+      {
+        downtrack += lanelet::geometry::length2d(prev);
+      }
+      else
+      {
+        // Lane change. The lanelet runs alongside the previous one so its start is projected onto the previous one
+        downtrack +=
+            carma_wm::geometry::trackPos(prev, route[i].centerline2d().front().basicPoint2d()).downtrack;
+      }
+    }
+    route_downtracks_.emplace(route[i].id(), downtrack);  // If a lanelet repeats only its first occurrence is indexed
+  }
+
+  for (auto id : active_lanelet_ids)
+  {
+    activate(id);
+  }
+}
+
+void RouteGeofenceIndex::activate(lanelet::Id lanelet_id)
+{
+  auto route_downtrack = route_downtracks_.find(lanelet_id);
+  if (route_downtrack == route_downtracks_.end())
+  {
+    return;
+  }
+  active_.emplace(route_downtrack->second, lanelet_id);
+}
+
+void RouteGeofenceIndex::deactivate(lanelet::Id lanelet_id)
+{
+  auto route_downtrack = route_downtracks_.find(lanelet_id);
+  if (route_downtrack == route_downtracks_.end())
+  {
+    return;
+  }
+  active_.erase(std::make_pair(route_downtrack->second, lanelet_id));
+}
+
+bool RouteGeofenceIndex::onRoute(lanelet::Id lanelet_id) const
+{
+  return route_downtracks_.find(lanelet_id) != route_downtracks_.end();
+}
+
+double RouteGeofenceIndex::routeDowntrack(const lanelet::ConstLanelet& llt, const lanelet::BasicPoint2d& point) const
+{
+  auto route_downtrack = route_downtracks_.find(llt.id());
+  if (route_downtrack == route_downtracks_.end())
+  {
+    throw std::invalid_argument("Lanelet " + std::to_string(llt.id()) + " is not on the route");
+  }
+  return route_downtrack->second + carma_wm::geometry::trackPos(llt, point).downtrack;
+}
+
+double RouteGeofenceIndex::distToNextActive(double downtrack, lanelet::Id current_lanelet_id) const
+{
+  // First lanelet which starts strictly after the downtrack
+  auto next = active_.upper_bound(std::make_pair(downtrack, std::numeric_limits<lanelet::Id>::max()));
+  while (next != active_.end() && next->second == current_lanelet_id)
+  {
+    next++;
+  }
+
+  if (next == active_.end())
+  {
+    return 0.0;
+  }
+  return next->first - downtrack;
+}
+
+std::vector<lanelet::Id> RouteGeofenceIndex::activeLanelets() const
+{
+  std::vector<lanelet::Id> ids;
+  ids.reserve(active_.size());
+  for (const auto& active : active_)
+  {
+    ids.push_back(active.second);
+  }
+  return ids;
+}
+
+void RouteGeofenceIndex::clear()
+{
+  route_downtracks_.clear();
+  active_.clear();
+}
+}  // namespace carma_wm_ctrl
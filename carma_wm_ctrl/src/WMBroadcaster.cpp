@@ -19,6 +19,7 @@
 #include <carma_wm_ctrl/WMBroadcaster.h>
 #include <carma_wm/Geometry.h>
 #include <carma_wm/MapConformer.h>
+#include <carma_wm/FlatBinaryMap.h>
 #include <lanelet2_extension/utility/message_conversion.h>
 #include <lanelet2_extension/projection/local_frame_projector.h>
 #include <lanelet2_core/primitives/Lanelet.h>
@@ -69,23 +70,69 @@ void WMBroadcaster::baseMapCallback(const autoware_lanelet2_msgs::MapBinConstPtr
     ROS_WARN("WMBroadcaster::baseMapCallback called multiple times in the same node");
   }
 
-  lanelet::LaneletMapPtr new_map(new lanelet::LaneletMap);
-  lanelet::LaneletMapPtr new_map_to_change(new lanelet::LaneletMap);
+  lanelet::LaneletMapPtr new_map = carma_wm::mapFromBinMsg(*map_msg);
 
-  lanelet::utils::conversion::fromBinMsg(*map_msg, new_map);
-  lanelet::utils::conversion::fromBinMsg(*map_msg, new_map_to_change);
+  // The map is only deserialized and made compliant once and no second copy of the base map is kept.
+  // Geofences edit current_map_ in place. Each geofence records the regulatory elements it replaces on the
+  // affected lanelets and restores them when it is removed
+  current_map_ = new_map;
 
-  base_map_ = new_map;  // Store map
-  current_map_ = new_map_to_change; // broadcaster makes changes to this
+  lanelet::MapConformer::ensureCompliance(current_map_, config_limit); // Update map to ensure it complies with expectations
 
-  lanelet::MapConformer::ensureCompliance(base_map_, config_limit);     // Update map to ensure it complies with expectations
-  lanelet::MapConformer::ensureCompliance(current_map_, config_limit);
+  lanelet_index_.build(current_map_->laneletLayer); // Geofence lookups only need the lanelet geometry which is never edited
+  active_geofence_info_.clear();
+
+  base_map_primitives_ = nullptr;
+  if (compact_map_updates_)
+  {
+    // The base map primitives are shared with current_map_ so compact map updates can compare them by identity
+    auto base_map_primitives = std::make_shared<lanelet::LaneletMap>();
+    for (auto llt : current_map_->laneletLayer)
+    {
+      base_map_primitives->add(llt);
+    }
+    for (auto area : current_map_->areaLayer)
+    {
+      base_map_primitives->add(area);
+    }
+    for (auto polygon : current_map_->polygonLayer)
+    {
+      if (!base_map_primitives->polygonLayer.exists(polygon.id()))
+      {
+        base_map_primitives->add(polygon);
+      }
+    }
+    for (auto ls : current_map_->lineStringLayer)
+    {
+      if (!base_map_primitives->lineStringLayer.exists(ls.id()))
+      {
+        base_map_primitives->add(ls);
+      }
+    }
+    for (auto point : current_map_->pointLayer)
+    {
+      if (!base_map_primitives->pointLayer.exists(point.id()))
+      {
+        base_map_primitives->add(point);
+      }
+    }
+    base_map_primitives_ = base_map_primitives;
+  }
 
   // Publish map
   current_map_version_ += 1; // Increment the map version. It should always start from 1 for the first map
-  map_update_message_queue_.clear(); // Clear the update queue as the map version has changed
+  base_lanelet_regems_.clear(); // Clear the record of updated lanelets as the map version has changed
+  updates_invalidated_route_ = false;
   autoware_lanelet2_msgs::MapBin compliant_map_msg;
-  lanelet::utils::conversion::toBinMsg(base_map_, &compliant_map_msg);
+  // No geofences have been applied yet so this is the compliant base map
+  if (flat_binary_map_)
+  {
+    carma_wm::toFlatBinMsg(*current_map_, &compliant_map_msg);
+  }
+  else
+  {
+    lanelet::utils::conversion::toBinMsg(current_map_, &compliant_map_msg);
+  }
   compliant_map_msg.map_version = current_map_version_;
   map_pub_(compliant_map_msg);
 };
@@ -497,6 +544,29 @@ void WMBroadcaster::setConfigSpeedLimit(double cL)
   config_limit = lanelet::Velocity(cL * lanelet::units::MPH());
 }
 
+void WMBroadcaster::setCompactMapUpdates(bool compact_map_updates, bool compress)
+{
+  compact_map_updates_ = compact_map_updates;
+  compress_map_updates_ = compress;
+}
+
+void WMBroadcaster::setFlatBinaryMap(bool flat_binary_map)
+{
+  flat_binary_map_ = flat_binary_map;
+}
+
+void WMBroadcaster::toMapUpdateMsg(std::shared_ptr<carma_wm::TrafficControl> update, autoware_lanelet2_msgs::MapBin* msg) const
+{
+  if (compact_map_updates_ && base_map_primitives_)
+  {
+    carma_wm::toCompactBinMsg(update, msg, base_map_primitives_, compress_map_updates_);
+  }
+  else
+  {
+    carma_wm::toBinMsg(update, msg);
+  }
+}
+
 // currently only supports geofence message version 1: TrafficControlMessageV01 
 lanelet::ConstLaneletOrAreas WMBroadcaster::getAffectedLaneletOrAreas(const cav_msgs::TrafficControlMessageV01& tcmV01)
 {
@@ -552,6 +622,7 @@ lanelet::ConstLaneletOrAreas WMBroadcaster::getAffectedLaneletOrAreas(const cav_
   }
   
   // convert all geofence points into our map's frame
+  // The nodes are offsets from the previous node so they are accumulated first and then projected in a single call
   std::vector<lanelet::Point3d> gf_pts;
   cav_msgs::PathNode prev_pt;
   PJ_COORD c_init_latlong{{tcmV01.geometry.reflat, tcmV01.geometry.reflon, tcmV01.geometry.refelv}};
@@ -561,20 +632,31 @@ lanelet::ConstLaneletOrAreas WMBroadcaster::getAffectedLaneletOrAreas(const cav_
   prev_pt.y =  c_init.xyz.y;
 
   ROS_DEBUG_STREAM("In TCM's frame, initial Point X "<< prev_pt.x<<" Before conversion: Point Y "<< prev_pt.y );
-  for (auto pt : tcmV01.geometry.nodes)
+  std::vector<PJ_COORD> node_coords;
+  node_coords.reserve(tcmV01.geometry.nodes.size());
+  for (const auto& pt : tcmV01.geometry.nodes)
   { 
     ROS_DEBUG_STREAM("Before conversion in TCM frame: Point X "<< pt.x <<" Before conversion: Point Y "<< pt.y);
 
-    PJ_COORD c {{prev_pt.x + pt.x, prev_pt.y + pt.y, 0, 0}}; // z is not currently used
-    PJ_COORD c_out;
-    c_out = proj_trans(target_to_map, PJ_FWD, c);
-
-    gf_pts.push_back(lanelet::Point3d{current_map_->pointLayer.uniqueId(), c_out.xyz.x, c_out.xyz.y});
+    node_coords.push_back(PJ_COORD{{prev_pt.x + pt.x, prev_pt.y + pt.y, 0, 0}}); // z is not currently used
     prev_pt.x += pt.x;
     prev_pt.y += pt.y;
+  }
+
+  if (!node_coords.empty() && proj_trans_array(target_to_map, PJ_FWD, node_coords.size(), node_coords.data()) != 0)
+  {
+    ROS_ERROR_STREAM("Failed to project geofence nodes into the map frame with error number: " << proj_context_errno(PJ_DEFAULT_CTX));
+
+    return {}; // Ignore geofence if its nodes could not be projected into the map frame
+  }
+
+  gf_pts.reserve(node_coords.size());
+  for (const auto& c_out : node_coords)
+  {
+    gf_pts.push_back(lanelet::Point3d{current_map_->pointLayer.uniqueId(), c_out.xyz.x, c_out.xyz.y});
 
     ROS_DEBUG_STREAM("After conversion in Map frame: Point X "<< gf_pts.back().x() <<" After conversion: Point Y "<< gf_pts.back().y());
-   }
+  }
 
   tcm_marker_array_.markers.push_back(composeTCMMarkerVisualizer(gf_pts));
 
@@ -586,40 +668,17 @@ lanelet::ConstLaneletOrAreas WMBroadcaster::getAffectedLaneletOrAreas(const cav_
     ROS_DEBUG_STREAM("Index: " << idx << " Point: " << gf_pts[idx].x() << ", " << gf_pts[idx].y());
     std::unordered_set<lanelet::Lanelet> possible_lanelets;
 
-    // This loop identifes the lanelets which this point lies within that could be impacted by the geofence
-    // This loop somewhat inefficiently calls the findNearest method iteratively until all the possible lanelets are identified. 
-    // The reason findNearest is used instead of nearestUntil is because that method orders results by bounding box which
-    // can give invalid sequences when dealing with large curved lanelets.  
-    bool continue_search = true; 
-    size_t nearest_count = 0;
-    while (continue_search) {
-      
-      nearest_count += 10; // Increase the index search radius by 10 each loop until all nearby lanelets are found
-
-      for (const auto& ll_pair : lanelet::geometry::findNearest(current_map_->laneletLayer, gf_pts[idx].basicPoint2d(), nearest_count)) { // Get the nearest lanelets and iterate over them
-        auto ll = std::get<1>(ll_pair);
-
-        if (possible_lanelets.find(ll) != possible_lanelets.end()) { // Skip if already found
-          continue;
-        }
-
-        double dist = std::get<0>(ll_pair);
-        ROS_DEBUG_STREAM("Distance to lanelet " << ll.id() << ": " << dist << " max_lane_width: " << max_lane_width_);
-        
-        if (dist > max_lane_width_) { // Only save values closer than max_lane_width. Since we are iterating in distance order when we reach this distance the search can stop
-          continue_search = false;
-          break;
-        }
-
-        // Check if the point is inside this lanelet
-        if(dist == 0.0) { // boost geometry uses a distance of 0 to indicate a point is within a polygon
-          possible_lanelets.insert(ll);
-        }
-
-      }
+    // Identify the lanelets which this point lies within that could be impacted by the geofence
+    // Only the lanelets whose bounding box contains the point can contain it, so they are all found in a single index query
+    for (auto id : lanelet_index_.candidates(gf_pts[idx].basicPoint2d()))
+    {
+      const carma_wm::LaneletGeometry* geometry = lanelet_index_.geometry(id);
 
-      if (nearest_count >= current_map_->laneletLayer.size()) { // if we are out of lanelets to evaluate then end the search
-        continue_search = false;
+      // boost geometry uses a distance of 0 to indicate a point is within a polygon or on its edge
+      if (boost::geometry::distance(gf_pts[idx].basicPoint2d(), geometry->polygon) == 0.0)
+      {
+        ROS_DEBUG_STREAM("Point is within lanelet " << id);
+        possible_lanelets.insert(current_map_->laneletLayer.get(id));
       }
     }
 
@@ -648,7 +707,7 @@ lanelet::ConstLaneletOrAreas WMBroadcaster::getAffectedLaneletOrAreas(const cav_
         affected_lanelets.insert(llt);
       }
       // check condition if two geofence points are in one lanelet then check matching direction and record it also
-      else if (boost::geometry::within(gf_pts[idx+1].basicPoint2d(), llt.polygon2d()) && 
+      else if (boost::geometry::within(gf_pts[idx+1].basicPoint2d(), lanelet_index_.geometry(llt.id())->polygon) && 
               affected_lanelets.find(llt) == affected_lanelets.end())
       { 
         ROS_DEBUG_STREAM("Within new lanelet");
@@ -823,21 +882,28 @@ void WMBroadcaster::addGeofence(std::shared_ptr<Geofence> gf_ptr)
   std::lock_guard<std::mutex> guard(map_mutex_);
   ROS_INFO_STREAM("Adding active geofence to the map with geofence id: " << gf_ptr->id_);
   
+  recordBaseRegulatoryElements(gf_ptr);
+
   // Process the geofence object to populate update remove lists
   addGeofenceHelper(gf_ptr);
   
-  for (auto pair : gf_ptr->update_list_) active_geofence_llt_ids_.insert(pair.first);
+  for (auto pair : gf_ptr->update_list_)
+  {
+    active_geofence_llt_ids_.insert(pair.first);
+    route_geofence_index_.activate(pair.first);
+  }
+  active_geofence_info_.clear(); // Active geofence fields depend on the regulatory elements of neighboring lanelets as well
   
 
   // Publish
   autoware_lanelet2_msgs::MapBin gf_msg;
   auto send_data = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(gf_ptr->id_, gf_ptr->update_list_, gf_ptr->remove_list_));
-  carma_wm::toBinMsg(send_data, &gf_msg);
+  toMapUpdateMsg(send_data, &gf_msg);
   update_count_++; // Update the sequence count for the geofence messages
   gf_msg.header.seq = update_count_;
   gf_msg.invalidates_route=gf_ptr->invalidate_route_; 
   gf_msg.map_version = current_map_version_;
-  map_update_message_queue_.push_back(gf_msg); // Add diff to current map update queue
+  updates_invalidated_route_ = updates_invalidated_route_ || gf_ptr->invalidate_route_;
   map_update_pub_(gf_msg);
 };
 
@@ -846,20 +912,26 @@ void WMBroadcaster::removeGeofence(std::shared_ptr<Geofence> gf_ptr)
   std::lock_guard<std::mutex> guard(map_mutex_);
   ROS_INFO_STREAM("Removing inactive geofence from the map with geofence id: " << gf_ptr->id_);
   
+  recordBaseRegulatoryElements(gf_ptr);
+
   // Process the geofence object to populate update remove lists
   removeGeofenceHelper(gf_ptr);
 
-  for (auto pair : gf_ptr->remove_list_) active_geofence_llt_ids_.erase(pair.first);
+  for (auto pair : gf_ptr->remove_list_)
+  {
+    active_geofence_llt_ids_.erase(pair.first);
+    route_geofence_index_.deactivate(pair.first);
+  }
+  active_geofence_info_.clear();
 
   // publish
   autoware_lanelet2_msgs::MapBin gf_msg_revert;
   auto send_data = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(gf_ptr->id_, gf_ptr->update_list_, gf_ptr->remove_list_));
   
-  carma_wm::toBinMsg(send_data, &gf_msg_revert);
+  toMapUpdateMsg(send_data, &gf_msg_revert);
   update_count_++; // Update the sequence count for geofence messages
   gf_msg_revert.header.seq = update_count_;
   gf_msg_revert.map_version = current_map_version_;
-  map_update_message_queue_.push_back(gf_msg_revert); // Add diff to current map update queue
   map_update_pub_(gf_msg_revert);
 
 
@@ -899,7 +971,11 @@ cav_msgs::TrafficControlRequest WMBroadcaster::controlRequestFromRoute(const cav
   }
 
   // update local copy
-  route_path_ = path;
+  {
+    std::lock_guard<std::mutex> guard(map_mutex_);
+    route_path_ = path;
+    route_geofence_index_.setRoute(route_path_, active_geofence_llt_ids_);
+  }
   
   if(path.size() == 0) throw lanelet::InvalidObjectStateError(std::string("No lanelets available in path."));
 
@@ -1116,25 +1192,21 @@ double WMBroadcaster::distToNearestActiveGeofence(const lanelet::BasicPoint2d& c
     throw lanelet::InvalidObjectStateError(std::string("Lanelet map (current_map_) is not loaded to the WMBroadcaster"));
   }
 
-  // filter only the lanelets in the route
-  std::vector<lanelet::Id> active_geofence_on_route;
-  for (auto llt : route_path_)
-  {
-    if (active_geofence_llt_ids_.find(llt.id()) != active_geofence_llt_ids_.end()) 
-      active_geofence_on_route.push_back(llt.id());
-  }
-  
   // Get the lanelet of this point
-  auto curr_lanelet = lanelet::geometry::findNearest(current_map_->laneletLayer, curr_pos, 1)[0].second;
+  auto curr_lanelet = laneletContaining(curr_pos);
 
-  // Check if this point at least is actually within this lanelets
-  if (!boost::geometry::within(curr_pos, curr_lanelet.polygon2d().basicPolygon()))
+  if (!curr_lanelet)
     throw std::invalid_argument("Given point is not within any lanelet");
 
-  // get route distance (downtrack + cross_track) distances to every lanelets by their ids
+  return routeDistToActiveGeofence(curr_pos, curr_lanelet.get());
+}
+
+double WMBroadcaster::routeDistToActiveGeofence(const lanelet::BasicPoint2d& curr_pos, const lanelet::ConstLanelet& curr_lanelet) const
+{
+  // get route distance (downtrack + cross_track) distances to every active geofence lanelet on the route
   std::vector<double> route_distances;
   // and take abs of cross_track to add them to get route distance
-  for (auto id: active_geofence_on_route)
+  for (auto id: route_geofence_index_.activeLanelets())
   {
     carma_wm::TrackPos tp = carma_wm::geometry::trackPos(current_map_->laneletLayer.get(id), curr_pos);
     // downtrack needs to be negative for lanelet to be in front of the point, 
@@ -1149,8 +1221,26 @@ double WMBroadcaster::distToNearestActiveGeofence(const lanelet::BasicPoint2d& c
 
   if (route_distances.size() != 0 ) return route_distances[0];
   else return 0.0;
+}
+
+boost::optional<lanelet::ConstLanelet> WMBroadcaster::laneletContaining(const lanelet::BasicPoint2d& point) const
+{
+  boost::optional<lanelet::ConstLanelet> containing;
+  for (auto id : lanelet_index_.candidates(point))
+  {
+    if (!boost::geometry::within(point, lanelet_index_.geometry(id)->polygon))
+      continue;
+
+    // Where lanelets overlap the one on the route is the one the vehicle is travelling on
+    if (route_geofence_index_.onRoute(id))
+      return lanelet::ConstLanelet(current_map_->laneletLayer.get(id));
 
+    if (!containing)
+      containing = current_map_->laneletLayer.get(id);
+  }
+  return containing;
 }
+
 // helper function that detects the type of geofence and delegates
 void WMBroadcaster::addGeofenceHelper(std::shared_ptr<Geofence> gf_ptr) const
 {
@@ -1188,6 +1278,7 @@ void WMBroadcaster::currentLocationCallback(const geometry_msgs::PoseStamped& cu
 
 cav_msgs::CheckActiveGeofence WMBroadcaster::checkActiveGeofenceLogic(const geometry_msgs::PoseStamped& current_pos)
 {
+  std::lock_guard<std::mutex> guard(map_mutex_);
 
   if (!current_map_ || current_map_->laneletLayer.size() == 0) 
   {
@@ -1204,7 +1295,6 @@ cav_msgs::CheckActiveGeofence WMBroadcaster::checkActiveGeofenceLogic(const geom
   curr_pos.y() = current_pos_y;
 
   cav_msgs::CheckActiveGeofence outgoing_geof; //message to publish
-  double next_distance = 0 ; //Distance to next geofence
 
   if (active_geofence_llt_ids_.size() <= 0 ) 
   {
@@ -1212,121 +1302,132 @@ cav_msgs::CheckActiveGeofence WMBroadcaster::checkActiveGeofenceLogic(const geom
     return outgoing_geof;
   }
 
-  // Obtain the closest lanelet to the vehicle's current position
-  auto current_llt = lanelet::geometry::findNearest(current_map_->laneletLayer, curr_pos, 1)[0].second;
-  
+  // Obtain the lanelet containing the vehicle's current position
+  auto current_llt = laneletContaining(curr_pos);
+
   /* determine whether or not the vehicle's current position is within an active geofence */
-  if (boost::geometry::within(curr_pos, current_llt.polygon2d().basicPolygon()))
-  {         
-    next_distance = distToNearestActiveGeofence(curr_pos);
-    outgoing_geof.distance_to_next_geofence = next_distance;
+  if (current_llt)
+  {
+    // The geofence fields of a lanelet only change when a geofence activates or deactivates so they are cached until then
+    auto geofence_info = active_geofence_info_.find(current_llt->id());
+    if (geofence_info == active_geofence_info_.end())
+    {
+      geofence_info = active_geofence_info_.emplace(current_llt->id(), activeGeofenceInfo(current_llt.get())).first;
+    }
+    outgoing_geof = geofence_info->second;
+    outgoing_geof.distance_to_next_geofence = routeDistToActiveGeofence(curr_pos, current_llt.get());
+  }
+  return outgoing_geof;
+}
+
+cav_msgs::CheckActiveGeofence WMBroadcaster::activeGeofenceInfo(const lanelet::ConstLanelet& current_llt) const
+{
+  cav_msgs::CheckActiveGeofence outgoing_geof;
+
+  if (active_geofence_llt_ids_.find(current_llt.id()) == active_geofence_llt_ids_.end())
+  {
+    return outgoing_geof;
+  }
 
-    for(auto id : active_geofence_llt_ids_) 
+  ROS_DEBUG_STREAM("Vehicle is on Lanelet " << current_llt.id() << ", which has an active geofence");
+  outgoing_geof.is_on_active_geofence = true;
+  for (auto regem: current_llt.regulatoryElements())
+  {
+    // Assign active geofence fields based on the speed limit associated with this lanelet
+    if (regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::DigitalSpeedLimit::RuleName) == 0)
     {
-      if (id == current_llt.id())
-      {           
-        ROS_DEBUG_STREAM("Vehicle is on Lanelet " << current_llt.id() << ", which has an active geofence");
-        outgoing_geof.is_on_active_geofence = true;
-        for (auto regem: current_llt.regulatoryElements())
-        {
-          // Assign active geofence fields based on the speed limit associated with this lanelet
-          if (regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::DigitalSpeedLimit::RuleName) == 0)
-          {
-            lanelet::DigitalSpeedLimitPtr speed =  std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>
-            (current_map_->regulatoryElementLayer.get(regem->id()));
-            outgoing_geof.value = speed->speed_limit_.value();
-            outgoing_geof.advisory_speed = speed->speed_limit_.value(); 
-            ROS_DEBUG_STREAM("Active geofence has a speed limit of " << speed->speed_limit_.value());
-                    
-            // Cannot overrule outgoing_geof.type if it is already set to LANE_CLOSED
-            if(outgoing_geof.type != cav_msgs::CheckActiveGeofence::LANE_CLOSED)
-            {
-              outgoing_geof.type = cav_msgs::CheckActiveGeofence::SPEED_LIMIT;
-            }
-          }
+      lanelet::DigitalSpeedLimitPtr speed =  std::dynamic_pointer_cast<lanelet::DigitalSpeedLimit>
+      (current_map_->regulatoryElementLayer.get(regem->id()));
+      outgoing_geof.value = speed->speed_limit_.value();
+      outgoing_geof.advisory_speed = speed->speed_limit_.value(); 
+      ROS_DEBUG_STREAM("Active geofence has a speed limit of " << speed->speed_limit_.value());
+              
+      // Cannot overrule outgoing_geof.type if it is already set to LANE_CLOSED
+      if(outgoing_geof.type != cav_msgs::CheckActiveGeofence::LANE_CLOSED)
+      {
+        outgoing_geof.type = cav_msgs::CheckActiveGeofence::SPEED_LIMIT;
+      }
+    }
 
-          // Assign active geofence fields based on the minimum gap associated with this lanelet (if it exists)
-          if(regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::DigitalMinimumGap::RuleName) == 0)
-          {
-            lanelet::DigitalMinimumGapPtr min_gap =  std::dynamic_pointer_cast<lanelet::DigitalMinimumGap>
-            (current_map_->regulatoryElementLayer.get(regem->id()));
-            outgoing_geof.minimum_gap = min_gap->getMinimumGap();
-            ROS_DEBUG_STREAM("Active geofence has a minimum gap of " << min_gap->getMinimumGap());
-          }
-                 
-          // Assign active geofence fields based on whether the current lane is closed or is immediately adjacent to a closed lane
-          if(regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
-          {
-            lanelet::RegionAccessRulePtr accessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
-            (current_map_->regulatoryElementLayer.get(regem->id()));
+    // Assign active geofence fields based on the minimum gap associated with this lanelet (if it exists)
+    if(regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::DigitalMinimumGap::RuleName) == 0)
+    {
+      lanelet::DigitalMinimumGapPtr min_gap =  std::dynamic_pointer_cast<lanelet::DigitalMinimumGap>
+      (current_map_->regulatoryElementLayer.get(regem->id()));
+      outgoing_geof.minimum_gap = min_gap->getMinimumGap();
+      ROS_DEBUG_STREAM("Active geofence has a minimum gap of " << min_gap->getMinimumGap());
+    }
+           
+    // Assign active geofence fields based on whether the current lane is closed or is immediately adjacent to a closed lane
+    if(regem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
+    {
+      lanelet::RegionAccessRulePtr accessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
+      (current_map_->regulatoryElementLayer.get(regem->id()));
 
-            // Update the 'type' and 'reason' for this active geofence if the vehicle is in a closed lane
-            if(!accessRuleReg->accessable(lanelet::Participants::VehicleCar) || !accessRuleReg->accessable(lanelet::Participants::VehicleTruck)) 
-            {
-              ROS_DEBUG_STREAM("Active geofence is a closed lane.");
-              ROS_DEBUG_STREAM("Closed lane reason: " << accessRuleReg->getReason());
-              outgoing_geof.reason = accessRuleReg->getReason();
-              outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
-            }
-            // Otherwise, update the 'type' and 'reason' for this active geofence if the vehicle is in a lane immediately adjacent to a closed lane with the same travel direction
-            else 
-            {
-              // Obtain all same-direction lanes sharing the right lane boundary (will include the current lanelet)
-              auto right_boundary_lanelets = current_map_->laneletLayer.findUsages(current_llt.rightBound());
+      // Update the 'type' and 'reason' for this active geofence if the vehicle is in a closed lane
+      if(!accessRuleReg->accessable(lanelet::Participants::VehicleCar) || !accessRuleReg->accessable(lanelet::Participants::VehicleTruck)) 
+      {
+        ROS_DEBUG_STREAM("Active geofence is a closed lane.");
+        ROS_DEBUG_STREAM("Closed lane reason: " << accessRuleReg->getReason());
+        outgoing_geof.reason = accessRuleReg->getReason();
+        outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
+      }
+      // Otherwise, update the 'type' and 'reason' for this active geofence if the vehicle is in a lane immediately adjacent to a closed lane with the same travel direction
+      else 
+      {
+        // Obtain all same-direction lanes sharing the right lane boundary (will include the current lanelet)
+        auto right_boundary_lanelets = current_map_->laneletLayer.findUsages(current_llt.rightBound());
 
-              // Check if the adjacent right lane is closed
-              if(right_boundary_lanelets.size() > 1)
+        // Check if the adjacent right lane is closed
+        if(right_boundary_lanelets.size() > 1)
+        {
+          for(auto lanelet : right_boundary_lanelets)
+          {
+            // Only check the adjacent right lanelet; ignore the current lanelet
+            if(lanelet.id() != current_llt.id())
+            {
+              for (auto rightRegem: lanelet.regulatoryElements())
               {
-                for(auto lanelet : right_boundary_lanelets)
+                if(rightRegem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
                 {
-                  // Only check the adjacent right lanelet; ignore the current lanelet
-                  if(lanelet.id() != current_llt.id())
+                  lanelet::RegionAccessRulePtr rightAccessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
+                  (current_map_->regulatoryElementLayer.get(rightRegem->id()));
+                  if(!rightAccessRuleReg->accessable(lanelet::Participants::VehicleCar) || !rightAccessRuleReg->accessable(lanelet::Participants::VehicleTruck))
                   {
-                    for (auto rightRegem: lanelet.regulatoryElements())
-                    {
-                      if(rightRegem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
-                      {
-                        lanelet::RegionAccessRulePtr rightAccessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
-                        (current_map_->regulatoryElementLayer.get(rightRegem->id()));
-                        if(!rightAccessRuleReg->accessable(lanelet::Participants::VehicleCar) || !rightAccessRuleReg->accessable(lanelet::Participants::VehicleTruck))
-                        {
-                          ROS_DEBUG_STREAM("Right adjacent Lanelet " << lanelet.id() << " is CLOSED");
-                          ROS_DEBUG_STREAM("Assigning LANE_CLOSED type to active geofence");
-                          ROS_DEBUG_STREAM("Assigning reason " << rightAccessRuleReg->getReason());
-                          outgoing_geof.reason = rightAccessRuleReg->getReason();
-                          outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
-                        }
-                      }
-                    }
+                    ROS_DEBUG_STREAM("Right adjacent Lanelet " << lanelet.id() << " is CLOSED");
+                    ROS_DEBUG_STREAM("Assigning LANE_CLOSED type to active geofence");
+                    ROS_DEBUG_STREAM("Assigning reason " << rightAccessRuleReg->getReason());
+                    outgoing_geof.reason = rightAccessRuleReg->getReason();
+                    outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
                   }
                 }
               }
+            }
+          }
+        }
 
-              // Check if the adjacent left lane is closed
-              auto left_boundary_lanelets = current_map_->laneletLayer.findUsages(current_llt.leftBound());
-              if(left_boundary_lanelets.size() > 1)
+        // Check if the adjacent left lane is closed
+        auto left_boundary_lanelets = current_map_->laneletLayer.findUsages(current_llt.leftBound());
+        if(left_boundary_lanelets.size() > 1)
+        {
+          for(auto lanelet : left_boundary_lanelets)
+          {
+            // Only check the adjacent left lanelet; ignore the current lanelet
+            if(lanelet.id() != current_llt.id())
+            {
+              for (auto leftRegem: lanelet.regulatoryElements())
               {
-                for(auto lanelet : left_boundary_lanelets)
+                if(leftRegem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
                 {
-                  // Only check the adjacent left lanelet; ignore the current lanelet
-                  if(lanelet.id() != current_llt.id())
+                  lanelet::RegionAccessRulePtr leftAccessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
+                  (current_map_->regulatoryElementLayer.get(leftRegem->id()));
+                  if(!leftAccessRuleReg->accessable(lanelet::Participants::VehicleCar) || !leftAccessRuleReg->accessable(lanelet::Participants::VehicleTruck))
                   {
-                    for (auto leftRegem: lanelet.regulatoryElements())
-                    {
-                      if(leftRegem->attribute(lanelet::AttributeName::Subtype).value().compare(lanelet::RegionAccessRule::RuleName) == 0)
-                      {
-                        lanelet::RegionAccessRulePtr leftAccessRuleReg =  std::dynamic_pointer_cast<lanelet::RegionAccessRule>
-                        (current_map_->regulatoryElementLayer.get(leftRegem->id()));
-                        if(!leftAccessRuleReg->accessable(lanelet::Participants::VehicleCar) || !leftAccessRuleReg->accessable(lanelet::Participants::VehicleTruck))
-                        {
-                          ROS_DEBUG_STREAM("Left adjacent Lanelet " << lanelet.id() << " is CLOSED");
-                          ROS_DEBUG_STREAM("Assigning LANE_CLOSED type to active geofence");
-                          ROS_DEBUG_STREAM("Assigning reason " << leftAccessRuleReg->getReason());
-                          outgoing_geof.reason = leftAccessRuleReg->getReason();
-                          outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
-                        }
-                      }
-                    }
+                    ROS_DEBUG_STREAM("Left adjacent Lanelet " << lanelet.id() << " is CLOSED");
+                    ROS_DEBUG_STREAM("Assigning LANE_CLOSED type to active geofence");
+                    ROS_DEBUG_STREAM("Assigning reason " << leftAccessRuleReg->getReason());
+                    outgoing_geof.reason = leftAccessRuleReg->getReason();
+                    outgoing_geof.type = cav_msgs::CheckActiveGeofence::LANE_CLOSED;
                   }
                 }
               }
@@ -1339,10 +1440,70 @@ cav_msgs::CheckActiveGeofence WMBroadcaster::checkActiveGeofenceLogic(const geom
   return outgoing_geof;
 }
 
+void WMBroadcaster::recordBaseRegulatoryElements(std::shared_ptr<Geofence> gf_ptr)
+{
+  for (const auto& el : gf_ptr->affected_parts_)
+  {
+    if (base_lanelet_regems_.find(el.id()) != base_lanelet_regems_.end())
+      continue;
+
+    auto llt = current_map_->laneletLayer.find(el.id());
+    if (llt != current_map_->laneletLayer.end())
+      base_lanelet_regems_.emplace(el.id(), llt->regulatoryElements());
+  }
+}
+
+boost::optional<autoware_lanelet2_msgs::MapBin> WMBroadcaster::consolidatedMapUpdate() const
+{
+  std::lock_guard<std::mutex> guard(map_mutex_);
+
+  auto contains_regem = [](const lanelet::RegulatoryElementPtrs& regems, lanelet::Id id) {
+    return std::any_of(regems.begin(), regems.end(), [id](const auto& regem) { return regem->id() == id; });
+  };
+
+  // The net effect of every update is the difference between the current and base regulatory elements of each lanelet
+  // which was updated. Geofences which were added and then removed cancel out and superseded changes collapse.
+  std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> update_list;
+  std::vector<std::pair<lanelet::Id, lanelet::RegulatoryElementPtr>> remove_list;
+  for (const auto& base : base_lanelet_regems_)
+  {
+    auto current_regems = current_map_->laneletLayer.get(base.first).regulatoryElements();
+
+    for (const auto& regem : base.second)
+    {
+      if (!contains_regem(current_regems, regem->id()))
+        remove_list.emplace_back(base.first, regem);
+    }
+
+    for (const auto& regem : current_regems)
+    {
+      if (!contains_regem(base.second, regem->id()))
+        update_list.emplace_back(base.first, regem);
+    }
+  }
+
+  // An empty update is still sent once any lanelet was updated, so subscribers which applied some of those updates
+  // reset the lanelets to the base map
+  if (base_lanelet_regems_.empty())
+  {
+    return boost::none;
+  }
+
+  // The nil id marks the update as consolidated so subscribers reset the updated lanelets before applying it. See carma_wm::TrafficControl::isConsolidated()
+  autoware_lanelet2_msgs::MapBin update_msg;
+  auto send_data = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl(boost::uuids::nil_uuid(), update_list, remove_list));
+  toMapUpdateMsg(send_data, &update_msg);
+  update_msg.header.seq = update_count_; // Any update published after this one will have a larger sequence number
+  update_msg.invalidates_route = updates_invalidated_route_;
+  update_msg.map_version = current_map_version_;
+  return update_msg;
+}
+
 void WMBroadcaster::newUpdateSubscriber(const ros::SingleSubscriberPublisher& single_sub_pub) const {
 
-  for (const auto& msg : map_update_message_queue_) {
-    single_sub_pub.publish(msg); // For each applied update for the current map version publish the update to the new subscriber
+  auto update_msg = consolidatedMapUpdate();
+  if (update_msg) {
+    single_sub_pub.publish(update_msg.get()); // Publish the net effect of all updates applied to the current map version as a single update
   }
 }
 
@@ -85,6 +85,16 @@ int WMBroadcasterNode::run()
   pnh2_.getParam("/config_speed_limit", config_limit);
   wmb_.setConfigSpeedLimit(config_limit);
 
+  bool compact_map_updates = false;
+  bool compress_map_updates = false;
+  pnh_.getParam("compact_map_updates", compact_map_updates);
+  pnh_.getParam("compress_map_updates", compress_map_updates);
+  wmb_.setCompactMapUpdates(compact_map_updates, compress_map_updates);
+
+  bool flat_binary_map = false;
+  pnh_.getParam("flat_binary_map", flat_binary_map);
+  wmb_.setFlatBinaryMap(flat_binary_map);
+
   
     timer = cnh_.createTimer(ros::Duration(10.0), [this](auto){
       tcm_visualizer_pub_.publish(wmb_.tcm_marker_array_);
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2021 LEIDOS.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+
+#include <gmock/gmock.h>
+#include <carma_wm/WMTestLibForGuidance.h>
+#include <carma_wm_ctrl/RouteGeofenceIndex.h>
+
+namespace carma_wm_ctrl
+{
+TEST(RouteGeofenceIndex, distToNextActive)
+{
+  // Lanes of 3 lanelets which are 3.7 m wide and 25 m long
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+  lanelet::ConstLanelets route = { map->laneletLayer.get(1200), map->laneletLayer.get(1201),
+                                   map->laneletLayer.get(1202) };
+
+  RouteGeofenceIndex index;
+  ASSERT_FALSE(index.onRoute(1200));
+  ASSERT_THROW(index.routeDowntrack(route[0], lanelet::BasicPoint2d(1.85, 10)), std::invalid_argument);
+  ASSERT_NEAR(0.0, index.distToNextActive(10), 0.0001);
+
+  // Active lanelets which are not on the route are ignored
+  index.setRoute(route, { 1202, 1212 });
+  ASSERT_TRUE(index.onRoute(1201));
+  ASSERT_FALSE(index.onRoute(1211));
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1202 }), index.activeLanelets());
+
+  ASSERT_NEAR(10.0, index.routeDowntrack(route[0], lanelet::BasicPoint2d(1.85, 10)), 0.0001);
+  ASSERT_NEAR(35.0, index.routeDowntrack(route[1], lanelet::BasicPoint2d(1.85, 35)), 0.0001);
+
+  ASSERT_NEAR(40.0, index.distToNextActive(10), 0.0001);
+  ASSERT_NEAR(15.0, index.distToNextActive(35), 0.0001);
+  ASSERT_NEAR(0.0, index.distToNextActive(60, 1202), 0.0001);  // On the active lanelet with nothing ahead
+
+  index.activate(1201);
+  index.activate(1211);  // Not on route
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1201, 1202 }), index.activeLanelets());
+  ASSERT_NEAR(15.0, index.distToNextActive(10), 0.0001);
+  ASSERT_NEAR(15.0, index.distToNextActive(35, 1201), 0.0001);  // The current lanelet is skipped
+
+  index.deactivate(1202);
+  ASSERT_EQ(std::vector<lanelet::Id>({ 1201 }), index.activeLanelets());
+  ASSERT_NEAR(0.0, index.distToNextActive(35, 1201), 0.0001);
+
+  index.clear();
+  ASSERT_FALSE(index.onRoute(1200));
+  ASSERT_TRUE(index.activeLanelets().empty());
+}
+TEST(RouteGeofenceIndex, laneChange)
+{
+  // Two adjacent lanes of 3 lanelets which are 3.7 m wide and 25 m long. The route changes lanes in its first lanelet
+  auto map = carma_wm::test::buildGuidanceTestMap(3.7, 25);
+  lanelet::ConstLanelets route = { map->laneletLayer.get(1200), map->laneletLayer.get(1210),
+                                   map->laneletLayer.get(1211), map->laneletLayer.get(1212) };
+
+  RouteGeofenceIndex index;
+  index.setRoute(route, { 1212 });
+
+  // The lanelet changed into covers the same downtrack as the lanelet changed from
+  ASSERT_NEAR(10.0, index.routeDowntrack(route[0], lanelet::BasicPoint2d(1.85, 10)), 0.0001);
+  ASSERT_NEAR(10.0, index.routeDowntrack(route[1], lanelet::BasicPoint2d(5.55, 10)), 0.0001);
+  ASSERT_NEAR(30.0, index.routeDowntrack(route[2], lanelet::BasicPoint2d(5.55, 30)), 0.0001);
+
+  // The geofence past the lane change starts 50 m along the route
+  ASSERT_NEAR(40.0, index.distToNextActive(10, 1200), 0.0001);
+  ASSERT_NEAR(20.0, index.distToNextActive(30, 1211), 0.0001);
+}
+}  // namespace carma_wm_ctrl
@@ -19,6 +19,7 @@
 #include <carma_wm_ctrl/GeofenceSchedule.h>
 #include <carma_wm_ctrl/Geofence.h>
 #include <carma_wm/TrafficControl.h>
+#include <carma_wm/FlatBinaryMap.h>
 #include <lanelet2_io/Io.h>
 #include <lanelet2_io/io_handlers/Factory.h>
 #include <lanelet2_io/io_handlers/Writer.h>
@@ -97,6 +98,40 @@ TEST(WMBroadcaster, baseMapCallback)
   ASSERT_EQ(1, base_map_call_count);
 }
 
+TEST(WMBroadcaster, baseMapCallbackFlatBinaryMap)
+{
+  ros::Time::setNow(ros::Time(0));  // Set current time
+
+  size_t base_map_call_count = 0;
+  WMBroadcaster wmb(
+      [&](const autoware_lanelet2_msgs::MapBin& map_bin) {
+        // Publish map callback
+        ASSERT_TRUE(carma_wm::isFlatBinMsg(map_bin));
+        lanelet::LaneletMapPtr map = carma_wm::mapFromBinMsg(map_bin);
+
+        ASSERT_EQ(4, map->laneletLayer.size());  // Verify the map can be decoded
+        ASSERT_EQ(1, map_bin.map_version);
+
+        base_map_call_count++;
+      }, [](const autoware_lanelet2_msgs::MapBin& map_bin) {}, [](const cav_msgs::TrafficControlRequest& control_msg_pub_){},
+      [](const cav_msgs::CheckActiveGeofence& active_pub_){},
+      std::make_unique<TestTimerFactory>());
+
+  wmb.setFlatBinaryMap(true);
+
+  // The base map is accepted in the flat binary map format as well
+  auto map = carma_wm::getDisjointRouteMap();
+
+  autoware_lanelet2_msgs::MapBin msg;
+  carma_wm::toFlatBinMsg(*map, &msg);
+
+  autoware_lanelet2_msgs::MapBinConstPtr map_msg_ptr(new autoware_lanelet2_msgs::MapBin(msg));
+
+  wmb.baseMapCallback(map_msg_ptr);
+
+  ASSERT_EQ(1, base_map_call_count);
+}
+
 // here test the proj string transform test
 TEST(WMBroadcaster, getAffectedLaneletOrAreasFromTransform)
 {
@@ -581,6 +616,89 @@ TEST(WMBroadcaster, addAndRemoveGeofence)
 
 }
 
+TEST(WMBroadcaster, consolidatedMapUpdate)
+{
+  using namespace lanelet::units::literals;
+  // Set the environment  
+  WMBroadcaster wmb(
+      [](const autoware_lanelet2_msgs::MapBin& map_bin) {}, [](const autoware_lanelet2_msgs::MapBin& map_bin) {},
+      [](const cav_msgs::TrafficControlRequest& control_msg_pub_){}, [](const cav_msgs::CheckActiveGeofence& active_pub_){},
+      std::make_unique<TestTimerFactory>());
+
+  auto map = carma_wm::getBroadcasterTestMap();
+  lanelet::DigitalSpeedLimitPtr old_speed_limit = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(lanelet::InvalId, 5_mph, {}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  map->update(map->laneletLayer.get(10000), old_speed_limit); // added a speed limit to first llt
+
+  autoware_lanelet2_msgs::MapBin msg;
+  lanelet::utils::conversion::toBinMsg(map, &msg);
+  autoware_lanelet2_msgs::MapBinConstPtr map_msg_ptr(new autoware_lanelet2_msgs::MapBin(msg));
+  wmb.baseMapCallback(map_msg_ptr);
+  std_msgs::String sample_proj_string;
+  std::string proj_string = "+proj=tmerc +lat_0=39.46636844371259 +lon_0=-76.16919523566943 +k=1 +x_0=0 +y_0=0 +datum=WGS84 +units=m +vunits=m +no_defs";
+  sample_proj_string.data = proj_string;
+  wmb.geoReferenceCallback(sample_proj_string);
+
+  // No updates have been applied yet
+  ASSERT_FALSE(!!wmb.consolidatedMapUpdate());
+
+  // Create the geofence object
+  auto gf_ptr = std::make_shared<carma_wm_ctrl::Geofence>(carma_wm_ctrl::Geofence());
+  gf_ptr->id_ = boost::uuids::random_generator()();
+  lanelet::DigitalSpeedLimitPtr new_speed_limit = std::make_shared<lanelet::DigitalSpeedLimit>(lanelet::DigitalSpeedLimit::buildData(map->regulatoryElementLayer.uniqueId(), 10_mph, {}, {},
+                                                     { lanelet::Participants::VehicleCar }));
+  gf_ptr->regulatory_element_ = new_speed_limit;
+  cav_msgs::TrafficControlMessageV01 gf_msg;
+  gf_msg.geometry.proj = proj_string;
+  cav_msgs::PathNode pt;
+  pt.x = 0.5; pt.y = 0.5; pt.z = 0;
+  gf_msg.geometry.nodes.push_back(pt);
+  pt.x = 0.5; pt.y = 1.5; pt.z = 0;
+  gf_msg.geometry.nodes.push_back(pt);
+  gf_ptr->affected_parts_ = wmb.getAffectedLaneletOrAreas(gf_msg);
+  ASSERT_EQ(gf_ptr->affected_parts_.size(), 2);
+
+  // A single update has the same content as the consolidated update
+  wmb.addGeofence(gf_ptr);
+  auto update_msg = wmb.consolidatedMapUpdate();
+  ASSERT_TRUE(!!update_msg);
+  ASSERT_EQ(update_msg->header.seq, 1);
+
+  auto update = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(update_msg.get(), update);
+  ASSERT_TRUE(update->isConsolidated());
+  ASSERT_EQ(update->remove_list_.size(), gf_ptr->remove_list_.size());
+  ASSERT_EQ(update->update_list_.size(), gf_ptr->update_list_.size());
+  for (const auto& pair : update->update_list_)
+  {
+    ASSERT_EQ(pair.second->id(), new_speed_limit->id());
+  }
+  ASSERT_TRUE(std::any_of(update->remove_list_.begin(), update->remove_list_.end(),
+                          [&](const auto& pair) { return pair.first == 10000 && pair.second->id() == old_speed_limit->id(); }));
+
+  // Removing the geofence cancels out its addition. The update is still sent so subscribers which applied the
+  // addition reset the lanelets to the base map
+  wmb.removeGeofence(gf_ptr);
+  update_msg = wmb.consolidatedMapUpdate();
+  ASSERT_TRUE(!!update_msg);
+  ASSERT_EQ(update_msg->header.seq, 2);
+  update = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(update_msg.get(), update);
+  ASSERT_TRUE(update->isConsolidated());
+  ASSERT_TRUE(update->remove_list_.empty());
+  ASSERT_TRUE(update->update_list_.empty());
+
+  // Adding it again is equivalent to adding it once
+  wmb.addGeofence(gf_ptr);
+  update_msg = wmb.consolidatedMapUpdate();
+  ASSERT_TRUE(!!update_msg);
+  ASSERT_EQ(update_msg->header.seq, 3);
+  update = std::make_shared<carma_wm::TrafficControl>(carma_wm::TrafficControl());
+  carma_wm::fromBinMsg(update_msg.get(), update);
+  ASSERT_EQ(update->remove_list_.size(), 2);
+  ASSERT_EQ(update->update_list_.size(), 2);
+}
+
 TEST(WMBroadcaster, GeofenceBinMsgTest)
 {
   using namespace lanelet::units::literals;
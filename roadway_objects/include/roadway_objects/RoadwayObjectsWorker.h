@@ -23,6 +23,7 @@
 #include <cav_msgs/RoadwayObstacleList.h>
 #include <cav_msgs/RoadwayObstacle.h>
 #include <functional>
+#include <unordered_map>
 
 namespace objects
 {
@@ -33,8 +34,13 @@ public:
 
   /*!
    * \brief Constructor
+   *
+   * \param wm The world model used to convert objects
+   * \param obj_pub Callback used to publish the converted objects
+   * \param conversion_threads The number of threads each object list is converted with
    */
-  RoadwayObjectsWorker(carma_wm::WorldModelConstPtr wm, PublishObstaclesCallback obj_pub);
+  RoadwayObjectsWorker(carma_wm::WorldModelConstPtr wm, PublishObstaclesCallback obj_pub,
+                       unsigned int conversion_threads = 1);
 
   /*!
     \brief Converts the provided ExternalObjectList in a RoadwayObstacleList and republishes it
@@ -43,12 +49,23 @@ public:
   */
   void externalObjectsCallback(const cav_msgs::ExternalObjectListConstPtr& msg);
 
+  /*!
+    \brief Returns the lanelet id each object of the last converted list was associated with, keyed by object id.
+    These are used as the starting point when converting the next list.
+  */
+  const std::unordered_map<uint32_t, lanelet::Id>& getObjectLanelets() const;
+
 private:
   // local copy of external object publihsers
 
   PublishObstaclesCallback obj_pub_;
 
   carma_wm::WorldModelConstPtr wm_;
+
+  unsigned int conversion_threads_ = 1;
+
+  // Lanelet of each on road object in the last list keyed by object id. Objects missing from a list are evicted
+  std::unordered_map<uint32_t, lanelet::Id> object_lanelets_;
 };
 
 }  // namespace objects
@@ -14,13 +14,26 @@
  * the License.
  */
 #include "roadway_objects/RoadwayObjectsNode.h"
+#include <algorithm>
 
 namespace objects
 {
 using std::placeholders::_1;
 
+namespace
+{
+// Number of threads used to convert each external object list. Loaded before the worker is constructed
+unsigned int loadConversionThreads()
+{
+  int conversion_threads = 1;
+  ros::NodeHandle("~").param<int>("conversion_threads", conversion_threads, 1);
+  return static_cast<unsigned int>(std::max(1, conversion_threads));
+}
+}  // namespace
+
 RoadwayObjectsNode::RoadwayObjectsNode()
-  : object_worker_(wm_listener_.getWorldModel(), std::bind(&RoadwayObjectsNode::publishObstacles, this, _1))
+  : object_worker_(wm_listener_.getWorldModel(), std::bind(&RoadwayObjectsNode::publishObstacles, this, _1),
+                   loadConversionThreads())
 {
   external_objects_sub_ =
       nh_.subscribe("external_objects", 10, &RoadwayObjectsWorker::externalObjectsCallback, &object_worker_);
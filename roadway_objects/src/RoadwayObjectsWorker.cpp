@@ -21,11 +21,13 @@
 #include <boost/geometry/geometries/polygon.hpp>
 #include <tf2/LinearMath/Transform.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <algorithm>
 
 namespace objects
 {
-RoadwayObjectsWorker::RoadwayObjectsWorker(carma_wm::WorldModelConstPtr wm, PublishObstaclesCallback obj_pub)
-  : obj_pub_(obj_pub), wm_(wm)
+RoadwayObjectsWorker::RoadwayObjectsWorker(carma_wm::WorldModelConstPtr wm, PublishObstaclesCallback obj_pub,
+                                           unsigned int conversion_threads)
+  : obj_pub_(obj_pub), wm_(wm), conversion_threads_(std::max(1u, conversion_threads))
 {
 }
 
@@ -45,18 +47,38 @@ void RoadwayObjectsWorker::externalObjectsCallback(const cav_msgs::ExternalObjec
     return;
   }
 
-  for (auto object : obj_array->objects)
+  // Tracked objects keep their id between lists so the lanelet from the previous list is checked first
+  std::vector<lanelet::Id> lanelet_hints;
+  lanelet_hints.reserve(obj_array->objects.size());
+  for (const auto& object : obj_array->objects)
   {
-    lanelet::Optional<cav_msgs::RoadwayObstacle> obs = wm_->toRoadwayObstacle(object);
-    if (!obs)
+    auto previous = object_lanelets_.find(object.id);
+    lanelet_hints.push_back(previous == object_lanelets_.end() ? lanelet::InvalId : previous->second);
+  }
+
+  auto obstacles = wm_->toRoadwayObstacles(obj_array->objects, lanelet_hints, conversion_threads_);
+
+  // Objects which are not in this list or are off the road are evicted
+  object_lanelets_.clear();
+  obstacle_list.roadway_obstacles.reserve(obstacles.size());
+  for (size_t i = 0; i < obstacles.size(); i++)
+  {
+    if (!obstacles[i])
     {
-      ROS_DEBUG_STREAM("roadway_objects dropping detected object with id: " << object.id << " as it is off the road.");
+      ROS_DEBUG_STREAM("roadway_objects dropping detected object with id: " << obj_array->objects[i].id
+                                                                           << " as it is off the road.");
       continue;
     }
 
-    obstacle_list.roadway_obstacles.emplace_back(obs.get());
+    object_lanelets_[obj_array->objects[i].id] = obstacles[i].get().lanelet_id;
+    obstacle_list.roadway_obstacles.emplace_back(std::move(obstacles[i].get()));
   }
 
   obj_pub_(obstacle_list);
 }
+
+const std::unordered_map<uint32_t, lanelet::Id>& RoadwayObjectsWorker::getObjectLanelets() const
+{
+  return object_lanelets_;
+}
 }  // namespace objects
@@ -135,4 +135,68 @@ TEST(RoadwayObjectsWorkerTest, testExternalObjectCallback)
   ASSERT_NEAR(obs.predicted_down_track_confidences[0], 0.9, 0.00001);
 }
 
+TEST(RoadwayObjectsWorkerTest, testObjectLaneletCache)
+{
+  std::shared_ptr<carma_wm::CARMAWorldModel> cmw = std::make_shared<carma_wm::CARMAWorldModel>();
+
+  // Two lanelets one after the other
+  auto p1 = carma_wm::getPoint(9, 0, 0);
+  auto p2 = carma_wm::getPoint(9, 9, 0);
+  auto p3 = carma_wm::getPoint(2, 0, 0);
+  auto p4 = carma_wm::getPoint(2, 9, 0);
+  auto p5 = carma_wm::getPoint(9, 18, 0);
+  auto p6 = carma_wm::getPoint(2, 18, 0);
+  lanelet::LineString3d right_ls_1(lanelet::utils::getId(), { p1, p2 });
+  lanelet::LineString3d left_ls_1(lanelet::utils::getId(), { p3, p4 });
+  lanelet::LineString3d right_ls_2(lanelet::utils::getId(), { p2, p5 });
+  lanelet::LineString3d left_ls_2(lanelet::utils::getId(), { p4, p6 });
+  auto ll_1 = carma_wm::getLanelet(left_ls_1, right_ls_1);
+  auto ll_2 = carma_wm::getLanelet(left_ls_2, right_ls_2);
+  cmw->setMap(lanelet::utils::createMap({ ll_1, ll_2 }, {}));
+
+  cav_msgs::ExternalObject obj;
+  obj.id = 1;
+  obj.object_type = cav_msgs::ExternalObject::SMALL_VEHICLE;
+  obj.pose.pose.position.x = 6;
+  obj.pose.pose.position.y = 5;
+  obj.pose.pose.orientation.w = 1.0;
+  obj.size.x = 4;
+  obj.size.y = 2;
+  obj.size.z = 1;
+
+  cav_msgs::ExternalObject off_road = obj;
+  off_road.id = 2;
+  off_road.pose.pose.position.x = 50;
+
+  cav_msgs::RoadwayObstacleList resulting_objs;
+  RoadwayObjectsWorker row(std::static_pointer_cast<const carma_wm::WorldModel>(cmw),
+                           [&](const cav_msgs::RoadwayObstacleList& objs) -> void { resulting_objs = objs; }, 2);
+  ASSERT_TRUE(row.getObjectLanelets().empty());
+
+  cav_msgs::ExternalObjectList obj_list;
+  obj_list.objects = { obj, off_road };
+  row.externalObjectsCallback(cav_msgs::ExternalObjectListConstPtr(new cav_msgs::ExternalObjectList(obj_list)));
+
+  ASSERT_EQ(resulting_objs.roadway_obstacles.size(), 1);
+  ASSERT_EQ(resulting_objs.roadway_obstacles[0].lanelet_id, ll_1.id());
+  ASSERT_EQ(row.getObjectLanelets().size(), 1);  // Off road objects are not cached
+  ASSERT_EQ(row.getObjectLanelets().at(1), ll_1.id());
+
+  // The object moves onto the next lanelet
+  obj_list.objects[0].pose.pose.position.y = 14;
+  row.externalObjectsCallback(cav_msgs::ExternalObjectListConstPtr(new cav_msgs::ExternalObjectList(obj_list)));
+
+  ASSERT_EQ(resulting_objs.roadway_obstacles.size(), 1);
+  ASSERT_EQ(resulting_objs.roadway_obstacles[0].lanelet_id, ll_2.id());
+  ASSERT_NEAR(resulting_objs.roadway_obstacles[0].down_track, 5.0, 0.00001);
+  ASSERT_EQ(row.getObjectLanelets().at(1), ll_2.id());
+
+  // Objects which are no longer detected are evicted
+  obj_list.objects = { off_road };
+  row.externalObjectsCallback(cav_msgs::ExternalObjectListConstPtr(new cav_msgs::ExternalObjectList(obj_list)));
+
+  ASSERT_EQ(resulting_objs.roadway_obstacles.size(), 0);
+  ASSERT_TRUE(row.getObjectLanelets().empty());
+}
+
 }  // namespace objects
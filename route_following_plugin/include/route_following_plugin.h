@@ -153,6 +153,13 @@ namespace route_following_plugin
          */
         double findSpeedLimit(const lanelet::ConstLanelet& llt);
 
+        /**
+         * \brief Given a route Lanelet, find the route downtrack of the end of its centerline
+         * \param llt Constant Lanelet object
+         * \return route downtrack in meters
+         */
+        double laneletEndDowntrack(const lanelet::ConstLanelet& llt);
+
         /**
          * \brief Calculate maneuver plan for remaining route. This callback is triggered when a new route has been received and processed by the world model
          * \param route_shortest_path A list of lanelets along the shortest path of the route using which the maneuver plan is calculated.
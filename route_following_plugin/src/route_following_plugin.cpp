@@ -109,11 +109,11 @@ namespace route_following_plugin
             double target_speed_in_lanelet = findSpeedLimit(route_shortest_path[shortest_path_index]);
 
             //update start distance and start speed from previous maneuver if it exists
-            start_dist = (maneuvers.empty()) ? wm_->routeTrackPos(route_shortest_path[shortest_path_index].centerline2d().front()).downtrack : GET_MANEUVER_PROPERTY(maneuvers.back(), end_dist);
+            start_dist = (maneuvers.empty()) ? wm_->routeTrackPos(route_shortest_path[shortest_path_index]).downtrack : GET_MANEUVER_PROPERTY(maneuvers.back(), end_dist);
             start_speed = (maneuvers.empty()) ? 0.0 : GET_MANEUVER_PROPERTY(maneuvers.back(), end_speed);
             ROS_DEBUG_STREAM("start_dist:" << start_dist << ", start_speed:" << start_speed);
 
-            end_dist = wm_->routeTrackPos(route_shortest_path[shortest_path_index].centerline2d().back()).downtrack;
+            end_dist = laneletEndDowntrack(route_shortest_path[shortest_path_index]);
             ROS_DEBUG_STREAM("end_dist:" << end_dist);
             end_dist = std::min(end_dist, route_length);
             ROS_DEBUG_STREAM("min end_dist:" << end_dist);
@@ -150,8 +150,8 @@ namespace route_following_plugin
         if (shortest_path_index < route_shortest_path.size())
         {
             double target_speed_in_lanelet = findSpeedLimit(route_shortest_path.back());
-            start_dist = wm_->routeTrackPos(route_shortest_path.back().centerline2d().front()).downtrack;
-            end_dist = wm_->routeTrackPos(route_shortest_path.back().centerline2d().back()).downtrack;
+            start_dist = wm_->routeTrackPos(route_shortest_path.back()).downtrack;
+            end_dist = laneletEndDowntrack(route_shortest_path.back());
             maneuvers.push_back(composeLaneFollowingManeuverMessage(start_dist, end_dist, start_speed, target_speed_in_lanelet, route_shortest_path.back().id()));
         }
         ////------------------
@@ -447,14 +447,16 @@ namespace route_following_plugin
 
     double RouteFollowingPlugin::findSpeedLimit(const lanelet::ConstLanelet &llt)
     {
-        lanelet::Optional<carma_wm::TrafficRulesConstPtr> traffic_rules = wm_->getTrafficRules();
-        if (traffic_rules)
-        {
-            return (*traffic_rules)->speedLimit(llt).speedLimit.value();
-        }
-        else
+        return wm_->getSpeedLimit(llt);
+    }
+
+    double RouteFollowingPlugin::laneletEndDowntrack(const lanelet::ConstLanelet &llt)
+    {
+        auto track_pos = wm_->getRouteLaneletTrackPos(llt.id());
+        if (track_pos)
         {
-            throw std::invalid_argument("Valid traffic rules object could not be built");
+            return track_pos->second.downtrack;
         }
+        return wm_->routeTrackPos(llt.centerline2d().back()).downtrack;
     }
 }
\ No newline at end of file
@@ -240,11 +240,12 @@ namespace unobstructed_lanechange
         std::vector<lanelet::BasicPoint2d> future_geom_points;
         std::vector<double> final_actual_speeds;
         splitPointSpeedPairs(future_points, &future_geom_points, &final_actual_speeds);
-        std::vector<double> final_yaw_values = carma_wm::geometry::compute_tangent_orientations(future_geom_points);
+        // Compute yaw values and points to local downtracks in a single pass
+        std::vector<double> final_yaw_values(future_geom_points.size());
+        std::vector<double> downtracks(future_geom_points.size());
+        carma_wm::geometry::compute_centerline_geometry(carma_wm::geometry::makePointArrayView(future_geom_points),
+                                                        downtracks.data(), final_yaw_values.data(), nullptr);
 
-    
-        // Compute points to local downtracks
-        std::vector<double> downtracks = carma_wm::geometry::compute_arc_lengths(future_geom_points);
         final_actual_speeds = smoothing::moving_average_filter(final_actual_speeds, speed_moving_average_window_size_);
 
         // Convert speeds to times